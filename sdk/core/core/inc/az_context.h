@@ -17,6 +17,7 @@
 
 #include <az_result.h>
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -24,6 +25,11 @@
 
 typedef struct az_context az_context;
 
+enum
+{
+  _az_CONTEXT_VALUE_CACHE_SIZE = 4, // Number of key/value pairs each node keeps at hand
+};
+
 /**
  * @brief An az_context value is a node in a tree that represents expiration times and key/value
  * pairs. The root node in the tree (ultimate parent) is az_context_app which is a context for the
@@ -37,6 +43,21 @@ struct az_context
     int64_t expiration; // Time when context expires
     void* key; // Pointers to the key & value (usually NULL)
     void* value;
+
+    // Soonest expiration of this node and its parents, computed when the node was created. It is
+    // only trusted while no context has been canceled since (see az_context_cancel).
+    int64_t effective_expiration;
+    uint32_t cancel_generation;
+
+    // The nearest key/value pairs from this node up, copied from the parent at creation since
+    // they never change. When value_cache_complete is false, more keys are further up the chain.
+    struct
+    {
+      void* key;
+      void* value;
+    } value_cache[_az_CONTEXT_VALUE_CACHE_SIZE];
+    int32_t value_cache_count;
+    bool value_cache_complete;
   } _internal;
 };
 
@@ -59,12 +80,7 @@ extern az_context az_context_app;
  * @param[in] expiration The time when this new child node should be canceled
  * @return The new child az_context node
  */
-AZ_NODISCARD AZ_INLINE az_context
-az_context_with_expiration(az_context const* parent, int64_t expiration)
-{
-  return (az_context){ ._internal = { .parent = ((parent != NULL) ? parent : &az_context_app),
-                                      .expiration = expiration } };
-}
+AZ_NODISCARD az_context az_context_with_expiration(az_context const* parent, int64_t expiration);
 
 /**
  * @brief az_context_with_value creates a new key/value az_context node that is a child of the
@@ -76,27 +92,22 @@ az_context_with_expiration(az_context const* parent, int64_t expiration)
  * @param[in] value A pointer to the value of this new az_context node
  * @return The new child az_context node
  */
-AZ_NODISCARD AZ_INLINE az_context
-az_context_with_value(az_context const* parent, void* key, void* value)
-{
-  return (az_context){ ._internal = { .parent = (parent != NULL) ? parent : &az_context_app,
-                                      .expiration = _az_CONTEXT_MAX_EXPIRATION,
-                                      .key = key,
-                                      .value = value } };
-}
+AZ_NODISCARD az_context az_context_with_value(az_context const* parent, void* key, void* value);
 
 /**
  * @brief az_context_cancel cancels the specified az_context node; this cancels all the child nodes
- * as well.
+ * as well. Operations waiting on any of these nodes (such as the delay before retrying a request)
+ * are woken up.
+ *
+ * @remarks Each node caches its expiration when it is created. Canceling any node, even an
+ * unrelated one, makes every node created before it look its expiration up through its parents
+ * from then on, which costs a little more. To give a request a deadline, prefer
+ * az_context_with_expiration to canceling it later.
  *
  * @param[in] context A pointer to the az_context node to be canceled; passing NULL cancels the root
  * az_context_app.
  */
-AZ_INLINE void az_context_cancel(az_context* context)
-{
-  context = ((context != NULL) ? context : &az_context_app);
-  context->_internal.expiration = 0; // The beginning of time
-}
+void az_context_cancel(az_context* context);
 
 /**
  * @brief az_context_get_expiration returns the soonest expiration time of this az_context node or
@@ -105,6 +105,58 @@ typedef enum
   AZ_HTTP_STATUS_CODE_NETWORK_AUTHENTICATION_REQUIRED = 511,
 } az_http_status_code;
 
+/**
+ * @brief How the delay before a retry is randomized, so that clients that failed at the same time
+ * don't all retry at the same time.
+ */
+typedef enum
+{
+  /// The exponential delay, as is.
+  AZ_HTTP_POLICY_RETRY_JITTER_NONE = 0,
+  /// A random delay between 0 and the exponential delay.
+  AZ_HTTP_POLICY_RETRY_JITTER_FULL = 1,
+  /// A random delay between the base delay and three times the previous delay, up to the maximum.
+  AZ_HTTP_POLICY_RETRY_JITTER_DECORRELATED = 2,
+} az_http_policy_retry_jitter;
+
+/**
+ * @brief An az_http_policy_retry_budget limits retries to a share of the requests that succeed,
+ * so a failing service does not get retried into the ground. Share one instance between every
+ * client of the process that calls the same service.
+ *
+ * @remarks The budget is a token bucket. Every request that does not need a retry deposits
+ * `retry_percent` hundredths of a token, every retry withdraws a whole token, and retries stop
+ * while less than a token is left. The bucket starts full, so a process can retry before it has
+ * had any success. Requests on any thread may share it: the balance is updated atomically, except
+ * with compilers that have no atomics, where concurrent requests may lose a deposit or a
+ * withdrawal.
+ */
+typedef struct
+{
+  struct
+  {
+    int32_t balance; // In hundredths of a token
+    int32_t max_balance;
+    int32_t retry_percent;
+  } _internal;
+} az_http_policy_retry_budget;
+
+/**
+ * @brief Initializes an #az_http_policy_retry_budget.
+ *
+ * @param[out] out_budget The budget to initialize.
+ * @param[in] retry_percent How many retries are allowed per hundred requests that succeed.
+ * @param[in] max_retries How many retries can be saved up, which is also how many are allowed
+ * before anything succeeds.
+ *
+ * @return
+ *   - *`AZ_OK`* success.
+ */
+AZ_NODISCARD az_result az_http_policy_retry_budget_init(
+    az_http_policy_retry_budget* out_budget,
+    int32_t retry_percent,
+    int32_t max_retries);
+
 /**
  * @brief An az_http_policy_retry_options instance allows you to customize the retry policy
  * used by an XxxClient type whenever it performs an I/O operation. Applications should
@@ -118,6 +170,8 @@ typedef struct
   int32_t retry_delay_msec;
   int32_t max_retry_delay_msec;
   az_http_status_code const* status_codes;
+  az_http_policy_retry_jitter jitter;
+  az_http_policy_retry_budget* budget; ///< Optional, NULL to retry regardless of other requests.
 } az_http_policy_retry_options;
 
 typedef enum
@@ -128,6 +182,23 @@ typedef enum
   _az_HTTP_RESPONSE_KIND_EOF = 3,
 } _az_http_response_kind;
 
+enum
+{
+  _az_HTTP_RESPONSE_INDEXED_HEADERS_MAX = 16, ///< Headers a response indexes as it is received.
+};
+
+/**
+ * @brief Location of a header within the buffer of an az_http_response.
+ */
+typedef struct
+{
+  int32_t name_offset;
+  int32_t name_length;
+  int32_t value_offset;
+  int32_t value_length;
+  uint32_t name_hash; // case-folded hash of the name
+} _az_http_response_header_location;
+
 /**
  * @brief az_http_response represents an HTTP response.
  *
@@ -148,7 +219,18 @@ typedef struct
       az_span remaining; // the remaining un-parsed portion of the original http_response.
       _az_http_response_kind next_kind;
       // After parsing an element, next_kind refers to the next expected element
+      int32_t next_header; // position in the index of the next header
     } parser;
+    // Built by az_http_response_write_span as the bytes arrive, so that the headers and the body
+    // can be found without parsing the response again each time it is read.
+    struct
+    {
+      int32_t scanned; // bytes of the response already scanned for line ends
+      int32_t line_start; // offset of the line being received
+      int32_t body_start; // offset of the body, 0 until the end of the headers is received
+      int32_t headers_count; // -1 if the headers can't be indexed (too many, or malformed)
+      _az_http_response_header_location headers[_az_HTTP_RESPONSE_INDEXED_HEADERS_MAX];
+    } index;
   } _internal;
 } az_http_response;
 
@@ -169,6 +251,13 @@ AZ_NODISCARD AZ_INLINE az_result az_http_response_init(az_http_response* respons
       .parser = {
         .remaining = AZ_SPAN_NULL,
         .next_kind = _az_HTTP_RESPONSE_KIND_STATUS_LINE,
+        .next_header = 0,
+      },
+      .index = {
+        .scanned = 0,
+        .line_start = 0,
+        .body_start = 0,
+        .headers_count = 0,
       },
     },
   };
@@ -234,6 +323,26 @@ az_http_response_get_next_header(az_http_response* response, az_pair* out_header
  */
 AZ_NODISCARD az_result az_http_response_get_body(az_http_response* response, az_span* out_body);
 
+/**
+ * @brief az_http_response_get_header_by_name returns the value of the first HTTP response header
+ * with the given name, ignoring casing.
+ *
+ * When the response was received through the transport, its headers were indexed as they arrived
+ * and the lookup does not parse them again. This function does not change which header
+ * az_http_response_get_next_header returns next.
+ *
+ * @param response A pointer to an az_http_response instance.
+ * @param name The name of the header to look for.
+ * @param out_value A pointer to an az_span to receive the value of the header.
+ * @return AZ_OK = The header was found<br>
+ * AZ_ERROR_ITEM_NOT_FOUND = The response has no header named \a name<br>
+ * Other value = Error while trying to read and parse the response
+ */
+AZ_NODISCARD az_result az_http_response_get_header_by_name(
+    az_http_response const* response,
+    az_span name,
+    az_span* out_value);
+
 #include <_az_cfg_suffix.h>
 
 #endif // _az_HTTP_H
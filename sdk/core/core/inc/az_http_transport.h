@@ -49,6 +49,14 @@ AZ_INLINE az_http_method az_http_method_patch() { return AZ_SPAN_FROM_STR("PATCH
  */
 typedef az_span _az_http_request_headers;
 
+enum
+{
+  // Number of slots of the header name index of an _az_http_request, a power of 2.
+  _az_HTTP_REQUEST_HEADER_INDEX_SIZE = 32,
+  // Only the first headers are indexed, so that the index is at most half full.
+  _az_HTTP_REQUEST_INDEXED_HEADERS_MAX = _az_HTTP_REQUEST_HEADER_INDEX_SIZE / 2,
+};
+
 /**
  * @brief _az_http_request is an internal structure used to perform an HTTP request.
  * It contains an HTTP method, url, headers and body. It also contains
@@ -67,7 +75,12 @@ typedef struct
     int32_t headers_length;
     int32_t max_headers;
     int32_t retry_headers_start_byte_offset;
+    // With a body_list, the buffer the list is copied to when a transport needs it in one piece.
     az_span body;
+    az_span_list const* body_list;
+    // Open-addressed index of the header names, keyed by their case-folded hash. Each slot holds
+    // the position of a header plus one, or 0 when it is empty.
+    uint8_t header_index[_az_HTTP_REQUEST_HEADER_INDEX_SIZE];
   } _internal;
 } _az_http_request;
 
@@ -84,6 +97,24 @@ typedef struct
 AZ_NODISCARD az_result
 az_http_request_get_header(_az_http_request const* request, int32_t index, az_pair* out_header);
 
+/**
+ * @brief Get the value of the first HTTP header of a request with the given name.
+ *
+ * @remarks Names are compared ignoring their casing. The lookup goes through an index of the
+ * header names, rather than comparing \p name against every header.
+ *
+ * @param request HTTP request to get HTTP header from.
+ * @param name Name of the HTTP header to get.
+ * @param out_value Pointer to write the value of the header to.
+ *
+ * @retval AZ_OK Success.
+ * @retval AZ_ERROR_ITEM_NOT_FOUND There is no header named \a name.
+ */
+AZ_NODISCARD az_result az_http_request_get_header_by_name(
+    _az_http_request const* request,
+    az_span name,
+    az_span* out_value);
+
 /**
  * @brief Get method of an HTTP request.
  *
@@ -121,9 +152,50 @@ AZ_NODISCARD az_result az_http_request_get_url(_az_http_request const* request,
  *
  * @retval An #az_result value indicating the result of the operation:
  *         - #AZ_OK if successful
+ *         - #AZ_ERROR_INSUFFICIENT_SPAN_SIZE if the body is made of more than one span, and the
+ * buffer given to #az_http_request_set_body_list is too small to copy them to. Use
+ * #az_http_request_get_body_span to read the body without copying it.
  */
 AZ_NODISCARD az_result az_http_request_get_body(_az_http_request const* request, az_span* out_body);
 
+/**
+ * @brief Get the number of spans making up the body of an HTTP request.
+ *
+ * @remarks This function is expected to be used by transport layer only. A body that was given as
+ * a single #az_span counts as one span, or none if it is empty.
+ *
+ * @param[in] request The HTTP request from which to get the body.
+ * @return The number of spans of the body.
+ */
+AZ_NODISCARD int32_t az_http_request_body_spans_count(_az_http_request const* request);
+
+/**
+ * @brief Get the total size of the body of an HTTP request.
+ *
+ * @remarks This function is expected to be used by transport layer only.
+ *
+ * @param[in] request The HTTP request from which to get the body size.
+ * @return The sum of the sizes of the spans of the body.
+ */
+AZ_NODISCARD int32_t az_http_request_body_size(_az_http_request const* request);
+
+/**
+ * @brief Get a span of the body of an HTTP request by index.
+ *
+ * @remarks This function is expected to be used by transport layer only. The body is made of the
+ * spans from index 0 to #az_http_request_body_spans_count - 1, in order.
+ *
+ * @param[in] request The HTTP request from which to get the body.
+ * @param[in] index Index of the span to get.
+ * @param[out] out_span Pointer to write the span to.
+ *
+ * @retval An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if successful
+ *         - #AZ_ERROR_ARG if \p index is out of range
+ */
+AZ_NODISCARD az_result
+az_http_request_get_body_span(_az_http_request const* request, int32_t index, az_span* out_span);
+
 /**
  * @brief This function is expected to be used by transport adapters like curl. Use it to write
  * content from \p source to \p response.
@@ -45,6 +45,18 @@ typedef enum
       _az_FACILITY_HTTP,
       3), ///< First HTTP request did not succeed and will be retried.
 
+  AZ_LOG_HTTP_CIRCUIT_BREAKER = _az_LOG_MAKE_CLASSIFICATION(
+      _az_FACILITY_HTTP,
+      4), ///< The circuit breaker stopped or resumed sending requests to an endpoint.
+
+  AZ_LOG_HTTP_RATE_LIMITER = _az_LOG_MAKE_CLASSIFICATION(
+      _az_FACILITY_HTTP,
+      5), ///< The rate limiter holds requests to an endpoint back.
+
+  AZ_LOG_HTTP_CONCURRENCY_LIMITER = _az_LOG_MAKE_CLASSIFICATION(
+      _az_FACILITY_HTTP,
+      6), ///< The concurrency limiter changed how many requests an endpoint gets at once.
+
   AZ_LOG_MQTT_RECEIVED_TOPIC
   = _az_LOG_MAKE_CLASSIFICATION(_az_FACILITY_MQTT, 1), ///< Accepted MQTT topic received.
 
@@ -128,6 +128,10 @@ typedef enum
   AZ_ERROR_HTTP_RESPONSE_OVERFLOW = _az_RESULT_MAKE_ERROR(_az_FACILITY_HTTP, 5),
   AZ_ERROR_HTTP_RESPONSE_COULDNT_RESOLVE_HOST = _az_RESULT_MAKE_ERROR(_az_FACILITY_HTTP, 6),
 
+  AZ_ERROR_HTTP_CIRCUIT_OPEN = _az_RESULT_MAKE_ERROR(
+      _az_FACILITY_HTTP,
+      7), ///< The endpoint has been failing, so the request was not sent.
+
   // IoT error codes
   AZ_ERROR_IOT_TOPIC_NO_MATCH = _az_RESULT_MAKE_ERROR(_az_FACILITY_IOT, 1),
 } az_result;
@@ -386,6 +386,267 @@ AZ_NODISCARD az_result az_span_u64toa(az_span destination, uint64_t source, az_s
  */
 AZ_NODISCARD az_result az_span_dtoa(az_span destination, double source, az_span* out_span);
 
+/******************************  SPAN BASE64  */
+
+/**
+ * @brief Calculates the size of the base64 encoding of \p source_size bytes, as written by
+ * #az_span_base64_encode.
+ *
+ * @param[in] source_size The number of bytes to encode.
+ * @return The number of characters needed to hold the encoded bytes, including padding.
+ */
+AZ_NODISCARD int32_t az_span_base64_encode_size(int32_t source_size);
+
+/**
+ * @brief Calculates the size of the base64url encoding of \p source_size bytes, as written by
+ * #az_span_base64_url_encode.
+ *
+ * @param[in] source_size The number of bytes to encode.
+ * @return The number of characters needed to hold the encoded bytes (without padding).
+ */
+AZ_NODISCARD int32_t az_span_base64_url_encode_size(int32_t source_size);
+
+/**
+ * @brief Calculates the number of bytes encoded by the base64 or base64url characters in \p
+ * source.
+ *
+ * @param[in] source The #az_span containing the encoded characters, with or without padding.
+ * @return The number of bytes written by #az_span_base64_decode or #az_span_base64_url_decode when
+ * decoding \p source.
+ */
+AZ_NODISCARD int32_t az_span_base64_decode_size(az_span source);
+
+/**
+ * @brief Encodes the bytes of the \p source #az_span into the \p destination #az_span, using the
+ * base64 alphabet and padding of RFC 4648 (section 4).
+ *
+ * @param[in] destination The #az_span where the encoded characters should be copied to.
+ * @param[in] source The #az_span containing the bytes to encode.
+ * @param[out] out_span A pointer to an #az_span that receives the remainder of the \p destination
+ * #az_span after the encoded characters have been copied.
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if successful
+ *         - #AZ_ERROR_INSUFFICIENT_SPAN_SIZE if the \p destination is smaller than
+ * #az_span_base64_encode_size
+ */
+AZ_NODISCARD az_result
+az_span_base64_encode(az_span destination, az_span source, az_span* out_span);
+
+/**
+ * @brief Decodes the base64 characters of the \p source #az_span into the \p destination #az_span.
+ *
+ * @param[in] destination The #az_span where the decoded bytes should be copied to. It can be the
+ * same buffer as \p source, to decode in place.
+ * @param[in] source The #az_span containing the characters to decode, padded to a multiple of 4.
+ * @param[out] out_span A pointer to an #az_span that receives the remainder of the \p destination
+ * #az_span after the decoded bytes have been copied.
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if successful
+ *         - #AZ_ERROR_INSUFFICIENT_SPAN_SIZE if the \p destination is smaller than
+ * #az_span_base64_decode_size
+ *         - #AZ_ERROR_PARSER_UNEXPECTED_CHAR if \p source contains a character that is not part of
+ * the base64 alphabet or is not correctly padded
+ */
+AZ_NODISCARD az_result
+az_span_base64_decode(az_span destination, az_span source, az_span* out_span);
+
+/**
+ * @brief Encodes the bytes of the \p source #az_span into the \p destination #az_span, using the
+ * URL and filename safe base64 alphabet of RFC 4648 (section 5), without padding.
+ *
+ * @param[in] destination The #az_span where the encoded characters should be copied to.
+ * @param[in] source The #az_span containing the bytes to encode.
+ * @param[out] out_span A pointer to an #az_span that receives the remainder of the \p destination
+ * #az_span after the encoded characters have been copied.
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if successful
+ *         - #AZ_ERROR_INSUFFICIENT_SPAN_SIZE if the \p destination is smaller than
+ * #az_span_base64_url_encode_size
+ */
+AZ_NODISCARD az_result
+az_span_base64_url_encode(az_span destination, az_span source, az_span* out_span);
+
+/**
+ * @brief Decodes the base64url characters of the \p source #az_span into the \p destination
+ * #az_span.
+ *
+ * @param[in] destination The #az_span where the decoded bytes should be copied to. It can be the
+ * same buffer as \p source, to decode in place.
+ * @param[in] source The #az_span containing the characters to decode, with or without padding.
+ * @param[out] out_span A pointer to an #az_span that receives the remainder of the \p destination
+ * #az_span after the decoded bytes have been copied.
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if successful
+ *         - #AZ_ERROR_INSUFFICIENT_SPAN_SIZE if the \p destination is smaller than
+ * #az_span_base64_decode_size
+ *         - #AZ_ERROR_PARSER_UNEXPECTED_CHAR if \p source contains a character that is not part of
+ * the base64url alphabet or is not correctly padded
+ */
+AZ_NODISCARD az_result
+az_span_base64_url_decode(az_span destination, az_span source, az_span* out_span);
+
+/******************************  SPAN ARENA  */
+
+/**
+ * @brief An #az_span_arena hands out consecutive slices of a single caller-provided buffer, so
+ * that all the scratch space needed by an operation (such as the URL, headers and body of an HTTP
+ * request) comes from one allocation.
+ *
+ * @remarks The slices are not freed individually. Use #az_span_arena_mark and
+ * #az_span_arena_reset to release everything allocated after a given point, or reset to `0` to
+ * reuse the whole buffer.
+ */
+typedef struct
+{
+  struct
+  {
+    az_span buffer;
+    int32_t used;
+  } _internal;
+} az_span_arena;
+
+/**
+ * @brief Initializes an #az_span_arena over \p buffer.
+ *
+ * @param[out] out_arena The #az_span_arena to initialize.
+ * @param[in] buffer The #az_span from which the arena allocates.
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if successful
+ */
+AZ_NODISCARD az_result az_span_arena_init(az_span_arena* out_arena, az_span buffer);
+
+/**
+ * @brief Allocates \p size bytes from the \p arena.
+ *
+ * @remarks The returned #az_span is aligned for any of the types used by the SDK (such as the
+ * #az_pair array of an HTTP request's headers). Its bytes are not cleared.
+ *
+ * @param[in] arena The #az_span_arena to allocate from.
+ * @param[in] size The number of bytes to allocate.
+ * @param[out] out_span A pointer to an #az_span that receives the allocated bytes.
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if successful
+ *         - #AZ_ERROR_INSUFFICIENT_SPAN_SIZE if the \p arena does not have \p size bytes left
+ */
+AZ_NODISCARD az_result az_span_arena_alloc(az_span_arena* arena, int32_t size, az_span* out_span);
+
+/**
+ * @brief Returns the number of bytes that can still be allocated from the \p arena.
+ *
+ * @param[in] arena The #az_span_arena to query.
+ * @return The size of the largest allocation that would succeed.
+ */
+AZ_NODISCARD int32_t az_span_arena_remaining(az_span_arena const* arena);
+
+/**
+ * @brief Returns the current position of the \p arena, to be passed to #az_span_arena_reset.
+ *
+ * @param[in] arena The #az_span_arena to query.
+ * @return The number of bytes used so far.
+ */
+AZ_NODISCARD AZ_INLINE int32_t az_span_arena_mark(az_span_arena const* arena)
+{
+  return arena->_internal.used;
+}
+
+/**
+ * @brief Releases everything allocated from the \p arena after \p mark was taken.
+ *
+ * @param[in] arena The #az_span_arena to reset.
+ * @param[in] mark A value returned by #az_span_arena_mark, or `0` to release all allocations.
+ */
+void az_span_arena_reset(az_span_arena* arena, int32_t mark);
+
+/******************************  SPAN LIST  */
+
+/**
+ * @brief An #az_span_list is a sequence of #az_span instances that together make up one logical
+ * byte sequence, so that separate pieces (such as a static prefix, an identifier and a payload)
+ * can be referenced where they are instead of being copied into one buffer.
+ *
+ * @remarks The list only references the bytes of the spans appended to it, which must remain
+ * valid for as long as the list is used.
+ */
+typedef struct
+{
+  struct
+  {
+    az_span* spans;
+    int32_t capacity;
+    int32_t count;
+    int32_t size;
+  } _internal;
+} az_span_list;
+
+/**
+ * @brief Initializes an empty #az_span_list.
+ *
+ * @param[out] out_list The #az_span_list to initialize.
+ * @param[in] spans An array of \p capacity #az_span, which receives the appended spans.
+ * @param[in] capacity The number of elements of \p spans.
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if successful
+ */
+AZ_NODISCARD az_result az_span_list_init(az_span_list* out_list, az_span* spans, int32_t capacity);
+
+/**
+ * @brief Appends \p span to the end of the \p list. Empty spans are ignored.
+ *
+ * @param[in] list The #az_span_list to append to.
+ * @param[in] span The #az_span to append.
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if successful
+ *         - #AZ_ERROR_INSUFFICIENT_SPAN_SIZE if the \p list is full
+ */
+AZ_NODISCARD az_result az_span_list_append(az_span_list* list, az_span span);
+
+/**
+ * @brief Returns the number of spans in the \p list.
+ *
+ * @param[in] list The #az_span_list to query.
+ * @return The number of (non-empty) spans appended to \p list.
+ */
+AZ_NODISCARD AZ_INLINE int32_t az_span_list_count(az_span_list const* list)
+{
+  return list->_internal.count;
+}
+
+/**
+ * @brief Returns the total number of bytes referenced by the \p list.
+ *
+ * @param[in] list The #az_span_list to query.
+ * @return The sum of the sizes of the spans of \p list.
+ */
+AZ_NODISCARD AZ_INLINE int32_t az_span_list_size(az_span_list const* list)
+{
+  return list->_internal.size;
+}
+
+/**
+ * @brief Returns the span at position \p index of the \p list.
+ *
+ * @param[in] list The #az_span_list to query.
+ * @param[in] index The position of the span, less than #az_span_list_count.
+ * @return The #az_span at position \p index.
+ */
+AZ_NODISCARD az_span az_span_list_get(az_span_list const* list, int32_t index);
+
+/**
+ * @brief Copies the bytes referenced by the \p list into the \p destination, one span after the
+ * other.
+ *
+ * @param[in] list The #az_span_list to copy.
+ * @param[in] destination The #az_span whose bytes will receive the contents of \p list.
+ * @param[out] out_span A pointer to an #az_span that receives the remainder of the \p destination
+ * #az_span after the contents of \p list have been copied.
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if successful
+ *         - #AZ_ERROR_INSUFFICIENT_SPAN_SIZE if the \p destination is smaller than
+ * #az_span_list_size
+ */
+AZ_NODISCARD az_result
+az_span_list_flatten(az_span_list const* list, az_span destination, az_span* out_span);
+
 /******************************  SPAN PAIR  */
 
 /**
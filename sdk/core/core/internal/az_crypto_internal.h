@@ -0,0 +1,117 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+/**
+ * @file az_crypto_internal.h
+ *
+ * @brief Portable SHA-256 (FIPS 180-4) and HMAC-SHA256 (RFC 2104) used by the built-in platform
+ * implementations of the `az_platform_hmac_sha256_*` functions.
+ */
+
+#ifndef _az_CRYPTO_INTERNAL_H
+#define _az_CRYPTO_INTERNAL_H
+
+#include <az_result.h>
+#include <az_span.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <_az_cfg_prefix.h>
+
+enum
+{
+  _az_SHA256_BLOCK_SIZE = 64,
+  _az_SHA256_HASH_SIZE = 32,
+};
+
+/**
+ * @brief Incremental SHA-256 computation.
+ */
+typedef struct
+{
+  struct
+  {
+    uint32_t state[8];
+    uint64_t length;
+    uint8_t block[_az_SHA256_BLOCK_SIZE];
+  } _internal;
+} _az_sha256;
+
+/**
+ * @brief HMAC-SHA256 key with the inner and outer pads already hashed, so that signing a message
+ * with the same key does not need to process the key again.
+ */
+typedef struct
+{
+  struct
+  {
+    uint32_t inner_state[8];
+    uint32_t outer_state[8];
+  } _internal;
+} _az_hmac_sha256_key;
+
+/**
+ * @brief Zeroes \p size bytes at \p ptr through volatile stores, which the compiler can't remove
+ * even though the bytes are never read again. Used to erase keys and key material.
+ *
+ * @param[out] ptr The bytes to zero.
+ * @param[in] size The number of bytes.
+ */
+void _az_crypto_wipe(void* ptr, size_t size);
+
+/**
+ * @brief Starts a new SHA-256 computation.
+ *
+ * @param[out] out_sha256 The #_az_sha256 to initialize.
+ */
+void _az_sha256_init(_az_sha256* out_sha256);
+
+/**
+ * @brief Appends \p bytes to the message being hashed.
+ *
+ * @param[in] sha256 The #_az_sha256 initialized by #_az_sha256_init.
+ * @param[in] bytes The next bytes of the message.
+ */
+void _az_sha256_update(_az_sha256* sha256, az_span bytes);
+
+/**
+ * @brief Completes the SHA-256 computation and writes the hash.
+ *
+ * @param[in] sha256 The #_az_sha256 to complete. It must be initialized again before being reused.
+ * @param[in] destination The #az_span whose bytes will receive the 32-byte hash.
+ * @param[out] out_hash The slice of \p destination containing the hash.
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if successful
+ *         - #AZ_ERROR_INSUFFICIENT_SPAN_SIZE if \p destination is smaller than 32 bytes
+ */
+AZ_NODISCARD az_result _az_sha256_final(_az_sha256* sha256, az_span destination, az_span* out_hash);
+
+/**
+ * @brief Precomputes the HMAC-SHA256 inner and outer pads of \p key.
+ *
+ * @param[out] out_key The #_az_hmac_sha256_key to initialize.
+ * @param[in] key The secret key. Keys longer than 64 bytes are hashed first, as per RFC 2104.
+ */
+void _az_hmac_sha256_key_init(_az_hmac_sha256_key* out_key, az_span key);
+
+/**
+ * @brief Computes the HMAC-SHA256 of \p bytes_to_sign.
+ *
+ * @param[in] key The #_az_hmac_sha256_key initialized by #_az_hmac_sha256_key_init.
+ * @param[in] bytes_to_sign The message to sign.
+ * @param[in] destination The #az_span whose bytes will receive the 32-byte signature.
+ * @param[out] out_signature The slice of \p destination containing the signature.
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if successful
+ *         - #AZ_ERROR_INSUFFICIENT_SPAN_SIZE if \p destination is smaller than 32 bytes
+ */
+AZ_NODISCARD az_result _az_hmac_sha256_sign(
+    _az_hmac_sha256_key const* key,
+    az_span bytes_to_sign,
+    az_span destination,
+    az_span* out_signature);
+
+#include <_az_cfg_suffix.h>
+
+#endif // _az_CRYPTO_INTERNAL_H
@@ -106,6 +106,318 @@ AZ_NODISCARD AZ_INLINE _az_http_policy_telemetry_options _az_http_policy_telemet
   return (_az_http_policy_telemetry_options){ .os = AZ_SPAN_FROM_STR("Unknown OS") };
 }
 
+/**
+ * @brief Compresses the body of \p p_request into \p destination.
+ *
+ * @param context The context given to #_az_http_policy_compression_options_init.
+ * @param p_request The request to compress the body of. Read it with
+ * #az_http_request_get_body_span, as it may be made of several spans.
+ * @param destination Where to write the compressed body.
+ * @param out_compressed The part of \p destination holding the compressed body.
+ *
+ * @return
+ *   - *`AZ_OK`* success.
+ *   - *`AZ_ERROR_INSUFFICIENT_SPAN_SIZE`* the compressed body does not fit in \p destination. The
+ * request is then sent uncompressed.
+ */
+typedef AZ_NODISCARD az_result (*_az_http_policy_compression_fn)(
+    void* context,
+    _az_http_request const* p_request,
+    az_span destination,
+    az_span* out_compressed);
+
+/**
+ * @brief Defines the options structure used by the compression policy
+ *
+ * Users @b should @b not access _internal field.
+ *
+ */
+typedef struct
+{
+  struct
+  {
+    _az_http_policy_compression_fn compress;
+    void* compress_context;
+    az_span content_encoding;
+    int32_t min_body_size;
+    az_span_arena* scratch;
+  } _internal;
+} _az_http_policy_compression_options;
+
+/**
+ * @brief Initialize the options of the compression policy.
+ *
+ * @remarks The SDK does not depend on any compression library. The caller provides \p compress,
+ * for instance a gzip encoder on top of zlib, and the value of the `Content-Encoding` header that
+ * names what it produces.
+ *
+ * @param[out] out_options The options to initialize.
+ * @param[in] compress The function compressing request bodies.
+ * @param[in] compress_context A context passed as is to \p compress.
+ * @param[in] content_encoding The value of the `Content-Encoding` header of compressed requests.
+ * @param[in] min_body_size Requests with a body smaller than this are sent uncompressed.
+ * @param[in] scratch The arena the compressed body is written to. It is reset once the request has
+ * been sent, so each request can use all of it.
+ *
+ * @return
+ *   - *`AZ_OK`* success.
+ */
+AZ_NODISCARD az_result _az_http_policy_compression_options_init(
+    _az_http_policy_compression_options* out_options,
+    _az_http_policy_compression_fn compress,
+    void* compress_context,
+    az_span content_encoding,
+    int32_t min_body_size,
+    az_span_arena* scratch);
+
+/**
+ * @brief Identifies the endpoint whose state a policy keeps in a slot. The state of each endpoint
+ * starts with it.
+ */
+typedef struct
+{
+  uint32_t authority_hash;
+  bool in_use;
+} _az_http_endpoint_slot;
+
+enum
+{
+  _az_HTTP_CIRCUIT_BREAKER_ENDPOINTS = 4, // Number of endpoints tracked at the same time
+  _az_HTTP_CIRCUIT_BREAKER_WINDOW_MAX = 32, // Bits in the outcomes ring
+};
+
+typedef enum
+{
+  _az_HTTP_CIRCUIT_STATE_CLOSED = 0,
+  _az_HTTP_CIRCUIT_STATE_OPEN = 1,
+  _az_HTTP_CIRCUIT_STATE_HALF_OPEN = 2,
+} _az_http_circuit_state;
+
+/**
+ * @brief State of an endpoint tracked by the circuit breaker policy.
+ */
+typedef struct
+{
+  _az_http_endpoint_slot slot;
+  _az_http_circuit_state state;
+  uint32_t outcomes; // A bit per recent request, set if it failed; the newest in bit 0
+  int32_t outcomes_count;
+  int64_t opened_at_msec;
+  int32_t in_flight; // Requests sent through the circuit that haven't completed yet
+  bool probing;
+} _az_http_circuit_endpoint;
+
+/**
+ * @brief Defines the options structure used by the circuit breaker policy, which also holds the
+ * state of the endpoints it tracks. Share one instance between every client of the process that
+ * calls the same endpoints.
+ *
+ * @remarks Each endpoint (the authority of the request URL) gets a slot. An endpoint only gives
+ * its slot to another one while its circuit is closed and no request to it is in flight, so an
+ * open circuit is never forgotten; a request to a new endpoint while all the slots are busy goes
+ * through unchecked. The recent outcomes are a ring of bits.
+ *
+ * The endpoints are only updated under the mutex, which is never held while a request is sent.
+ * Without a mutex, the pipelines sharing the options must not be used from several threads.
+ *
+ * Users @b should @b not access _internal field.
+ *
+ */
+typedef struct
+{
+  struct
+  {
+    _az_http_circuit_endpoint endpoints[_az_HTTP_CIRCUIT_BREAKER_ENDPOINTS];
+    struct az_platform_mtx* mutex;
+    int32_t window;
+    int32_t min_requests;
+    int32_t failure_percent;
+    int32_t open_duration_msec;
+  } _internal;
+} _az_http_policy_circuit_breaker_options;
+
+/**
+ * @brief Initialize the options of the circuit breaker policy.
+ *
+ * @remarks A request fails when it can't be sent, or gets a 408 or 5xx response. When at least
+ * \p failure_percent of the last \p window requests to an endpoint failed (once there were at
+ * least \p min_requests), the circuit opens: requests fail with #AZ_ERROR_HTTP_CIRCUIT_OPEN
+ * without being sent. After \p open_duration_msec, a single request goes through as a probe. The
+ * circuit closes if it succeeds, and opens again if it fails. If its caller gives up on it (the
+ * context is canceled), the next request is the probe.
+ *
+ * @param[out] out_options The options to initialize.
+ * @param[in] mutex An initialized mutex, if the pipeline is used from several threads. NULL
+ * otherwise.
+ * @param[in] window How many of the most recent requests are considered, up to 32.
+ * @param[in] min_requests How many requests are needed before the circuit can open.
+ * @param[in] failure_percent The share of failed requests, in percent, that opens the circuit.
+ * @param[in] open_duration_msec How long the circuit stays open before letting a probe through.
+ *
+ * @return
+ *   - *`AZ_OK`* success.
+ */
+AZ_NODISCARD az_result _az_http_policy_circuit_breaker_options_init(
+    _az_http_policy_circuit_breaker_options* out_options,
+    struct az_platform_mtx* mutex,
+    int32_t window,
+    int32_t min_requests,
+    int32_t failure_percent,
+    int32_t open_duration_msec);
+
+enum
+{
+  _az_HTTP_RATE_LIMITER_ENDPOINTS = 4, // Number of endpoints tracked at the same time
+};
+
+/**
+ * @brief State of an endpoint tracked by the rate limiter policy.
+ */
+typedef struct
+{
+  _az_http_endpoint_slot slot;
+  // When the next request would be sent if requests went out exactly at the configured rate. The
+  // bucket is full when it's a burst or more behind the clock.
+  int64_t theoretical_arrival_usec;
+} _az_http_rate_limiter_endpoint;
+
+/**
+ * @brief Defines the options structure used by the rate limiter policy, which also holds the
+ * state of the endpoints it tracks. Share one instance between every client of the process that
+ * calls the same endpoints.
+ *
+ * @remarks Each endpoint (the authority of the request URL) gets a slot. An endpoint only gives
+ * its slot to another one once its bucket is full again, so a pause asked for by the endpoint is
+ * never forgotten; a request to a new endpoint while all the slots are busy is sent unpaced.
+ *
+ * Like the circuit breaker, the endpoints are only updated under the mutex, which is not held while
+ * a request waits for its token or is sent. Without a mutex, the pipelines sharing the options must
+ * not be used from several threads.
+ *
+ * Users @b should @b not access _internal field.
+ *
+ */
+typedef struct
+{
+  struct
+  {
+    _az_http_rate_limiter_endpoint endpoints[_az_HTTP_RATE_LIMITER_ENDPOINTS];
+    struct az_platform_mtx* mutex;
+    int64_t interval_usec;
+    int64_t burst_usec;
+  } _internal;
+} _az_http_policy_rate_limiter_options;
+
+/**
+ * @brief Initialize the options of the rate limiter policy.
+ *
+ * @remarks Requests to each endpoint are paced by a token bucket holding up to \p burst requests,
+ * refilled at \p requests_per_second. A request that finds the bucket empty waits for the next
+ * token, or fails with #AZ_ERROR_CANCELED if the context expires before then.
+ *
+ * When an endpoint throttles a request (429 or 503), the bucket is emptied, and if the response
+ * has a retry-after header, no request is sent to that endpoint until then. Every request through
+ * the pipeline waits, not only the one that got the response.
+ *
+ * @param[out] out_options The options to initialize.
+ * @param[in] mutex An initialized mutex, if the pipeline is used from several threads. NULL
+ * otherwise.
+ * @param[in] requests_per_second How many requests are sent to an endpoint per second, once the
+ * burst is spent.
+ * @param[in] burst How many requests can be sent at once.
+ *
+ * @return
+ *   - *`AZ_OK`* success.
+ */
+AZ_NODISCARD az_result _az_http_policy_rate_limiter_options_init(
+    _az_http_policy_rate_limiter_options* out_options,
+    struct az_platform_mtx* mutex,
+    int32_t requests_per_second,
+    int32_t burst);
+
+enum
+{
+  _az_HTTP_CONCURRENCY_LIMITER_ENDPOINTS = 4, // Number of endpoints tracked at the same time
+  _az_HTTP_CONCURRENCY_LIMITER_QUEUE_MAX = 32, // Bits in the abandoned tickets mask
+  // Share of the gap to a slower response that the latency baseline closes, as a divisor
+  _az_HTTP_CONCURRENCY_LIMITER_BASELINE_DECAY = 32,
+};
+
+/**
+ * @brief State of an endpoint tracked by the concurrency limiter policy.
+ */
+typedef struct
+{
+  _az_http_endpoint_slot slot;
+  int32_t limit; // How many requests can be in flight at once
+  int32_t in_flight;
+  int32_t increase_credit; // Requests that completed in time since the limit last changed
+  // The latency without queuing: drops to a faster response at once, and creeps up towards slower
+  // ones, so it follows an endpoint that got slower for good; -1 if none
+  int64_t baseline_latency_usec;
+  // Callers take a ticket and are let in in order.
+  uint32_t next_ticket;
+  uint32_t now_serving;
+  uint32_t abandoned; // A bit per ticket from now_serving on, set if its caller gave up waiting
+} _az_http_concurrency_endpoint;
+
+/**
+ * @brief Defines the options structure used by the concurrency limiter policy, which also holds
+ * the state of the endpoints it tracks. Share one instance between every client of the process that
+ * calls the same endpoints.
+ *
+ * @remarks Each endpoint (the authority of the request URL) gets a slot. An endpoint only gives
+ * its slot to another one when no request to it is in flight or waiting; a request to a new
+ * endpoint while all the slots are busy is sent unlimited.
+ *
+ * Users @b should @b not access _internal field.
+ *
+ */
+typedef struct
+{
+  struct
+  {
+    _az_http_concurrency_endpoint endpoints[_az_HTTP_CONCURRENCY_LIMITER_ENDPOINTS];
+    struct az_platform_mtx* mutex;
+    int32_t initial_limit;
+    int32_t min_limit;
+    int32_t max_limit;
+    int32_t latency_tolerance_percent;
+  } _internal;
+} _az_http_policy_concurrency_limiter_options;
+
+/**
+ * @brief Initialize the options of the concurrency limiter policy.
+ *
+ * @remarks Each endpoint starts with \p initial_limit requests in flight at once. The limit is
+ * halved when a request fails to be sent or gets a 408, 429 or 503, and lowered by one when a
+ * response takes longer than \p latency_tolerance_percent of the baseline, which tracks the fastest
+ * recent responses. It grows by one once as many requests as the limit completed in time with at
+ * least half of it in use.
+ *
+ * Requests over the limit wait for their turn, first come first served, or fail with
+ * #AZ_ERROR_CANCELED if their context expires first.
+ *
+ * @param[out] out_options The options to initialize.
+ * @param[in] mutex An initialized mutex, if the pipeline is used from several threads. NULL
+ * otherwise.
+ * @param[in] initial_limit How many requests an endpoint starts with.
+ * @param[in] min_limit The lowest the limit goes.
+ * @param[in] max_limit The highest the limit goes.
+ * @param[in] latency_tolerance_percent How slow a response can be, in percent of the baseline,
+ * before the endpoint is considered overloaded. At least 100.
+ *
+ * @return
+ *   - *`AZ_OK`* success.
+ */
+AZ_NODISCARD az_result _az_http_policy_concurrency_limiter_options_init(
+    _az_http_policy_concurrency_limiter_options* out_options,
+    struct az_platform_mtx* mutex,
+    int32_t initial_limit,
+    int32_t min_limit,
+    int32_t max_limit,
+    int32_t latency_tolerance_percent);
+
 AZ_NODISCARD AZ_INLINE _az_http_policy_apiversion_options
 _az_http_policy_apiversion_options_default()
 {
@@ -118,6 +430,18 @@ _az_http_policy_apiversion_options_default()
  */
 AZ_NODISCARD az_http_policy_retry_options _az_http_policy_retry_options_default();
 
+/**
+ * @brief Random number generator used to jitter the retry delays.
+ */
+typedef uint32_t (*_az_http_policy_retry_random_fn)();
+
+/**
+ * @brief Replaces the random number generator used to jitter the retry delays, so tests can make
+ * them predictable. Passing NULL restores the default one, a xorshift generator seeded from the
+ * platform clock.
+ */
+void _az_http_policy_retry_set_random_callback(_az_http_policy_retry_random_fn random_callback);
+
 // PipelinePolicies
 //   Policies are non-allocating caveat the TransportPolicy
 //   Transport p_policies can only allocate if the transport layer they call allocates
@@ -152,6 +476,34 @@ AZ_NODISCARD az_result az_http_pipeline_policy_telemetry(
     _az_http_request* p_request,
     az_http_response* p_response);
 
+// Place it before the retry policy, so an open circuit skips the retries as well.
+AZ_NODISCARD az_result az_http_pipeline_policy_circuit_breaker(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response);
+
+// Place it after the retry policy, so the retries are paced as well.
+AZ_NODISCARD az_result az_http_pipeline_policy_rate_limiter(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response);
+
+// Place it after the retry and rate limiter policies, so a request only holds a slot while sent.
+AZ_NODISCARD az_result az_http_pipeline_policy_concurrency_limiter(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response);
+
+// Place it before the retry policy, so the body is compressed once rather than on every attempt.
+AZ_NODISCARD az_result az_http_pipeline_policy_compression(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response);
+
 AZ_NODISCARD az_result az_http_pipeline_policy_retry(
     _az_http_policy* p_policies,
     void* p_data,
@@ -255,6 +607,158 @@ az_http_request_set_query_parameter(_az_http_request* p_request, az_span name, a
 AZ_NODISCARD az_result
 az_http_request_append_header(_az_http_request* p_request, az_span key, az_span value);
 
+/**
+ * @brief Set an HTTP header of the request, replacing the value of the first header with the same
+ * name (ignoring casing) or appending a new header if there is none.
+ *
+ * @remarks Policies that run on every retry (such as the credential policy) use it to overwrite
+ * their headers rather than appending them again.
+ *
+ * @param p_request HTTP request builder that holds the headers.
+ * @param key Header name (e.g. `"Authorization"`).
+ * @param value Header value.
+ *
+ * @return
+ *   - *`AZ_OK`* success.
+ *   - *`AZ_ERROR_INSUFFICIENT_SPAN_SIZE`* the header has to be appended and there isn't enough
+ * space in the headers buffer.
+ */
+AZ_NODISCARD az_result
+az_http_request_set_header(_az_http_request* p_request, az_span key, az_span value);
+
+/**
+ * @brief Remove the first HTTP header of the request with the given name (ignoring casing). The
+ * headers after it keep their order.
+ *
+ * @param p_request HTTP request builder that holds the headers.
+ * @param key Name of the header to remove.
+ *
+ * @return
+ *   - *`AZ_OK`* success.
+ *   - *`AZ_ERROR_ITEM_NOT_FOUND`* there is no header named `key`.
+ */
+AZ_NODISCARD az_result az_http_request_remove_header(_az_http_request* p_request, az_span key);
+
+/**
+ * @brief Sets the body of the request to the spans of \p body, which are sent one after the other
+ * without being copied into a single buffer.
+ *
+ * @param p_request HTTP request builder to set the body of.
+ * @param body The #az_span_list making up the body. The list and the bytes it references must
+ * remain valid until the request is sent.
+ * @param buffer Where the spans are copied for transports that need the body in one piece (see
+ * #az_http_request_get_body). It can be #AZ_SPAN_NULL if the transport reads the spans with
+ * #az_http_request_get_body_span, as the curl transport does.
+ *
+ * @return
+ *   - *`AZ_OK`* success.
+ */
+AZ_NODISCARD az_result az_http_request_set_body_list(
+    _az_http_request* p_request,
+    az_span_list const* body,
+    az_span buffer);
+
+/**
+ * @brief The parts of a request that are the same for every call a client makes: the URL prefix
+ * (including static query parameters, such as the api-version) and a block of static headers.
+ *
+ * A client renders them once, at init time, into buffers it owns. Each call then starts its request
+ * from a copy of the template and only appends the variable parts (path, query, body, ...).
+ *
+ * Users @b should @b not access _internal field.
+ *
+ */
+typedef struct
+{
+  struct
+  {
+    // Only the URL, query start and headers of the request are used.
+    _az_http_request request;
+  } _internal;
+} _az_http_request_template;
+
+/**
+ * @brief Initializes a request template with a copy of \p url and no headers.
+ *
+ * @param out_template Request template to initialize.
+ * @param url_buffer Buffer that receives the URL of the template. It must remain valid for as long
+ * as the template is used.
+ * @param url URL prefix of every request created from the template.
+ * @param headers_buffer Buffer that receives the headers of the template. It must remain valid for
+ * as long as the template is used.
+ *
+ * @return
+ *   - *`AZ_OK`* success.
+ *   - *`AZ_ERROR_INSUFFICIENT_SPAN_SIZE`* `url_buffer` is smaller than `url`.
+ */
+AZ_NODISCARD az_result _az_http_request_template_init(
+    _az_http_request_template* out_template,
+    az_span url_buffer,
+    az_span url,
+    az_span headers_buffer);
+
+/**
+ * @brief Sets a query parameter on every request created from the template.
+ *
+ * @see az_http_request_set_query_parameter
+ */
+AZ_NODISCARD az_result _az_http_request_template_set_query_parameter(
+    _az_http_request_template* request_template,
+    az_span name,
+    az_span value);
+
+/**
+ * @brief Adds a header to every request created from the template.
+ *
+ * @see az_http_request_append_header
+ */
+AZ_NODISCARD az_result _az_http_request_template_append_header(
+    _az_http_request_template* request_template,
+    az_span key,
+    az_span value);
+
+/**
+ * @brief Adds the api version to the template, the same way #az_http_pipeline_policy_apiversion
+ * adds it to each request. A client using this does not need the policy in its pipeline.
+ */
+AZ_NODISCARD az_result _az_http_request_template_add_apiversion(
+    _az_http_request_template* request_template,
+    _az_http_policy_apiversion_options const* options);
+
+/**
+ * @brief Adds the telemetry header to the template, the same way
+ * #az_http_pipeline_policy_telemetry adds it to each request. A client using this does not need
+ * the policy in its pipeline.
+ */
+AZ_NODISCARD az_result _az_http_request_template_add_telemetry(
+    _az_http_request_template* request_template,
+    _az_http_policy_telemetry_options const* options);
+
+/**
+ * @brief Initializes a request with a copy of the URL and headers of \p request_template.
+ *
+ * @param p_request HTTP request builder to initialize.
+ * @param context The context of the request.
+ * @param method HTTP verb: `"GET"`, `"POST"`, etc.
+ * @param url_buffer Buffer that receives the URL of the request.
+ * @param headers_buffer Buffer that receives the headers of the request.
+ * @param body The body of the request.
+ * @param request_template The template to copy the URL and headers from.
+ *
+ * @return
+ *   - *`AZ_OK`* success.
+ *   - *`AZ_ERROR_INSUFFICIENT_SPAN_SIZE`* `url_buffer` or `headers_buffer` are too small for the
+ * URL or the headers of the template.
+ */
+AZ_NODISCARD az_result _az_http_request_init_from_template(
+    _az_http_request* p_request,
+    az_context* context,
+    az_http_method method,
+    az_span url_buffer,
+    az_span headers_buffer,
+    az_span body,
+    _az_http_request_template const* request_template);
+
 #include <_az_cfg_suffix.h>
 
 #endif // _az_HTTP_INTERNAL_H
@@ -4,17 +4,34 @@
 #ifndef _az_PLATFORM_INTERNAL_H
 #define _az_PLATFORM_INTERNAL_H
 
+#include <az_context.h>
 #include <az_platform_impl.h>
 #include <az_result.h>
+#include <az_span.h>
 
 #include <stdint.h>
 
 #include <_az_cfg_prefix.h>
 
+// Milliseconds from a monotonic clock: it never goes back, and does not follow changes to the
+// wall clock. Context expirations and token expiry are measured against it.
 AZ_NODISCARD int64_t az_platform_clock_msec();
 
+// The same clock at a microsecond resolution, for instrumentation.
+AZ_NODISCARD int64_t az_platform_clock_usec();
+
+// The same clock, possibly lagging by up to a scheduler tick in exchange for a cheaper call. For
+// checks repeated on hot paths, where a few milliseconds don't matter.
+AZ_NODISCARD int64_t az_platform_clock_coarse_msec();
+
 void az_platform_sleep_msec(int32_t milliseconds);
 
+// Waits for up to milliseconds, returning early when context (az_context_app when NULL) expires or
+// gets canceled. Returns how many milliseconds were actually spent waiting. Waiters are woken up by
+// az_platform_wait_notify_all, which az_context_cancel calls.
+AZ_NODISCARD int32_t az_platform_wait_msec(az_context const* context, int32_t milliseconds);
+void az_platform_wait_notify_all();
+
 typedef struct az_platform_mtx az_platform_mtx;
 
 void az_platform_mtx_destroy(az_platform_mtx* mtx);
@@ -22,6 +39,21 @@ AZ_NODISCARD az_result az_platform_mtx_init(az_platform_mtx* mtx);
 AZ_NODISCARD az_result az_platform_mtx_lock(az_platform_mtx* mtx);
 AZ_NODISCARD az_result az_platform_mtx_unlock(az_platform_mtx* mtx);
 
+// HMAC-SHA256 engine used to sign SAS tokens. The key is processed once by
+// az_platform_hmac_sha256_key_init so that signing repeatedly with the same key is cheap.
+// Platforms with a hardware engine or a secure element can provide their own implementation
+// through AZ_PLATFORM_IMPL=USER; the built-in platforms use the portable one in az_core.
+typedef struct az_platform_hmac_sha256_key az_platform_hmac_sha256_key;
+
+void az_platform_hmac_sha256_key_destroy(az_platform_hmac_sha256_key* key);
+AZ_NODISCARD az_result
+az_platform_hmac_sha256_key_init(az_platform_hmac_sha256_key* key, az_span key_bytes);
+AZ_NODISCARD az_result az_platform_hmac_sha256_sign(
+    az_platform_hmac_sha256_key const* key,
+    az_span bytes_to_sign,
+    az_span destination,
+    az_span* out_signature);
+
 #include <_az_cfg_suffix.h>
 
 #endif // _az_PLATFORM_INTERNAL_H
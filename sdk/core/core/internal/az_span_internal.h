@@ -12,6 +12,13 @@
 
 #include <_az_cfg_prefix.h>
 
+enum
+{
+  // The alignment of the slices handed out by #az_span_arena_alloc. Large enough for pointers,
+  // 64-bit integers and doubles on the supported targets.
+  _az_SPAN_ARENA_ALIGNMENT = 8,
+};
+
 // Use this helper to figure out how much the sliced_span has moved in comparison to the
 // original_span while writing and slicing a copy of the original.
 // The \p sliced_span must be some slice of the \p original_span (and have the same backing memory).
@@ -41,6 +48,142 @@ AZ_INLINE AZ_NODISCARD int32_t _az_span_diff(az_span sliced_span, az_span origin
 AZ_NODISCARD az_result
 _az_span_url_encode(az_span destination, az_span source, int32_t* out_length);
 
+/**
+ * @brief Calculates the length of the URL-encoded form of \p source, as written by
+ * #_az_span_url_encode.
+ *
+ * @param[in] source The #az_span containing the non-URL-encoded bytes.
+ * @return The number of bytes needed to hold the URL-encoded \p source.
+ */
+AZ_NODISCARD int32_t _az_span_url_encode_size(az_span source);
+
+/**
+ * @brief Copies the bytes from the \p source #az_span to the \p destination #az_span, decoding the
+ * URL-encoded (percent-encoded) characters.
+ *
+ * @remarks \p destination may be the same buffer as \p source, to decode in place. A `+` is
+ * copied as is, it is not decoded as a space.
+ *
+ * @param[in] destination The #az_span whose bytes will receive the decoded \p source.
+ * @param[in] source The #az_span containing the URL-encoded bytes.
+ * @param[out] out_length A pointer to an int32_t that is going to be assigned the length
+ * of the decoded \p source.
+ * @return An #az_result value indicating the result of the operation:
+ *         - #AZ_OK if successful
+ *         - #AZ_ERROR_INSUFFICIENT_SPAN_SIZE if the \p destination is not big enough to contain
+ * the decoded bytes
+ *         - #AZ_ERROR_EOF if \p source ends in the middle of an escape sequence
+ *         - #AZ_ERROR_PARSER_UNEXPECTED_CHAR if a `%` is not followed by two hexadecimal digits
+ */
+AZ_NODISCARD az_result
+_az_span_url_decode(az_span destination, az_span source, int32_t* out_length);
+
+/**
+ * @brief Calculates the number of characters needed to write \p number in decimal, as done by
+ * #az_span_u64toa.
+ *
+ * @param[in] number The number whose decimal representation is to be measured.
+ * @return The number of digits of \p number (1 for 0).
+ */
+AZ_NODISCARD int32_t _az_span_u64toa_size(uint64_t number);
+
+/**
+ * @brief Calculates the number of characters needed to write \p number in decimal, as done by
+ * #az_span_u32toa.
+ *
+ * @param[in] number The number whose decimal representation is to be measured.
+ * @return The number of digits of \p number (1 for 0).
+ */
+AZ_NODISCARD int32_t _az_span_u32toa_size(uint32_t number);
+
+enum
+{
+  _az_SPAN_NAME_MATCHER_MAX_NAMES = 8, ///< Maximum number of names in a #_az_span_name_matcher.
+};
+
+/**
+ * @brief A set of names (such as HTTP header names) to be compared against, except for casing.
+ *
+ * @remarks Each name is stored along with its first 8 bytes, lower-cased, in a single word. Looking
+ * a span up then only compares its size and prefix word against each name, and the rest of the
+ * bytes of the name whose size and prefix match (if it is longer than 8 bytes).
+ */
+typedef struct
+{
+  struct
+  {
+    az_span names[_az_SPAN_NAME_MATCHER_MAX_NAMES];
+    uint64_t prefixes[_az_SPAN_NAME_MATCHER_MAX_NAMES];
+    int32_t count;
+  } _internal;
+} _az_span_name_matcher;
+
+/**
+ * @brief The prefix word of a name of a #_az_span_name_matcher, from its first 8 bytes lower-cased
+ * (0 past the end of shorter names). As a constant expression, it lets a matcher be initialized
+ * statically rather than with #_az_span_name_matcher_init.
+ */
+#define _az_SPAN_NAME_MATCHER_PREFIX(b0, b1, b2, b3, b4, b5, b6, b7) \
+  ((uint64_t)(b0) | ((uint64_t)(b1) << 8) | ((uint64_t)(b2) << 16) | ((uint64_t)(b3) << 24) \
+   | ((uint64_t)(b4) << 32) | ((uint64_t)(b5) << 40) | ((uint64_t)(b6) << 48) \
+   | ((uint64_t)(b7) << 56))
+
+/**
+ * @brief Initializes a #_az_span_name_matcher.
+ *
+ * @param[out] out_matcher The #_az_span_name_matcher to initialize.
+ * @param[in] names The names to match. The spans must remain valid for as long as the matcher is
+ * used.
+ * @param[in] names_count The number of \p names, up to #_az_SPAN_NAME_MATCHER_MAX_NAMES.
+ * @return #AZ_OK.
+ */
+AZ_NODISCARD az_result _az_span_name_matcher_init(
+    _az_span_name_matcher* out_matcher,
+    az_span const* names,
+    int32_t names_count);
+
+/**
+ * @brief Looks \p name up in a #_az_span_name_matcher, ignoring casing.
+ *
+ * @param[in] matcher The #_az_span_name_matcher containing the names to compare against.
+ * @param[in] name The #az_span to look up.
+ * @return The index of the first of the matcher's names that is equal to \p name (as defined by
+ * #az_span_is_content_equal_ignoring_case), or -1 if there is none.
+ */
+AZ_NODISCARD int32_t
+_az_span_name_matcher_find(_az_span_name_matcher const* matcher, az_span name);
+
+/**
+ * @brief Finds the first occurrence of \p byte in \p span.
+ *
+ * @param[in] span The #az_span to search in.
+ * @param[in] byte The byte to look for.
+ * @return The index of the first occurrence of \p byte in \p span, or -1 if there is none.
+ */
+AZ_NODISCARD int32_t _az_span_find_byte(az_span span, uint8_t byte);
+
+/**
+ * @brief Finds the first byte of \p span whose value is less than \p bound, such as the first
+ * control character when \p bound is `' '`.
+ *
+ * @remarks The bytes are compared 8 at a time, as the bytes of a single 64-bit word (SWAR).
+ *
+ * @param[in] span The #az_span to search in.
+ * @param[in] bound The value the byte must be less than, up to 128.
+ * @return The index of the first byte of \p span that is less than \p bound, or -1 if there is
+ * none.
+ */
+AZ_NODISCARD int32_t _az_span_find_byte_below(az_span span, uint8_t bound);
+
+/**
+ * @brief Computes a 32-bit FNV-1a hash of the bytes of \p span, lower-cased, so that names that
+ * only differ by their casing (such as HTTP header names) hash the same.
+ *
+ * @param[in] span The #az_span to hash.
+ * @return The hash of \p span.
+ */
+AZ_NODISCARD uint32_t _az_span_hash_ignoring_case(az_span span);
+
 /**
  * @brief String tokenizer for #az_span.
  *
@@ -91,16 +91,18 @@ AZ_NODISCARD az_result _az_aad_build_body(
   return AZ_OK;
 }
 
-AZ_NODISCARD az_result _az_aad_request_token(_az_http_request* request, _az_token* out_token)
+AZ_NODISCARD az_result
+_az_aad_request_token(_az_http_request* request, az_span_arena* arena, _az_token* out_token)
 {
   AZ_RETURN_IF_FAILED(az_http_request_append_header(
       request,
       AZ_SPAN_FROM_STR("Content-Type"),
       AZ_SPAN_FROM_STR("application/x-www-form-urlencoded")));
 
-  uint8_t response_buf[_az_AAD_RESPONSE_BUF_SIZE] = { 0 };
+  az_span response_buf;
+  AZ_RETURN_IF_FAILED(az_span_arena_alloc(arena, _az_AAD_RESPONSE_BUF_SIZE, &response_buf));
   az_http_response response = { 0 };
-  AZ_RETURN_IF_FAILED(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(response_buf)));
+  AZ_RETURN_IF_FAILED(az_http_response_init(&response, response_buf));
 
   az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
   retry_options.max_retries = 7;
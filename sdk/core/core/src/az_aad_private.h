@@ -10,6 +10,7 @@
 #include <az_http.h>
 #include <az_result.h>
 #include <az_span.h>
+#include <az_span_internal.h>
 
 #include <stdbool.h>
 
@@ -21,6 +22,10 @@ enum
   _az_AAD_REQUEST_HEADER_BUF_SIZE = 10 * sizeof(az_pair),
   _az_AAD_REQUEST_BODY_BUF_SIZE = AZ_HTTP_REQUEST_BODY_BUF_SIZE,
   _az_AAD_RESPONSE_BUF_SIZE = 3 * 1024,
+  // The buffer the four above are allocated from. The sizes are multiples of the arena alignment,
+  // so only the first allocation may need padding, when the buffer itself isn't aligned.
+  _az_AAD_BUF_SIZE = _az_AAD_REQUEST_URL_BUF_SIZE + _az_AAD_REQUEST_HEADER_BUF_SIZE
+      + _az_AAD_REQUEST_BODY_BUF_SIZE + _az_AAD_RESPONSE_BUF_SIZE + _az_SPAN_ARENA_ALIGNMENT - 1,
 };
 
 AZ_NODISCARD az_result _az_aad_build_url(az_span url, az_span tenant_id, az_span* out_url);
@@ -32,7 +37,8 @@ AZ_NODISCARD az_result _az_aad_build_body(
     az_span client_secret,
     az_span* out_body);
 
-AZ_NODISCARD az_result _az_aad_request_token(_az_http_request* request, _az_token* out_token);
+AZ_NODISCARD az_result
+_az_aad_request_token(_az_http_request* request, az_span_arena* arena, _az_token* out_token);
 
 AZ_NODISCARD bool _az_token_expired(_az_token const* token);
 
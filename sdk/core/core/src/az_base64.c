@@ -0,0 +1,251 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <az_precondition.h>
+#include <az_precondition_internal.h>
+#include <az_result.h>
+#include <az_span.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <_az_cfg.h>
+
+enum
+{
+  _az_BASE64_INVALID = 0xFF,
+  // Largest number of bytes whose encoded size fits in an int32_t.
+  _az_BASE64_MAX_DECODED_SIZE = (INT32_MAX / 4) * 3,
+};
+
+static uint8_t const _az_base64_alphabet[]
+    = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static uint8_t const _az_base64_url_alphabet[]
+    = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// Value of each character of _az_base64_alphabet, _az_BASE64_INVALID for any other character.
+static uint8_t const _az_base64_decode_table[256] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+  0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+  0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+  0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+// Value of each character of _az_base64_url_alphabet, _az_BASE64_INVALID for any other character.
+static uint8_t const _az_base64_url_decode_table[256] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF,
+  0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+  0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0x3F,
+  0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+  0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+AZ_NODISCARD static az_result _az_span_base64_encode(
+    az_span destination,
+    az_span source,
+    uint8_t const* alphabet,
+    bool pad,
+    az_span* out_span)
+{
+  int32_t const source_size = az_span_size(source);
+  int32_t const result_size = pad ? az_span_base64_encode_size(source_size)
+                                  : az_span_base64_url_encode_size(source_size);
+  AZ_RETURN_IF_NOT_ENOUGH_SIZE(destination, result_size);
+
+  uint8_t const* src = az_span_ptr(source);
+  uint8_t* dest = az_span_ptr(destination);
+
+  // Every 3 bytes become 4 characters of 6 bits each.
+  int32_t remaining = source_size;
+  for (; remaining >= 3; remaining -= 3)
+  {
+    uint32_t const bits = ((uint32_t)src[0] << 16) | ((uint32_t)src[1] << 8) | src[2];
+    dest[0] = alphabet[bits >> 18];
+    dest[1] = alphabet[(bits >> 12) & 0x3F];
+    dest[2] = alphabet[(bits >> 6) & 0x3F];
+    dest[3] = alphabet[bits & 0x3F];
+    src += 3;
+    dest += 4;
+  }
+
+  // The last 1 or 2 bytes become 2 or 3 characters, padded to 4 with '=' if requested.
+  if (remaining > 0)
+  {
+    uint32_t const bits = ((uint32_t)src[0] << 16) | (remaining == 2 ? (uint32_t)src[1] << 8 : 0);
+    *dest++ = alphabet[bits >> 18];
+    *dest++ = alphabet[(bits >> 12) & 0x3F];
+    if (remaining == 2)
+    {
+      *dest++ = alphabet[(bits >> 6) & 0x3F];
+    }
+    else if (pad)
+    {
+      *dest++ = '=';
+    }
+    if (pad)
+    {
+      *dest++ = '=';
+    }
+  }
+
+  *out_span = az_span_slice_to_end(destination, result_size);
+  return AZ_OK;
+}
+
+AZ_NODISCARD static az_result _az_span_base64_decode(
+    az_span destination,
+    az_span source,
+    uint8_t const* decode_table,
+    bool padding_required,
+    az_span* out_span)
+{
+  int32_t const source_size = az_span_size(source);
+  uint8_t const* src = az_span_ptr(source);
+
+  // Padding is only valid at the end of a 4-character block.
+  int32_t size = source_size;
+  while (size > 0 && source_size - size < 2 && src[size - 1] == '=')
+  {
+    size--;
+  }
+  bool const is_padded = size != source_size;
+  if (((padding_required || is_padded) && source_size % 4 != 0) || size % 4 == 1)
+  {
+    return AZ_ERROR_PARSER_UNEXPECTED_CHAR;
+  }
+
+  int32_t const result_size = az_span_base64_decode_size(source);
+  AZ_RETURN_IF_NOT_ENOUGH_SIZE(destination, result_size);
+
+  uint8_t* dest = az_span_ptr(destination);
+
+  // Every 4 characters become 3 bytes. Invalid characters are detected once per block, since
+  // _az_BASE64_INVALID is the only table value with any of the 2 high bits set.
+  int32_t remaining = size;
+  for (; remaining >= 4; remaining -= 4)
+  {
+    uint8_t const a = decode_table[src[0]];
+    uint8_t const b = decode_table[src[1]];
+    uint8_t const c = decode_table[src[2]];
+    uint8_t const d = decode_table[src[3]];
+    if (((a | b | c | d) & 0xC0) != 0)
+    {
+      return AZ_ERROR_PARSER_UNEXPECTED_CHAR;
+    }
+
+    uint32_t const bits = ((uint32_t)a << 18) | ((uint32_t)b << 12) | ((uint32_t)c << 6) | d;
+    dest[0] = (uint8_t)(bits >> 16);
+    dest[1] = (uint8_t)(bits >> 8);
+    dest[2] = (uint8_t)bits;
+    src += 4;
+    dest += 3;
+  }
+
+  // The last 2 or 3 characters become 1 or 2 bytes.
+  if (remaining > 0)
+  {
+    uint8_t const a = decode_table[src[0]];
+    uint8_t const b = decode_table[src[1]];
+    uint8_t const c = remaining == 3 ? decode_table[src[2]] : 0;
+    if (((a | b | c) & 0xC0) != 0)
+    {
+      return AZ_ERROR_PARSER_UNEXPECTED_CHAR;
+    }
+
+    uint32_t const bits = ((uint32_t)a << 18) | ((uint32_t)b << 12) | ((uint32_t)c << 6);
+    *dest++ = (uint8_t)(bits >> 16);
+    if (remaining == 3)
+    {
+      *dest++ = (uint8_t)(bits >> 8);
+    }
+  }
+
+  *out_span = az_span_slice_to_end(destination, result_size);
+  return AZ_OK;
+}
+
+AZ_NODISCARD int32_t az_span_base64_encode_size(int32_t source_size)
+{
+  _az_PRECONDITION_RANGE(0, source_size, _az_BASE64_MAX_DECODED_SIZE);
+  return ((source_size + 2) / 3) * 4;
+}
+
+AZ_NODISCARD int32_t az_span_base64_url_encode_size(int32_t source_size)
+{
+  _az_PRECONDITION_RANGE(0, source_size, _az_BASE64_MAX_DECODED_SIZE);
+  return (source_size / 3) * 4 + ((source_size % 3) * 4 + 2) / 3;
+}
+
+AZ_NODISCARD int32_t az_span_base64_decode_size(az_span source)
+{
+  int32_t size = az_span_size(source);
+  for (int32_t i = 0; i < 2 && size > 0 && az_span_ptr(source)[size - 1] == '='; i++)
+  {
+    size--;
+  }
+
+  // A trailing group of 2 or 3 characters holds 1 or 2 bytes.
+  return (size / 4) * 3 + ((size % 4) * 3) / 4;
+}
+
+AZ_NODISCARD az_result az_span_base64_encode(az_span destination, az_span source, az_span* out_span)
+{
+  _az_PRECONDITION_VALID_SPAN(destination, 0, true);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_span);
+
+  return _az_span_base64_encode(destination, source, _az_base64_alphabet, true, out_span);
+}
+
+AZ_NODISCARD az_result az_span_base64_decode(az_span destination, az_span source, az_span* out_span)
+{
+  _az_PRECONDITION_VALID_SPAN(destination, 0, true);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_span);
+
+  return _az_span_base64_decode(destination, source, _az_base64_decode_table, true, out_span);
+}
+
+AZ_NODISCARD az_result
+az_span_base64_url_encode(az_span destination, az_span source, az_span* out_span)
+{
+  _az_PRECONDITION_VALID_SPAN(destination, 0, true);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_span);
+
+  return _az_span_base64_encode(destination, source, _az_base64_url_alphabet, false, out_span);
+}
+
+AZ_NODISCARD az_result
+az_span_base64_url_decode(az_span destination, az_span source, az_span* out_span)
+{
+  _az_PRECONDITION_VALID_SPAN(destination, 0, true);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_span);
+
+  return _az_span_base64_decode(destination, source, _az_base64_url_decode_table, false, out_span);
+}
@@ -2,8 +2,14 @@
 // SPDX-License-Identifier: MIT
 
 #include <az_context.h>
+#include <az_platform_internal.h>
 
 #include <stddef.h>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif // _MSC_VER
 
 #include <_az_cfg.h>
 
@@ -11,13 +17,149 @@
 // never expires. Call az_context_cancel passing a pointer to this node to cancel the entire
 // application (which cancels all the child nodes).
 az_context az_context_app = {
-  ._internal
-  = { .parent = NULL, .expiration = _az_CONTEXT_MAX_EXPIRATION, .key = NULL, .value = NULL }
+  ._internal = {
+    .parent = NULL,
+    .expiration = _az_CONTEXT_MAX_EXPIRATION,
+    .key = NULL,
+    .value = NULL,
+    .effective_expiration = _az_CONTEXT_MAX_EXPIRATION,
+    .cancel_generation = 0,
+    .value_cache_count = 0,
+    .value_cache_complete = true,
+  },
 };
 
-// Returns the soonest expiration time of this az_context node or any of its parent nodes.
+// Bumped by every az_context_cancel. Canceling a node changes the effective expiration of all its
+// descendants, which it can't reach, so they compare this against the generation their cached
+// value was computed at instead.
+//
+// The generation is process-wide: a node can't tell which nodes were canceled, so once any context
+// is canceled, every node created before (related or not) walks its parent chain for good. The
+// nodes created after are cached again. Per-request contexts are short-lived, so in practice only
+// the long-lived parents near the root walk, and their chains are short.
+static uint32_t _az_context_cancel_generation = 0;
+
+// Contexts are canceled from any thread, so the generation is only accessed through these.
+AZ_NODISCARD AZ_INLINE uint32_t _az_context_load_cancel_generation()
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_load_n(&_az_context_cancel_generation, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER) // !__GNUC__ !__clang__
+  return (uint32_t)_InterlockedOr((long volatile*)&_az_context_cancel_generation, 0);
+#else // !__GNUC__ !__clang__ !_MSC_VER
+  return *(uint32_t volatile*)&_az_context_cancel_generation;
+#endif // __GNUC__ || __clang__
+}
+
+// Returns the new generation.
+AZ_INLINE uint32_t _az_context_increment_cancel_generation()
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_add_fetch(&_az_context_cancel_generation, 1, __ATOMIC_ACQ_REL);
+#elif defined(_MSC_VER) // !__GNUC__ !__clang__
+  return (uint32_t)_InterlockedIncrement((long volatile*)&_az_context_cancel_generation);
+#else // !__GNUC__ !__clang__ !_MSC_VER
+  // Without atomics, a concurrent cancel can be lost; single-threaded builds are unaffected.
+  uint32_t volatile* const generation = &_az_context_cancel_generation;
+  return ++*generation;
+#endif // __GNUC__ || __clang__
+}
+
+static AZ_NODISCARD az_context
+_az_context_create(az_context const* parent, int64_t expiration, void* key, void* value)
+{
+  parent = (parent != NULL) ? parent : &az_context_app;
+
+  // Read the generation before the parent's expiration, so a concurrent cancel leaves the new node
+  // with a stale generation (and a walk of the chain) rather than with a stale expiration.
+  uint32_t const cancel_generation = _az_context_load_cancel_generation();
+  int64_t const parent_expiration = az_context_get_expiration(parent);
+
+  az_context context = { ._internal = {
+                             .parent = parent,
+                             .expiration = expiration,
+                             .key = key,
+                             .value = value,
+                             .effective_expiration
+                             = expiration < parent_expiration ? expiration : parent_expiration,
+                             .cancel_generation = cancel_generation,
+                             .value_cache_count = 0,
+                             .value_cache_complete = parent->_internal.value_cache_complete,
+                         } };
+
+  int32_t count = 0;
+  if (key != NULL)
+  {
+    context._internal.value_cache[count].key = key;
+    context._internal.value_cache[count].value = value;
+    ++count;
+  }
+
+  for (int32_t i = 0; i < parent->_internal.value_cache_count; ++i)
+  {
+    if (key != NULL && parent->_internal.value_cache[i].key == key)
+    {
+      continue; // Shadowed by this node
+    }
+
+    if (count == _az_CONTEXT_VALUE_CACHE_SIZE)
+    {
+      context._internal.value_cache_complete = false;
+      break;
+    }
+
+    context._internal.value_cache[count] = parent->_internal.value_cache[i];
+    ++count;
+  }
+
+  context._internal.value_cache_count = count;
+  return context;
+}
+
+AZ_NODISCARD az_context az_context_with_expiration(az_context const* parent, int64_t expiration)
+{
+  return _az_context_create(parent, expiration, NULL, NULL);
+}
+
+AZ_NODISCARD az_context az_context_with_value(az_context const* parent, void* key, void* value)
+{
+  return _az_context_create(parent, _az_CONTEXT_MAX_EXPIRATION, key, value);
+}
+
+// Cancels this az_context node and all its children, then wakes up whoever waits on any of them so
+// they notice the cancellation rather than waiting out their delay.
+void az_context_cancel(az_context* context)
+{
+  context = ((context != NULL) ? context : &az_context_app);
+
+  // Canceling a node again changes nobody's expiration, so the cached values stay good.
+  if (context->_internal.expiration == 0)
+  {
+    az_platform_wait_notify_all();
+    return;
+  }
+
+  context->_internal.expiration = 0; // The beginning of time
+  uint32_t const cancel_generation = _az_context_increment_cancel_generation();
+
+  // Nothing expires sooner, so this node's own cached value is right whatever its parents hold.
+  context->_internal.effective_expiration = 0;
+  context->_internal.cancel_generation = cancel_generation;
+
+  az_platform_wait_notify_all();
+}
+
+// Returns the soonest expiration time of this az_context node or any of its parent nodes. That was
+// computed when the node was created; the parent chain is only walked again if a context has been
+// canceled since.
 AZ_NODISCARD int64_t az_context_get_expiration(az_context const* context)
 {
+  if (context != NULL
+      && context->_internal.cancel_generation == _az_context_load_cancel_generation())
+  {
+    return context->_internal.effective_expiration;
+  }
+
   int64_t expiration = _az_CONTEXT_MAX_EXPIRATION;
   for (; context != NULL; context = context->_internal.parent)
   {
@@ -29,9 +171,28 @@ AZ_NODISCARD int64_t az_context_get_expiration(az_context const* context)
 
 // Walks up this az_context node's parent until it find a node whose key matches the specified key
 // and return the corresponding value. Returns AZ_ERROR_ITEM_NOT_FOUND is there are no nodes
-// matching the specified key.
+// matching the specified key. The nearest keys are cached in the node, so the walk is only needed
+// for keys further up than that.
 AZ_NODISCARD az_result az_context_get_value(az_context const* context, void* key, void** out_value)
 {
+  if (context != NULL && key != NULL)
+  {
+    for (int32_t i = 0; i < context->_internal.value_cache_count; ++i)
+    {
+      if (context->_internal.value_cache[i].key == key)
+      {
+        *out_value = context->_internal.value_cache[i].value;
+        return AZ_OK;
+      }
+    }
+
+    if (context->_internal.value_cache_complete)
+    {
+      *out_value = NULL;
+      return AZ_ERROR_ITEM_NOT_FOUND;
+    }
+  }
+
   for (; context != NULL; context = context->_internal.parent)
   {
     if (context->_internal.key == key)
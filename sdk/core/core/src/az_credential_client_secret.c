@@ -15,13 +15,18 @@ static AZ_NODISCARD az_result _az_credential_client_secret_request_token(
     az_credential_client_secret* credential,
     az_context* context)
 {
-  uint8_t url_buf[_az_AAD_REQUEST_URL_BUF_SIZE] = { 0 };
-  az_span url_span = AZ_SPAN_FROM_BUFFER(url_buf);
+  // The URL, headers, body and response all come from one buffer.
+  uint8_t buf[_az_AAD_BUF_SIZE];
+  az_span_arena arena;
+  AZ_RETURN_IF_FAILED(az_span_arena_init(&arena, AZ_SPAN_FROM_BUFFER(buf)));
+
+  az_span url_span;
+  AZ_RETURN_IF_FAILED(az_span_arena_alloc(&arena, _az_AAD_REQUEST_URL_BUF_SIZE, &url_span));
   az_span url;
   AZ_RETURN_IF_FAILED(_az_aad_build_url(url_span, credential->_internal.tenant_id, &url));
 
-  uint8_t body_buf[_az_AAD_REQUEST_BODY_BUF_SIZE] = { 0 };
-  az_span body = AZ_SPAN_FROM_BUFFER(body_buf);
+  az_span body;
+  AZ_RETURN_IF_FAILED(az_span_arena_alloc(&arena, _az_AAD_REQUEST_BODY_BUF_SIZE, &body));
   AZ_RETURN_IF_FAILED(_az_aad_build_body(
       body,
       credential->_internal.client_id,
@@ -29,12 +34,13 @@ static AZ_NODISCARD az_result _az_credential_client_secret_request_token(
       credential->_internal.client_secret,
       &body));
 
-  uint8_t header_buf[_az_AAD_REQUEST_HEADER_BUF_SIZE];
+  az_span header_buf;
+  AZ_RETURN_IF_FAILED(az_span_arena_alloc(&arena, _az_AAD_REQUEST_HEADER_BUF_SIZE, &header_buf));
   _az_http_request request = { 0 };
   AZ_RETURN_IF_FAILED(az_http_request_init(
-      &request, context, az_http_method_post(), url_span, az_span_size(url), AZ_SPAN_FROM_BUFFER(header_buf), body));
+      &request, context, az_http_method_post(), url_span, az_span_size(url), header_buf, body));
 
-  return _az_aad_request_token(&request, &credential->_internal.token);
+  return _az_aad_request_token(&request, &arena, &credential->_internal.token);
 }
 
 // This gets called from the http credential policy
@@ -51,7 +57,7 @@ static AZ_NODISCARD az_result _az_credential_client_secret_apply(
 
   int16_t const token_length = credential->_internal.token._internal.token_length;
 
-  AZ_RETURN_IF_FAILED(az_http_request_append_header(
+  AZ_RETURN_IF_FAILED(az_http_request_set_header(
       ref_request,
       AZ_SPAN_FROM_STR("authorization"),
       az_span_init(credential->_internal.token._internal.token, token_length)));
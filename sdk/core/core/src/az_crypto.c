@@ -0,0 +1,290 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <az_crypto_internal.h>
+#include <az_precondition.h>
+#include <az_precondition_internal.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <_az_cfg.h>
+
+enum
+{
+  _az_HMAC_IPAD = 0x36,
+  _az_HMAC_OPAD = 0x5C,
+};
+
+void _az_crypto_wipe(void* ptr, size_t size)
+{
+  volatile uint8_t* bytes = (volatile uint8_t*)ptr;
+  while (size-- > 0)
+  {
+    *bytes++ = 0;
+  }
+}
+
+static uint32_t const _az_sha256_initial_state[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static uint32_t const _az_sha256_round_constants[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+AZ_INLINE uint32_t _az_rotr32(uint32_t value, int shift)
+{
+  return (value >> shift) | (value << (32 - shift));
+}
+
+AZ_INLINE uint32_t _az_load_be32(uint8_t const* bytes)
+{
+  return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8)
+      | (uint32_t)bytes[3];
+}
+
+AZ_INLINE void _az_store_be32(uint8_t* bytes, uint32_t value)
+{
+  bytes[0] = (uint8_t)(value >> 24);
+  bytes[1] = (uint8_t)(value >> 16);
+  bytes[2] = (uint8_t)(value >> 8);
+  bytes[3] = (uint8_t)value;
+}
+
+// Processes \p block_count consecutive 64-byte blocks. The message schedule is kept in a 16-word
+// ring, rather than expanded to 64 words up front, to keep the stack footprint small.
+static void _az_sha256_compress(uint32_t state[8], uint8_t const* blocks, int32_t block_count)
+{
+  for (int32_t n = 0; n < block_count; n++, blocks += _az_SHA256_BLOCK_SIZE)
+  {
+    uint32_t w[16];
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+    uint32_t e = state[4];
+    uint32_t f = state[5];
+    uint32_t g = state[6];
+    uint32_t h = state[7];
+
+    for (int32_t i = 0; i < 64; i++)
+    {
+      uint32_t word;
+      if (i < 16)
+      {
+        word = _az_load_be32(blocks + (4 * i));
+      }
+      else
+      {
+        uint32_t const w15 = w[(i - 15) & 15];
+        uint32_t const w2 = w[(i - 2) & 15];
+        word = w[i & 15] + (_az_rotr32(w15, 7) ^ _az_rotr32(w15, 18) ^ (w15 >> 3)) + w[(i - 7) & 15]
+            + (_az_rotr32(w2, 17) ^ _az_rotr32(w2, 19) ^ (w2 >> 10));
+      }
+      w[i & 15] = word;
+
+      uint32_t const t1 = h + (_az_rotr32(e, 6) ^ _az_rotr32(e, 11) ^ _az_rotr32(e, 25))
+          + ((e & f) ^ (~e & g)) + _az_sha256_round_constants[i] + word;
+      uint32_t const t2 = (_az_rotr32(a, 2) ^ _az_rotr32(a, 13) ^ _az_rotr32(a, 22))
+          + ((a & b) ^ (a & c) ^ (b & c));
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+  }
+}
+
+void _az_sha256_init(_az_sha256* out_sha256)
+{
+  _az_PRECONDITION_NOT_NULL(out_sha256);
+
+  memcpy(
+      out_sha256->_internal.state, _az_sha256_initial_state, sizeof(_az_sha256_initial_state));
+  out_sha256->_internal.length = 0;
+}
+
+void _az_sha256_update(_az_sha256* sha256, az_span bytes)
+{
+  _az_PRECONDITION_NOT_NULL(sha256);
+  _az_PRECONDITION_VALID_SPAN(bytes, 0, true);
+
+  uint8_t const* data = az_span_ptr(bytes);
+  int32_t size = az_span_size(bytes);
+  int32_t const buffered = (int32_t)(sha256->_internal.length % _az_SHA256_BLOCK_SIZE);
+  sha256->_internal.length += (uint64_t)size;
+
+  // Complete the partially filled block first.
+  if (buffered > 0)
+  {
+    int32_t const needed = _az_SHA256_BLOCK_SIZE - buffered;
+    if (size < needed)
+    {
+      memcpy(sha256->_internal.block + buffered, data, (size_t)size);
+      return;
+    }
+
+    memcpy(sha256->_internal.block + buffered, data, (size_t)needed);
+    _az_sha256_compress(sha256->_internal.state, sha256->_internal.block, 1);
+    data += needed;
+    size -= needed;
+  }
+
+  // Whole blocks are compressed straight from the input, without copying them.
+  int32_t const block_count = size / _az_SHA256_BLOCK_SIZE;
+  _az_sha256_compress(sha256->_internal.state, data, block_count);
+  data += block_count * _az_SHA256_BLOCK_SIZE;
+  size -= block_count * _az_SHA256_BLOCK_SIZE;
+
+  if (size > 0)
+  {
+    memcpy(sha256->_internal.block, data, (size_t)size);
+  }
+}
+
+// Pads the message as per FIPS 180-4 (section 5.1.1), and writes the big-endian state.
+static void _az_sha256_finish(uint32_t state[8], uint8_t block[64], uint64_t length, uint8_t* hash)
+{
+  int32_t buffered = (int32_t)(length % _az_SHA256_BLOCK_SIZE);
+  block[buffered++] = 0x80;
+
+  // The 64-bit message length must fit after the 0x80 byte, otherwise an extra block is needed.
+  if (buffered > _az_SHA256_BLOCK_SIZE - 8)
+  {
+    memset(block + buffered, 0, (size_t)(_az_SHA256_BLOCK_SIZE - buffered));
+    _az_sha256_compress(state, block, 1);
+    buffered = 0;
+  }
+
+  memset(block + buffered, 0, (size_t)(_az_SHA256_BLOCK_SIZE - 8 - buffered));
+  uint64_t const bit_length = length * 8;
+  _az_store_be32(block + _az_SHA256_BLOCK_SIZE - 8, (uint32_t)(bit_length >> 32));
+  _az_store_be32(block + _az_SHA256_BLOCK_SIZE - 4, (uint32_t)bit_length);
+  _az_sha256_compress(state, block, 1);
+
+  for (int32_t i = 0; i < 8; i++)
+  {
+    _az_store_be32(hash + (4 * i), state[i]);
+  }
+}
+
+AZ_NODISCARD az_result _az_sha256_final(_az_sha256* sha256, az_span destination, az_span* out_hash)
+{
+  _az_PRECONDITION_NOT_NULL(sha256);
+  _az_PRECONDITION_NOT_NULL(out_hash);
+
+  AZ_RETURN_IF_NOT_ENOUGH_SIZE(destination, _az_SHA256_HASH_SIZE);
+
+  _az_sha256_finish(
+      sha256->_internal.state,
+      sha256->_internal.block,
+      sha256->_internal.length,
+      az_span_ptr(destination));
+
+  *out_hash = az_span_slice(destination, 0, _az_SHA256_HASH_SIZE);
+  return AZ_OK;
+}
+
+// Hashes the one block formed by \p key XOR \p pad, which is where both HMAC passes start from.
+static void _az_hmac_sha256_pad_state(
+    uint8_t const key[_az_SHA256_BLOCK_SIZE],
+    uint8_t pad,
+    uint32_t out_state[8])
+{
+  uint8_t block[_az_SHA256_BLOCK_SIZE];
+  for (int32_t i = 0; i < _az_SHA256_BLOCK_SIZE; i++)
+  {
+    block[i] = (uint8_t)(key[i] ^ pad);
+  }
+
+  memcpy(out_state, _az_sha256_initial_state, sizeof(_az_sha256_initial_state));
+  _az_sha256_compress(out_state, block, 1);
+
+  _az_crypto_wipe(block, sizeof(block));
+}
+
+void _az_hmac_sha256_key_init(_az_hmac_sha256_key* out_key, az_span key)
+{
+  _az_PRECONDITION_NOT_NULL(out_key);
+  _az_PRECONDITION_VALID_SPAN(key, 0, true);
+
+  uint8_t key_block[_az_SHA256_BLOCK_SIZE] = { 0 };
+  if (az_span_size(key) > _az_SHA256_BLOCK_SIZE)
+  {
+    _az_sha256 sha256;
+    _az_sha256_init(&sha256);
+    _az_sha256_update(&sha256, key);
+    _az_sha256_finish(
+        sha256._internal.state, sha256._internal.block, sha256._internal.length, key_block);
+    _az_crypto_wipe(&sha256, sizeof(sha256));
+  }
+  else if (az_span_size(key) > 0)
+  {
+    memcpy(key_block, az_span_ptr(key), (size_t)az_span_size(key));
+  }
+
+  _az_hmac_sha256_pad_state(key_block, _az_HMAC_IPAD, out_key->_internal.inner_state);
+  _az_hmac_sha256_pad_state(key_block, _az_HMAC_OPAD, out_key->_internal.outer_state);
+
+  _az_crypto_wipe(key_block, sizeof(key_block));
+}
+
+AZ_NODISCARD az_result _az_hmac_sha256_sign(
+    _az_hmac_sha256_key const* key,
+    az_span bytes_to_sign,
+    az_span destination,
+    az_span* out_signature)
+{
+  _az_PRECONDITION_NOT_NULL(key);
+  _az_PRECONDITION_VALID_SPAN(bytes_to_sign, 0, true);
+  _az_PRECONDITION_NOT_NULL(out_signature);
+
+  AZ_RETURN_IF_NOT_ENOUGH_SIZE(destination, _az_SHA256_HASH_SIZE);
+
+  // Both passes resume right after the precomputed pad block.
+  _az_sha256 sha256;
+  memcpy(sha256._internal.state, key->_internal.inner_state, sizeof(key->_internal.inner_state));
+  sha256._internal.length = _az_SHA256_BLOCK_SIZE;
+  _az_sha256_update(&sha256, bytes_to_sign);
+
+  uint8_t inner_hash[_az_SHA256_HASH_SIZE];
+  _az_sha256_finish(
+      sha256._internal.state, sha256._internal.block, sha256._internal.length, inner_hash);
+
+  memcpy(sha256._internal.state, key->_internal.outer_state, sizeof(key->_internal.outer_state));
+  sha256._internal.length = _az_SHA256_BLOCK_SIZE;
+  _az_sha256_update(&sha256, AZ_SPAN_FROM_BUFFER(inner_hash));
+  _az_sha256_finish(
+      sha256._internal.state,
+      sha256._internal.block,
+      sha256._internal.length,
+      az_span_ptr(destination));
+
+  // The intermediate state would let the signature of other messages be computed.
+  _az_crypto_wipe(&sha256, sizeof(sha256));
+  _az_crypto_wipe(inner_hash, sizeof(inner_hash));
+
+  *out_signature = az_span_slice(destination, 0, _az_SHA256_HASH_SIZE);
+  return AZ_OK;
+}
@@ -6,36 +6,48 @@
 #include <az_credentials.h>
 #include <az_http.h>
 #include <az_http_internal.h>
+#include <az_precondition_internal.h>
 #include <az_span.h>
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include <_az_cfg.h>
 
 static const az_span AZ_HTTP_HEADER_USER_AGENT = AZ_SPAN_LITERAL_FROM_STR("User-Agent");
+static const az_span AZ_HTTP_HEADER_CONTENT_ENCODING
+    = AZ_SPAN_LITERAL_FROM_STR("Content-Encoding");
 
-AZ_NODISCARD az_result az_http_pipeline_policy_apiversion(
-    _az_http_policy* p_policies,
-    void* p_data,
+static AZ_NODISCARD az_result _az_http_request_add_apiversion(
     _az_http_request* p_request,
-    az_http_response* p_response)
+    _az_http_policy_apiversion_options const* options)
 {
-
-  _az_http_policy_apiversion_options* options = (_az_http_policy_apiversion_options*)(p_data);
-
   switch (options->_internal.option_location)
   {
     case _az_http_policy_apiversion_option_location_header:
       // Add the version as a header
-      AZ_RETURN_IF_FAILED(az_http_request_append_header(
-          p_request, options->_internal.name, options->_internal.version));
-      break;
+      return az_http_request_append_header(
+          p_request, options->_internal.name, options->_internal.version);
     case _az_http_policy_apiversion_option_location_queryparameter:
       // Add the version as a query parameter
-      AZ_RETURN_IF_FAILED(az_http_request_set_query_parameter(
-          p_request, options->_internal.name, options->_internal.version));
-      break;
+      return az_http_request_set_query_parameter(
+          p_request, options->_internal.name, options->_internal.version);
     default:
       return AZ_ERROR_ARG;
   }
+}
+
+AZ_NODISCARD az_result az_http_pipeline_policy_apiversion(
+    _az_http_policy* p_policies,
+    void* p_data,
+    _az_http_request* p_request,
+    az_http_response* p_response)
+{
+
+  _az_http_policy_apiversion_options* options = (_az_http_policy_apiversion_options*)(p_data);
+
+  AZ_RETURN_IF_FAILED(_az_http_request_add_apiversion(p_request, options));
 
   return az_http_pipeline_nextpolicy(p_policies, p_request, p_response);
 }
@@ -55,6 +67,176 @@ AZ_NODISCARD az_result az_http_pipeline_policy_telemetry(
   return az_http_pipeline_nextpolicy(p_policies, p_request, p_response);
 }
 
+AZ_NODISCARD az_result _az_http_policy_compression_options_init(
+    _az_http_policy_compression_options* out_options,
+    _az_http_policy_compression_fn compress,
+    void* compress_context,
+    az_span content_encoding,
+    int32_t min_body_size,
+    az_span_arena* scratch)
+{
+  _az_PRECONDITION_NOT_NULL(out_options);
+  _az_PRECONDITION_NOT_NULL(compress);
+  _az_PRECONDITION_VALID_SPAN(content_encoding, 1, false);
+  _az_PRECONDITION(min_body_size >= 0);
+  _az_PRECONDITION_NOT_NULL(scratch);
+
+  *out_options = (_az_http_policy_compression_options){
+    ._internal = {
+      .compress = compress,
+      .compress_context = compress_context,
+      .content_encoding = content_encoding,
+      .min_body_size = min_body_size,
+      .scratch = scratch,
+    },
+  };
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_pipeline_policy_compression(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response)
+{
+  _az_http_policy_compression_options* options = (_az_http_policy_compression_options*)(p_options);
+
+  int32_t const body_size = az_http_request_body_size(p_request);
+  az_span content_encoding = { 0 };
+
+  // Leave small bodies, and bodies the caller already encoded, as they are.
+  if (body_size == 0 || body_size < options->_internal.min_body_size
+      || az_http_request_get_header_by_name(
+             p_request, AZ_HTTP_HEADER_CONTENT_ENCODING, &content_encoding)
+          == AZ_OK)
+  {
+    return az_http_pipeline_nextpolicy(p_policies, p_request, p_response);
+  }
+
+  az_span_arena* const scratch = options->_internal.scratch;
+  int32_t const mark = az_span_arena_mark(scratch);
+
+  // Only a smaller body is worth sending, so that is all the room the compressor gets.
+  int32_t const remaining = az_span_arena_remaining(scratch);
+  az_span destination = { 0 };
+  az_result const alloc_result = az_span_arena_alloc(
+      scratch, remaining < body_size ? remaining : body_size - 1, &destination);
+
+  // A full arena may not even have room for the alignment padding.
+  az_span compressed = { 0 };
+  az_result const compress_result = az_failed(alloc_result)
+      ? alloc_result
+      : options->_internal.compress(
+          options->_internal.compress_context, p_request, destination, &compressed);
+  if (compress_result == AZ_ERROR_INSUFFICIENT_SPAN_SIZE)
+  {
+    az_span_arena_reset(scratch, mark);
+    return az_http_pipeline_nextpolicy(p_policies, p_request, p_response);
+  }
+
+  if (az_failed(compress_result))
+  {
+    az_span_arena_reset(scratch, mark);
+    return compress_result;
+  }
+
+  az_result result = az_http_request_append_header(
+      p_request, AZ_HTTP_HEADER_CONTENT_ENCODING, options->_internal.content_encoding);
+  if (az_failed(result))
+  {
+    az_span_arena_reset(scratch, mark);
+    return result;
+  }
+
+  az_span const body = p_request->_internal.body;
+  az_span_list const* const body_list = p_request->_internal.body_list;
+  p_request->_internal.body = compressed;
+  p_request->_internal.body_list = NULL;
+
+  result = az_http_pipeline_nextpolicy(p_policies, p_request, p_response);
+
+  // Give the request back its original body, and the arena back its space.
+  p_request->_internal.body = body;
+  p_request->_internal.body_list = body_list;
+  az_result const remove_result
+      = az_http_request_remove_header(p_request, AZ_HTTP_HEADER_CONTENT_ENCODING);
+  az_span_arena_reset(scratch, mark);
+
+  return az_failed(result) ? result : remove_result;
+}
+
+AZ_NODISCARD void* _az_http_endpoint_find(
+    void* endpoints,
+    size_t endpoint_size,
+    int32_t count,
+    uint32_t authority_hash,
+    _az_http_endpoint_is_idle_fn is_idle,
+    void const* is_idle_context,
+    bool* out_is_new)
+{
+  _az_PRECONDITION_NOT_NULL(endpoints);
+  _az_PRECONDITION(count > 0);
+  _az_PRECONDITION_NOT_NULL(is_idle);
+  _az_PRECONDITION_NOT_NULL(out_is_new);
+
+  _az_http_endpoint_slot* free_slot = NULL;
+  _az_http_endpoint_slot* idle_slot = NULL;
+  int32_t const start = (int32_t)(authority_hash % (uint32_t)count);
+  for (int32_t i = 0; i < count; ++i)
+  {
+    uint8_t* const endpoint = (uint8_t*)endpoints + (size_t)((start + i) % count) * endpoint_size;
+    _az_http_endpoint_slot* const slot = (_az_http_endpoint_slot*)(void*)endpoint;
+    if (!slot->in_use)
+    {
+      if (free_slot == NULL)
+      {
+        free_slot = slot;
+      }
+    }
+    else if (slot->authority_hash == authority_hash)
+    {
+      *out_is_new = false;
+      return slot;
+    }
+    else if (idle_slot == NULL && is_idle(slot, is_idle_context))
+    {
+      idle_slot = slot;
+    }
+  }
+
+  _az_http_endpoint_slot* const slot = free_slot != NULL ? free_slot : idle_slot;
+  if (slot != NULL)
+  {
+    slot->authority_hash = authority_hash;
+    slot->in_use = true;
+  }
+
+  *out_is_new = slot != NULL;
+  return slot;
+}
+
+AZ_NODISCARD az_result _az_http_request_template_add_apiversion(
+    _az_http_request_template* request_template,
+    _az_http_policy_apiversion_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(request_template);
+  _az_PRECONDITION_NOT_NULL(options);
+
+  return _az_http_request_add_apiversion(&request_template->_internal.request, options);
+}
+
+AZ_NODISCARD az_result _az_http_request_template_add_telemetry(
+    _az_http_request_template* request_template,
+    _az_http_policy_telemetry_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(request_template);
+  _az_PRECONDITION_NOT_NULL(options);
+
+  return _az_http_request_template_append_header(
+      request_template, AZ_HTTP_HEADER_USER_AGENT, options->os);
+}
+
 AZ_INLINE AZ_NODISCARD az_result
 _az_apply_credential(_az_credential* credential, _az_http_request* ref_request)
 {
@@ -0,0 +1,293 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_http_policy_private.h"
+#include <az_config.h>
+#include <az_http.h>
+#include <az_http_internal.h>
+#include <az_http_transport.h>
+#include <az_log_internal.h>
+#include <az_platform_internal.h>
+#include <az_precondition_internal.h>
+#include <az_span_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <_az_cfg.h>
+
+AZ_NODISCARD az_result _az_http_policy_circuit_breaker_options_init(
+    _az_http_policy_circuit_breaker_options* out_options,
+    struct az_platform_mtx* mutex,
+    int32_t window,
+    int32_t min_requests,
+    int32_t failure_percent,
+    int32_t open_duration_msec)
+{
+  _az_PRECONDITION_NOT_NULL(out_options);
+  _az_PRECONDITION_RANGE(1, window, _az_HTTP_CIRCUIT_BREAKER_WINDOW_MAX);
+  _az_PRECONDITION_RANGE(1, min_requests, window);
+  _az_PRECONDITION_RANGE(1, failure_percent, 100);
+  _az_PRECONDITION(open_duration_msec >= 0);
+
+  *out_options = (_az_http_policy_circuit_breaker_options){
+    ._internal = {
+      .endpoints = { { 0 } },
+      .mutex = mutex,
+      .window = window,
+      .min_requests = min_requests,
+      .failure_percent = failure_percent,
+      .open_duration_msec = open_duration_msec,
+    },
+  };
+
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result
+_az_http_circuit_breaker_lock(_az_http_policy_circuit_breaker_options* options)
+{
+  return options->_internal.mutex == NULL ? AZ_OK : az_platform_mtx_lock(options->_internal.mutex);
+}
+
+static AZ_NODISCARD az_result
+_az_http_circuit_breaker_unlock(_az_http_policy_circuit_breaker_options* options)
+{
+  return options->_internal.mutex == NULL ? AZ_OK
+                                          : az_platform_mtx_unlock(options->_internal.mutex);
+}
+
+static AZ_NODISCARD bool _az_http_circuit_breaker_has_failed(
+    az_result result,
+    az_http_response const* response)
+{
+  if (az_failed(result))
+  {
+    // The caller gave up on the request, which says nothing about the endpoint.
+    return result != AZ_ERROR_CANCELED;
+  }
+
+  az_http_response response_copy = *response;
+  az_http_response_status_line status_line = { 0 };
+  if (az_failed(az_http_response_get_status_line(&response_copy, &status_line)))
+  {
+    return true;
+  }
+
+  return status_line.status_code == AZ_HTTP_STATUS_CODE_REQUEST_TIMEOUT
+      || status_line.status_code >= AZ_HTTP_STATUS_CODE_INTERNAL_SERVER_ERROR;
+}
+
+// An endpoint whose circuit is closed, with no request in flight, only has recent outcomes to
+// lose.
+static AZ_NODISCARD bool _az_http_circuit_breaker_is_idle(
+    void const* endpoint,
+    void const* is_idle_context)
+{
+  (void)is_idle_context;
+  _az_http_circuit_endpoint const* const circuit = (_az_http_circuit_endpoint const*)endpoint;
+  return circuit->state == _az_HTTP_CIRCUIT_STATE_CLOSED && circuit->in_flight == 0;
+}
+
+AZ_NODISCARD AZ_INLINE int32_t _az_http_circuit_breaker_count_bits(uint32_t bits)
+{
+  int32_t count = 0;
+  for (; bits != 0; bits &= bits - 1)
+  {
+    ++count;
+  }
+  return count;
+}
+
+static void _az_http_circuit_breaker_log(az_span authority, az_span transition)
+{
+  uint8_t log_msg_buf[AZ_LOG_MSG_BUF_SIZE] = { 0 };
+  az_span const log_msg = AZ_SPAN_FROM_BUFFER(log_msg_buf);
+
+  az_span const prefix = AZ_SPAN_FROM_STR("HTTP circuit for ");
+  if (az_span_size(log_msg) < az_span_size(prefix) + az_span_size(authority) + 1
+          + az_span_size(transition))
+  {
+    return;
+  }
+
+  az_span remainder = az_span_copy(log_msg, prefix);
+  remainder = az_span_copy(remainder, authority);
+  remainder = az_span_copy_u8(remainder, ' ');
+  remainder = az_span_copy(remainder, transition);
+
+  az_log_write(
+      AZ_LOG_HTTP_CIRCUIT_BREAKER,
+      az_span_slice(log_msg, 0, az_span_size(log_msg) - az_span_size(remainder)));
+}
+
+// Records how the request sent through the closed circuit went, and returns the transition it
+// causes, if any.
+static AZ_NODISCARD az_span _az_http_circuit_breaker_record(
+    _az_http_policy_circuit_breaker_options const* options,
+    _az_http_circuit_endpoint* endpoint,
+    bool has_failed)
+{
+  // Another request opened the circuit while this one was in flight.
+  if (endpoint->state != _az_HTTP_CIRCUIT_STATE_CLOSED)
+  {
+    return AZ_SPAN_NULL;
+  }
+
+  int32_t const window = options->_internal.window;
+  uint32_t const window_mask
+      = window < _az_HTTP_CIRCUIT_BREAKER_WINDOW_MAX ? (1u << window) - 1 : UINT32_MAX;
+
+  endpoint->outcomes = ((endpoint->outcomes << 1) | (has_failed ? 1u : 0u)) & window_mask;
+  if (endpoint->outcomes_count < window)
+  {
+    ++endpoint->outcomes_count;
+  }
+
+  int32_t const failures = _az_http_circuit_breaker_count_bits(endpoint->outcomes);
+  if (endpoint->outcomes_count < options->_internal.min_requests
+      || failures * 100 < options->_internal.failure_percent * endpoint->outcomes_count)
+  {
+    return AZ_SPAN_NULL;
+  }
+
+  endpoint->state = _az_HTTP_CIRCUIT_STATE_OPEN;
+  endpoint->opened_at_msec = az_platform_clock_msec();
+  return AZ_SPAN_FROM_STR("opened.");
+}
+
+// Ends the probe, and returns the transition it causes, if any.
+static AZ_NODISCARD az_span _az_http_circuit_breaker_end_probe(
+    _az_http_circuit_endpoint* endpoint,
+    az_result result,
+    az_http_response const* response)
+{
+  endpoint->probing = false;
+
+  // The caller gave up on the probe: the circuit stays half-open, and the next request probes.
+  if (result == AZ_ERROR_CANCELED)
+  {
+    return AZ_SPAN_NULL;
+  }
+
+  if (_az_http_circuit_breaker_has_failed(result, response))
+  {
+    endpoint->state = _az_HTTP_CIRCUIT_STATE_OPEN;
+    endpoint->opened_at_msec = az_platform_clock_msec();
+    return AZ_SPAN_FROM_STR("opened again.");
+  }
+
+  endpoint->state = _az_HTTP_CIRCUIT_STATE_CLOSED;
+  endpoint->outcomes = 0;
+  endpoint->outcomes_count = 0;
+  return AZ_SPAN_FROM_STR("closed.");
+}
+
+AZ_NODISCARD az_result az_http_pipeline_policy_circuit_breaker(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response)
+{
+  _az_http_policy_circuit_breaker_options* const options
+      = (_az_http_policy_circuit_breaker_options*)p_options;
+
+  az_span url = { 0 };
+  AZ_RETURN_IF_FAILED(az_http_request_get_url(p_request, &url));
+  az_span const authority = _az_http_url_get_authority(url);
+  uint32_t const authority_hash = _az_span_hash_ignoring_case(authority);
+
+  AZ_RETURN_IF_FAILED(_az_http_circuit_breaker_lock(options));
+
+  bool is_new = false;
+  _az_http_circuit_endpoint* const endpoint
+      = (_az_http_circuit_endpoint*)_az_http_endpoint_find(
+          options->_internal.endpoints,
+          sizeof(options->_internal.endpoints[0]),
+          _az_HTTP_CIRCUIT_BREAKER_ENDPOINTS,
+          authority_hash,
+          _az_http_circuit_breaker_is_idle,
+          NULL,
+          &is_new);
+  if (endpoint == NULL)
+  {
+    // Every slot is watching another endpoint, and none of them is forgotten for this one.
+    AZ_RETURN_IF_FAILED(_az_http_circuit_breaker_unlock(options));
+    return az_http_pipeline_nextpolicy(p_policies, p_request, p_response);
+  }
+
+  if (is_new)
+  {
+    // A new endpoint starts closed.
+    *endpoint = (_az_http_circuit_endpoint){ .slot = endpoint->slot };
+  }
+
+  bool const should_log = az_log_should_write(AZ_LOG_HTTP_CIRCUIT_BREAKER);
+
+  bool is_half_open = false;
+  if (endpoint->state == _az_HTTP_CIRCUIT_STATE_OPEN)
+  {
+    int64_t const open_msec = az_platform_clock_msec() - endpoint->opened_at_msec;
+    if (open_msec < options->_internal.open_duration_msec)
+    {
+      AZ_RETURN_IF_FAILED(_az_http_circuit_breaker_unlock(options));
+      return AZ_ERROR_HTTP_CIRCUIT_OPEN;
+    }
+
+    endpoint->state = _az_HTTP_CIRCUIT_STATE_HALF_OPEN;
+    endpoint->probing = false;
+    is_half_open = true;
+  }
+
+  // Only one request at a time finds out whether the endpoint is back.
+  bool const is_probe = endpoint->state == _az_HTTP_CIRCUIT_STATE_HALF_OPEN;
+  if (is_probe && endpoint->probing)
+  {
+    AZ_RETURN_IF_FAILED(_az_http_circuit_breaker_unlock(options));
+    return AZ_ERROR_HTTP_CIRCUIT_OPEN;
+  }
+
+  endpoint->probing = is_probe;
+  ++endpoint->in_flight;
+
+  // The slot isn't given to another endpoint while a request to this one is in flight, so it can
+  // be updated after the request without looking it up again.
+  az_result const unlock_result = _az_http_circuit_breaker_unlock(options);
+  if (az_failed(unlock_result))
+  {
+    // The request isn't sent, so it doesn't hold the slot or the probe.
+    --endpoint->in_flight;
+    endpoint->probing = false;
+    return unlock_result;
+  }
+
+  if (is_half_open && should_log)
+  {
+    _az_http_circuit_breaker_log(authority, AZ_SPAN_FROM_STR("is half-open."));
+  }
+
+  az_result const result = az_http_pipeline_nextpolicy(p_policies, p_request, p_response);
+
+  // The request is done even if the mutex fails: a request that stays in flight would keep the
+  // slot for good, and a probe that never ends would keep the circuit from closing.
+  az_result const lock_result = _az_http_circuit_breaker_lock(options);
+  --endpoint->in_flight;
+  if (az_failed(lock_result))
+  {
+    endpoint->probing = false;
+    return lock_result;
+  }
+
+  az_span const transition = is_probe
+      ? _az_http_circuit_breaker_end_probe(endpoint, result, p_response)
+      : _az_http_circuit_breaker_record(
+          options, endpoint, _az_http_circuit_breaker_has_failed(result, p_response));
+  AZ_RETURN_IF_FAILED(_az_http_circuit_breaker_unlock(options));
+
+  if (az_span_size(transition) > 0 && should_log)
+  {
+    _az_http_circuit_breaker_log(authority, transition);
+  }
+
+  return result;
+}
@@ -0,0 +1,383 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_http_policy_private.h"
+#include <az_config.h>
+#include <az_config_internal.h>
+#include <az_context.h>
+#include <az_http.h>
+#include <az_http_internal.h>
+#include <az_http_transport.h>
+#include <az_log_internal.h>
+#include <az_platform_internal.h>
+#include <az_precondition_internal.h>
+#include <az_span_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <_az_cfg.h>
+
+enum
+{
+  // The platform only has a process-wide wait, so waiters are woken up together when the next in
+  // line can go, and each checks whether it is its turn. They also check again after this long, in
+  // case that happened between their check and their wait.
+  _az_HTTP_CONCURRENCY_LIMITER_WAIT_MSEC = 10,
+};
+
+static void _az_http_concurrency_limiter_reset(
+    _az_http_policy_concurrency_limiter_options const* options,
+    _az_http_concurrency_endpoint* endpoint)
+{
+  *endpoint = (_az_http_concurrency_endpoint){
+    .slot = endpoint->slot,
+    .limit = options->_internal.initial_limit,
+    .baseline_latency_usec = -1,
+  };
+}
+
+AZ_NODISCARD az_result _az_http_policy_concurrency_limiter_options_init(
+    _az_http_policy_concurrency_limiter_options* out_options,
+    struct az_platform_mtx* mutex,
+    int32_t initial_limit,
+    int32_t min_limit,
+    int32_t max_limit,
+    int32_t latency_tolerance_percent)
+{
+  _az_PRECONDITION_NOT_NULL(out_options);
+  _az_PRECONDITION(min_limit >= 1);
+  _az_PRECONDITION(max_limit >= min_limit);
+  _az_PRECONDITION_RANGE(min_limit, initial_limit, max_limit);
+  _az_PRECONDITION(latency_tolerance_percent >= 100);
+
+  *out_options = (_az_http_policy_concurrency_limiter_options){
+    ._internal = {
+      .endpoints = { { 0 } },
+      .mutex = mutex,
+      .initial_limit = initial_limit,
+      .min_limit = min_limit,
+      .max_limit = max_limit,
+      .latency_tolerance_percent = latency_tolerance_percent,
+    },
+  };
+
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result
+_az_http_concurrency_limiter_lock(_az_http_policy_concurrency_limiter_options* options)
+{
+  return options->_internal.mutex == NULL ? AZ_OK : az_platform_mtx_lock(options->_internal.mutex);
+}
+
+static AZ_NODISCARD az_result
+_az_http_concurrency_limiter_unlock(_az_http_policy_concurrency_limiter_options* options)
+{
+  return options->_internal.mutex == NULL ? AZ_OK
+                                          : az_platform_mtx_unlock(options->_internal.mutex);
+}
+
+AZ_NODISCARD AZ_INLINE bool _az_http_concurrency_limiter_has_waiters(
+    _az_http_concurrency_endpoint const* endpoint)
+{
+  return endpoint->next_ticket != endpoint->now_serving;
+}
+
+// Whether the caller next in line can go now, which is when the waiters are woken up.
+AZ_NODISCARD AZ_INLINE bool _az_http_concurrency_limiter_can_admit_next(
+    _az_http_concurrency_endpoint const* endpoint)
+{
+  return _az_http_concurrency_limiter_has_waiters(endpoint)
+      && endpoint->in_flight < endpoint->limit;
+}
+
+// An endpoint with no request in flight or waiting only has its limit to lose.
+static AZ_NODISCARD bool _az_http_concurrency_limiter_is_idle(
+    void const* endpoint,
+    void const* is_idle_context)
+{
+  (void)is_idle_context;
+  _az_http_concurrency_endpoint const* const concurrency_endpoint
+      = (_az_http_concurrency_endpoint const*)endpoint;
+  return concurrency_endpoint->in_flight == 0
+      && !_az_http_concurrency_limiter_has_waiters(concurrency_endpoint);
+}
+
+// Moves on to the next ticket, skipping the ones whose callers gave up.
+static void _az_http_concurrency_limiter_advance(_az_http_concurrency_endpoint* endpoint)
+{
+  do
+  {
+    ++endpoint->now_serving;
+    endpoint->abandoned >>= 1;
+  } while ((endpoint->abandoned & 1u) != 0);
+}
+
+static void _az_http_concurrency_limiter_abandon(
+    _az_http_concurrency_endpoint* endpoint,
+    uint32_t ticket)
+{
+  uint32_t const offset = ticket - endpoint->now_serving;
+  if (offset == 0)
+  {
+    _az_http_concurrency_limiter_advance(endpoint);
+  }
+  else
+  {
+    endpoint->abandoned |= 1u << offset;
+  }
+}
+
+// Failures and responses that say the endpoint has more requests than it can handle.
+static AZ_NODISCARD bool _az_http_concurrency_limiter_is_overloaded(
+    az_result result,
+    az_http_response const* response)
+{
+  if (az_failed(result))
+  {
+    // The caller gave up on the request, which says nothing about the endpoint.
+    return result != AZ_ERROR_CANCELED;
+  }
+
+  az_http_response response_copy = *response;
+  az_http_response_status_line status_line = { 0 };
+  if (az_failed(az_http_response_get_status_line(&response_copy, &status_line)))
+  {
+    return false;
+  }
+
+  return status_line.status_code == AZ_HTTP_STATUS_CODE_REQUEST_TIMEOUT
+      || status_line.status_code == AZ_HTTP_STATUS_CODE_TOO_MANY_REQUESTS
+      || status_line.status_code == AZ_HTTP_STATUS_CODE_SERVICE_UNAVAILABLE;
+}
+
+static void _az_http_concurrency_limiter_adjust(
+    _az_http_policy_concurrency_limiter_options const* options,
+    _az_http_concurrency_endpoint* endpoint,
+    bool overloaded,
+    int32_t in_flight,
+    int64_t latency_msec)
+{
+  int32_t const min_limit = options->_internal.min_limit;
+
+  // Back off quickly when the endpoint pushes back.
+  if (overloaded)
+  {
+    endpoint->limit = endpoint->limit / 2 > min_limit ? endpoint->limit / 2 : min_limit;
+    endpoint->increase_credit = 0;
+    return;
+  }
+
+  // Slower responses only move the baseline a little each, so queuing barely shows in it, but an
+  // endpoint that got slower for good is not held to a latency it can no longer deliver.
+  int64_t const latency_usec = latency_msec * _az_TIME_MICROSECONDS_PER_MILLISECOND;
+  if (endpoint->baseline_latency_usec < 0 || latency_usec < endpoint->baseline_latency_usec)
+  {
+    endpoint->baseline_latency_usec = latency_usec;
+  }
+  else
+  {
+    endpoint->baseline_latency_usec += (latency_usec - endpoint->baseline_latency_usec)
+        / _az_HTTP_CONCURRENCY_LIMITER_BASELINE_DECAY;
+  }
+
+  // Responses slower than the baseline mean the requests queue up somewhere: past the knee of the
+  // latency curve, more requests at once only add latency.
+  int64_t const baseline_usec = endpoint->baseline_latency_usec > 0
+      ? endpoint->baseline_latency_usec
+      : _az_TIME_MICROSECONDS_PER_MILLISECOND;
+  if (latency_usec * 100 > baseline_usec * options->_internal.latency_tolerance_percent)
+  {
+    if (endpoint->limit > min_limit)
+    {
+      --endpoint->limit;
+    }
+    endpoint->increase_credit = 0;
+    return;
+  }
+
+  // Only grow a limit that is in use, or it would grow without ever being tested.
+  if (in_flight * 2 >= endpoint->limit && endpoint->limit < options->_internal.max_limit)
+  {
+    if (++endpoint->increase_credit >= endpoint->limit)
+    {
+      ++endpoint->limit;
+      endpoint->increase_credit = 0;
+    }
+  }
+}
+
+static void _az_http_concurrency_limiter_log(az_span authority, int32_t limit)
+{
+  uint8_t log_msg_buf[AZ_LOG_MSG_BUF_SIZE] = { 0 };
+  az_span const log_msg = AZ_SPAN_FROM_BUFFER(log_msg_buf);
+
+  az_span const prefix = AZ_SPAN_FROM_STR("HTTP concurrency limit for ");
+  az_span const infix = AZ_SPAN_FROM_STR(" is now ");
+  if (az_span_size(log_msg) < az_span_size(prefix) + az_span_size(authority) + az_span_size(infix)
+          + _az_INT64_AS_STR_BUF_SIZE + 1)
+  {
+    return;
+  }
+
+  az_span remainder = az_span_copy(log_msg, prefix);
+  remainder = az_span_copy(remainder, authority);
+  remainder = az_span_copy(remainder, infix);
+  if (az_failed(az_span_i32toa(remainder, limit, &remainder)))
+  {
+    return;
+  }
+  remainder = az_span_copy_u8(remainder, '.');
+
+  az_log_write(
+      AZ_LOG_HTTP_CONCURRENCY_LIMITER,
+      az_span_slice(log_msg, 0, az_span_size(log_msg) - az_span_size(remainder)));
+}
+
+AZ_NODISCARD az_result az_http_pipeline_policy_concurrency_limiter(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response)
+{
+  _az_http_policy_concurrency_limiter_options* const options
+      = (_az_http_policy_concurrency_limiter_options*)p_options;
+
+  az_span url = { 0 };
+  AZ_RETURN_IF_FAILED(az_http_request_get_url(p_request, &url));
+  az_span const authority = _az_http_url_get_authority(url);
+  uint32_t const authority_hash = _az_span_hash_ignoring_case(authority);
+
+  az_context* const context = p_request->_internal.context;
+
+  AZ_RETURN_IF_FAILED(_az_http_concurrency_limiter_lock(options));
+
+  bool is_new = false;
+  _az_http_concurrency_endpoint* const endpoint
+      = (_az_http_concurrency_endpoint*)_az_http_endpoint_find(
+          options->_internal.endpoints,
+          sizeof(options->_internal.endpoints[0]),
+          _az_HTTP_CONCURRENCY_LIMITER_ENDPOINTS,
+          authority_hash,
+          _az_http_concurrency_limiter_is_idle,
+          NULL,
+          &is_new);
+  if (endpoint == NULL)
+  {
+    // Every slot is limiting another endpoint, and none of them is forgotten for this one.
+    AZ_RETURN_IF_FAILED(_az_http_concurrency_limiter_unlock(options));
+    return az_http_pipeline_nextpolicy(p_policies, p_request, p_response);
+  }
+
+  if (is_new)
+  {
+    _az_http_concurrency_limiter_reset(options, endpoint);
+  }
+
+  // Wait for our turn, and for a request to complete if the limit is reached.
+  bool has_ticket = false;
+  uint32_t ticket = 0;
+  while (true)
+  {
+    if (!has_ticket
+        && endpoint->next_ticket - endpoint->now_serving < _az_HTTP_CONCURRENCY_LIMITER_QUEUE_MAX)
+    {
+      ticket = endpoint->next_ticket++;
+      has_ticket = true;
+    }
+
+    if (has_ticket && ticket == endpoint->now_serving && endpoint->in_flight < endpoint->limit)
+    {
+      break;
+    }
+
+    if (context != NULL && az_context_has_expired(context, az_platform_clock_msec()))
+    {
+      if (has_ticket)
+      {
+        _az_http_concurrency_limiter_abandon(endpoint, ticket);
+      }
+      bool const can_admit_next = _az_http_concurrency_limiter_can_admit_next(endpoint);
+      AZ_RETURN_IF_FAILED(_az_http_concurrency_limiter_unlock(options));
+      if (can_admit_next)
+      {
+        az_platform_wait_notify_all();
+      }
+      return AZ_ERROR_CANCELED;
+    }
+
+    az_result wait_result = _az_http_concurrency_limiter_unlock(options);
+    if (az_succeeded(wait_result))
+    {
+      // Canceling the context ends the wait early, and the loop checks again either way.
+      int32_t const waited_msec
+          = az_platform_wait_msec(context, _az_HTTP_CONCURRENCY_LIMITER_WAIT_MSEC);
+      (void)waited_msec;
+      wait_result = _az_http_concurrency_limiter_lock(options);
+    }
+
+    if (az_failed(wait_result))
+    {
+      // Give the ticket back even so: one that is never served would hold up every later caller.
+      if (has_ticket)
+      {
+        _az_http_concurrency_limiter_abandon(endpoint, ticket);
+      }
+      return wait_result;
+    }
+  }
+
+  _az_http_concurrency_limiter_advance(endpoint);
+  int32_t const in_flight = ++endpoint->in_flight;
+  bool can_admit_next = _az_http_concurrency_limiter_can_admit_next(endpoint);
+  az_result const unlock_result = _az_http_concurrency_limiter_unlock(options);
+  if (az_failed(unlock_result))
+  {
+    // The request isn't sent, so it gives its place back.
+    --endpoint->in_flight;
+    return unlock_result;
+  }
+
+  // The next in line may fit under the limit as well.
+  if (can_admit_next)
+  {
+    az_platform_wait_notify_all();
+  }
+
+  int64_t const start_msec = az_platform_clock_msec();
+  az_result const result = az_http_pipeline_nextpolicy(p_policies, p_request, p_response);
+  int64_t const latency_msec = az_platform_clock_msec() - start_msec;
+
+  // The request is done even if the mutex fails: a place that is never given back would lower the
+  // limit for good.
+  az_result const lock_result = _az_http_concurrency_limiter_lock(options);
+  --endpoint->in_flight;
+  if (az_failed(lock_result))
+  {
+    return lock_result;
+  }
+
+  int32_t const old_limit = endpoint->limit;
+  _az_http_concurrency_limiter_adjust(
+      options,
+      endpoint,
+      _az_http_concurrency_limiter_is_overloaded(result, p_response),
+      in_flight,
+      latency_msec);
+  int32_t const new_limit = endpoint->limit;
+  can_admit_next = _az_http_concurrency_limiter_can_admit_next(endpoint);
+  AZ_RETURN_IF_FAILED(_az_http_concurrency_limiter_unlock(options));
+
+  if (can_admit_next)
+  {
+    az_platform_wait_notify_all();
+  }
+
+  if (new_limit != old_limit && az_log_should_write(AZ_LOG_HTTP_CONCURRENCY_LIMITER))
+  {
+    _az_http_concurrency_limiter_log(authority, new_limit);
+  }
+
+  return result;
+}
@@ -5,6 +5,11 @@
 #define _az_HTTP_POLICY_PRIVATE_H
 
 #include <az_http_internal.h>
+#include <az_span_internal.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include <_az_cfg_prefix.h>
 
@@ -24,6 +29,48 @@ AZ_NODISCARD AZ_INLINE az_result az_http_pipeline_nextpolicy(
       &(p_policies[1]), p_policies[0]._internal.p_options, p_request, p_response);
 }
 
+// Returns the authority of the URL ("host:port"), or the whole URL if it has no scheme.
+AZ_NODISCARD AZ_INLINE az_span _az_http_url_get_authority(az_span url)
+{
+  int32_t const scheme_end = az_span_find(url, AZ_SPAN_FROM_STR("://"));
+  if (scheme_end >= 0)
+  {
+    url = az_span_slice_to_end(url, scheme_end + 3);
+  }
+
+  int32_t const path_start = _az_span_find_byte(url, '/');
+  int32_t const query_start = _az_span_find_byte(url, '?');
+  int32_t end = az_span_size(url);
+  if (path_start >= 0 && path_start < end)
+  {
+    end = path_start;
+  }
+  if (query_start >= 0 && query_start < end)
+  {
+    end = query_start;
+  }
+
+  return az_span_slice(url, 0, end);
+}
+
+// Tells whether the endpoint whose state starts at `endpoint` can give its slot to another one.
+typedef bool (*_az_http_endpoint_is_idle_fn)(void const* endpoint, void const* is_idle_context);
+
+// Finds the state of the endpoint with the given authority hash among the `count` states of
+// `endpoint_size` bytes at `endpoints`, which each start with an _az_http_endpoint_slot. The search
+// starts at the slot the hash points to and goes on with the next ones, so endpoints whose hashes
+// collide each get their own slot. A new endpoint takes a free slot, or else the slot of an
+// endpoint `is_idle` accepts; out_is_new is set, and the caller resets the state. Returns NULL if
+// no slot can be taken.
+AZ_NODISCARD void* _az_http_endpoint_find(
+    void* endpoints,
+    size_t endpoint_size,
+    int32_t count,
+    uint32_t authority_hash,
+    _az_http_endpoint_is_idle_fn is_idle,
+    void const* is_idle_context,
+    bool* out_is_new);
+
 #include <_az_cfg_suffix.h>
 
 #endif // _az_HTTP_POLICY_PRIVATE_H
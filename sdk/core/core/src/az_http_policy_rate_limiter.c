@@ -0,0 +1,269 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_http_policy_private.h"
+#include "az_http_private.h"
+#include <az_config.h>
+#include <az_config_internal.h>
+#include <az_context.h>
+#include <az_http.h>
+#include <az_http_internal.h>
+#include <az_http_transport.h>
+#include <az_log_internal.h>
+#include <az_platform_internal.h>
+#include <az_precondition_internal.h>
+#include <az_span_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <_az_cfg.h>
+
+AZ_NODISCARD az_result _az_http_policy_rate_limiter_options_init(
+    _az_http_policy_rate_limiter_options* out_options,
+    struct az_platform_mtx* mutex,
+    int32_t requests_per_second,
+    int32_t burst)
+{
+  _az_PRECONDITION_NOT_NULL(out_options);
+  _az_PRECONDITION_RANGE(
+      1,
+      requests_per_second,
+      _az_TIME_MILLISECONDS_PER_SECOND * _az_TIME_MICROSECONDS_PER_MILLISECOND);
+  _az_PRECONDITION(burst >= 1);
+
+  int64_t const interval_usec = (int64_t)_az_TIME_MILLISECONDS_PER_SECOND
+      * _az_TIME_MICROSECONDS_PER_MILLISECOND / requests_per_second;
+
+  *out_options = (_az_http_policy_rate_limiter_options){
+    ._internal = {
+      .endpoints = { { 0 } },
+      .mutex = mutex,
+      .interval_usec = interval_usec,
+      // How far ahead of the clock the theoretical arrival time can get before a request waits.
+      .burst_usec = (burst - 1) * interval_usec,
+    },
+  };
+
+  return AZ_OK;
+}
+
+static AZ_NODISCARD az_result
+_az_http_rate_limiter_lock(_az_http_policy_rate_limiter_options* options)
+{
+  return options->_internal.mutex == NULL ? AZ_OK : az_platform_mtx_lock(options->_internal.mutex);
+}
+
+static AZ_NODISCARD az_result
+_az_http_rate_limiter_unlock(_az_http_policy_rate_limiter_options* options)
+{
+  return options->_internal.mutex == NULL ? AZ_OK
+                                          : az_platform_mtx_unlock(options->_internal.mutex);
+}
+
+// Logs "HTTP rate limiter for <authority><infix_string><delay_msec>ms."
+static void _az_http_rate_limiter_log(az_span authority, az_span infix_string, int64_t delay_msec)
+{
+  uint8_t log_msg_buf[AZ_LOG_MSG_BUF_SIZE] = { 0 };
+  az_span const log_msg = AZ_SPAN_FROM_BUFFER(log_msg_buf);
+
+  az_span const prefix = AZ_SPAN_FROM_STR("HTTP rate limiter for ");
+  az_span const suffix = AZ_SPAN_FROM_STR("ms.");
+  if (az_span_size(log_msg) < az_span_size(prefix) + az_span_size(authority)
+          + az_span_size(infix_string) + _az_INT64_AS_STR_BUF_SIZE + az_span_size(suffix))
+  {
+    return;
+  }
+
+  az_span remainder = az_span_copy(log_msg, prefix);
+  remainder = az_span_copy(remainder, authority);
+  remainder = az_span_copy(remainder, infix_string);
+  if (az_failed(az_span_i64toa(remainder, delay_msec, &remainder)))
+  {
+    return;
+  }
+  remainder = az_span_copy(remainder, suffix);
+
+  az_log_write(
+      AZ_LOG_HTTP_RATE_LIMITER,
+      az_span_slice(log_msg, 0, az_span_size(log_msg) - az_span_size(remainder)));
+}
+
+// An endpoint whose bucket is full again has nothing to remember: no request is being paced, and
+// any pause it asked for is over.
+static AZ_NODISCARD bool _az_http_rate_limiter_is_idle(void const* endpoint, void const* now_usec)
+{
+  return ((_az_http_rate_limiter_endpoint const*)endpoint)->theoretical_arrival_usec
+      <= *(int64_t const*)now_usec;
+}
+
+// Finds the state of the endpoint, or takes a slot for it; NULL if every slot is pacing another
+// endpoint.
+static AZ_NODISCARD _az_http_rate_limiter_endpoint* _az_http_rate_limiter_find(
+    _az_http_policy_rate_limiter_options* options,
+    uint32_t authority_hash,
+    int64_t now_usec)
+{
+  bool is_new = false;
+  _az_http_rate_limiter_endpoint* const endpoint
+      = (_az_http_rate_limiter_endpoint*)_az_http_endpoint_find(
+          options->_internal.endpoints,
+          sizeof(options->_internal.endpoints[0]),
+          _az_HTTP_RATE_LIMITER_ENDPOINTS,
+          authority_hash,
+          _az_http_rate_limiter_is_idle,
+          &now_usec,
+          &is_new);
+
+  if (is_new)
+  {
+    // A new endpoint starts with a full bucket.
+    endpoint->theoretical_arrival_usec = 0;
+  }
+
+  return endpoint;
+}
+
+// Returns how long the endpoint asks to be left alone, or -1 if it didn't throttle the request.
+static AZ_NODISCARD int32_t
+_az_http_rate_limiter_get_throttle_msec(az_http_response const* response)
+{
+  az_http_response response_copy = *response;
+  az_http_response_status_line status_line = { 0 };
+  if (az_failed(az_http_response_get_status_line(&response_copy, &status_line))
+      || (status_line.status_code != AZ_HTTP_STATUS_CODE_TOO_MANY_REQUESTS
+          && status_line.status_code != AZ_HTTP_STATUS_CODE_SERVICE_UNAVAILABLE))
+  {
+    return -1;
+  }
+
+  int32_t retry_after_msec = -1;
+  if (az_failed(_az_http_response_get_retry_after_msec(&response_copy, &retry_after_msec))
+      || retry_after_msec < 0)
+  {
+    return 0;
+  }
+
+  return retry_after_msec;
+}
+
+AZ_NODISCARD az_result az_http_pipeline_policy_rate_limiter(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response)
+{
+  _az_http_policy_rate_limiter_options* const options
+      = (_az_http_policy_rate_limiter_options*)p_options;
+
+  az_span url = { 0 };
+  AZ_RETURN_IF_FAILED(az_http_request_get_url(p_request, &url));
+  az_span const authority = _az_http_url_get_authority(url);
+  uint32_t const authority_hash = _az_span_hash_ignoring_case(authority);
+
+  AZ_RETURN_IF_FAILED(_az_http_rate_limiter_lock(options));
+
+  int64_t const now_msec = az_platform_clock_msec();
+  int64_t const now_usec = now_msec * _az_TIME_MICROSECONDS_PER_MILLISECOND;
+
+  _az_http_rate_limiter_endpoint* endpoint
+      = _az_http_rate_limiter_find(options, authority_hash, now_usec);
+  if (endpoint == NULL)
+  {
+    // Every slot is pacing another endpoint, and none of them is forgotten for this one.
+    AZ_RETURN_IF_FAILED(_az_http_rate_limiter_unlock(options));
+    return az_http_pipeline_nextpolicy(p_policies, p_request, p_response);
+  }
+
+  bool const should_log = az_log_should_write(AZ_LOG_HTTP_RATE_LIMITER);
+
+  int64_t arrival_usec = endpoint->theoretical_arrival_usec;
+  if (arrival_usec < now_usec)
+  {
+    arrival_usec = now_usec;
+  }
+
+  int64_t const delay_usec = arrival_usec - options->_internal.burst_usec - now_usec;
+  int64_t const delay_msec = delay_usec > 0
+      ? (delay_usec + _az_TIME_MICROSECONDS_PER_MILLISECOND - 1)
+          / _az_TIME_MICROSECONDS_PER_MILLISECOND
+      : 0;
+
+  az_context* const context = p_request->_internal.context;
+  int64_t const expiration
+      = (context != NULL) ? az_context_get_expiration(context) : _az_CONTEXT_MAX_EXPIRATION;
+
+  // The request would only be sent after the deadline.
+  if (expiration - now_msec < delay_msec)
+  {
+    AZ_RETURN_IF_FAILED(_az_http_rate_limiter_unlock(options));
+    return AZ_ERROR_CANCELED;
+  }
+
+  // Take the token before waiting, so the requests arriving meanwhile queue up behind this one.
+  endpoint->theoretical_arrival_usec = arrival_usec + options->_internal.interval_usec;
+  AZ_RETURN_IF_FAILED(_az_http_rate_limiter_unlock(options));
+
+  if (delay_msec > 0)
+  {
+    if (should_log)
+    {
+      _az_http_rate_limiter_log(authority, AZ_SPAN_FROM_STR(" holds a request for "), delay_msec);
+    }
+
+    // Canceling the context ends the wait early.
+    int32_t const waited_msec = az_platform_wait_msec(
+        context, delay_msec < INT32_MAX ? (int32_t)delay_msec : INT32_MAX);
+
+    if (should_log)
+    {
+      _az_http_rate_limiter_log(authority, AZ_SPAN_FROM_STR(" held a request for "), waited_msec);
+    }
+
+    // The deadline was checked before waiting, so only canceling the context can make it pass.
+    if (context != NULL && az_context_get_expiration(context) < expiration)
+    {
+      return AZ_ERROR_CANCELED;
+    }
+  }
+
+  az_result const result = az_http_pipeline_nextpolicy(p_policies, p_request, p_response);
+  if (az_failed(result))
+  {
+    return result;
+  }
+
+  int32_t const throttle_msec = _az_http_rate_limiter_get_throttle_msec(p_response);
+  if (throttle_msec < 0)
+  {
+    return result;
+  }
+
+  AZ_RETURN_IF_FAILED(_az_http_rate_limiter_lock(options));
+
+  // The slot may have been given to another endpoint while the request was out, so it is looked up
+  // again. An endpoint that lost it takes one back to remember the pause, if it can.
+  int64_t const throttled_usec = az_platform_clock_msec() * _az_TIME_MICROSECONDS_PER_MILLISECOND;
+  endpoint = _az_http_rate_limiter_find(options, authority_hash, throttled_usec);
+  if (endpoint != NULL)
+  {
+    // Empty the bucket, so once the endpoint is back, requests resume at the configured rate
+    // rather than with a burst.
+    int64_t const resume_usec = throttled_usec
+        + (int64_t)throttle_msec * _az_TIME_MICROSECONDS_PER_MILLISECOND
+        + options->_internal.burst_usec;
+    if (endpoint->theoretical_arrival_usec < resume_usec)
+    {
+      endpoint->theoretical_arrival_usec = resume_usec;
+    }
+  }
+
+  AZ_RETURN_IF_FAILED(_az_http_rate_limiter_unlock(options));
+
+  if (endpoint != NULL && should_log && throttle_msec > 0)
+  {
+    _az_http_rate_limiter_log(authority, AZ_SPAN_FROM_STR(" paused for "), throttle_msec);
+  }
+
+  return result;
+}
@@ -8,6 +8,7 @@
 #include <az_http_internal.h>
 #include <az_log_internal.h>
 #include <az_platform_internal.h>
+#include <az_precondition_internal.h>
 #include <az_retry_internal.h>
 #include <az_span_internal.h>
 
@@ -15,6 +16,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif // _MSC_VER
+
 #include <_az_cfg.h>
 
 static az_http_status_code const _default_status_codes[] = {
@@ -35,12 +40,177 @@ AZ_NODISCARD az_http_policy_retry_options _az_http_policy_retry_options_default(
     .max_retry_delay_msec
     = 2 * _az_TIME_SECONDS_PER_MINUTE * _az_TIME_MILLISECONDS_PER_SECOND, // 2 minutes
     .status_codes = _default_status_codes,
+    .jitter = AZ_HTTP_POLICY_RETRY_JITTER_FULL,
+    .budget = NULL,
   };
 }
 
+enum
+{
+  _az_RETRY_BUDGET_TOKEN = 100, // A retry costs a whole token, balances are in hundredths
+};
+
+AZ_NODISCARD az_result az_http_policy_retry_budget_init(
+    az_http_policy_retry_budget* out_budget,
+    int32_t retry_percent,
+    int32_t max_retries)
+{
+  _az_PRECONDITION_NOT_NULL(out_budget);
+  _az_PRECONDITION_RANGE(0, retry_percent, _az_RETRY_BUDGET_TOKEN);
+  _az_PRECONDITION_RANGE(1, max_retries, INT32_MAX / _az_RETRY_BUDGET_TOKEN);
+
+  *out_budget = (az_http_policy_retry_budget){
+    ._internal = {
+      .balance = max_retries * _az_RETRY_BUDGET_TOKEN,
+      .max_balance = max_retries * _az_RETRY_BUDGET_TOKEN,
+      .retry_percent = retry_percent,
+    },
+  };
+
+  return AZ_OK;
+}
+
+// The budget is shared by the requests of every thread, so its balance is only accessed through
+// these.
+AZ_NODISCARD AZ_INLINE int32_t
+_az_http_policy_retry_budget_load_balance(az_http_policy_retry_budget const* budget)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_load_n(&budget->_internal.balance, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER) // !__GNUC__ !__clang__
+  return (int32_t)_InterlockedOr((long volatile*)&budget->_internal.balance, 0);
+#else // !__GNUC__ !__clang__ !_MSC_VER
+  return *(int32_t const volatile*)&budget->_internal.balance;
+#endif // __GNUC__ || __clang__
+}
+
+// Sets the balance to desired if it still is expected, returns whether it did.
+AZ_NODISCARD AZ_INLINE bool _az_http_policy_retry_budget_exchange_balance(
+    az_http_policy_retry_budget* budget,
+    int32_t expected,
+    int32_t desired)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_compare_exchange_n(
+      &budget->_internal.balance, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER) // !__GNUC__ !__clang__
+  return _InterlockedCompareExchange((long volatile*)&budget->_internal.balance, desired, expected)
+      == expected;
+#else // !__GNUC__ !__clang__ !_MSC_VER
+  // Without atomics, a concurrent update can be lost; single-threaded builds are unaffected.
+  (void)expected;
+  *(int32_t volatile*)&budget->_internal.balance = desired;
+  return true;
+#endif // __GNUC__ || __clang__
+}
+
+AZ_INLINE void _az_http_policy_retry_budget_deposit(az_http_policy_retry_budget* budget)
+{
+  int32_t const max_balance = budget->_internal.max_balance;
+  int32_t balance = 0;
+  int32_t new_balance = 0;
+  do
+  {
+    balance = _az_http_policy_retry_budget_load_balance(budget);
+    new_balance = balance + budget->_internal.retry_percent;
+    if (new_balance > max_balance)
+    {
+      new_balance = max_balance;
+    }
+  } while (balance != new_balance
+           && !_az_http_policy_retry_budget_exchange_balance(budget, balance, new_balance));
+}
+
+AZ_NODISCARD AZ_INLINE bool _az_http_policy_retry_budget_withdraw(
+    az_http_policy_retry_budget* budget)
+{
+  int32_t balance = 0;
+  do
+  {
+    balance = _az_http_policy_retry_budget_load_balance(budget);
+    if (balance < _az_RETRY_BUDGET_TOKEN)
+    {
+      return false;
+    }
+  } while (!_az_http_policy_retry_budget_exchange_balance(
+      budget, balance, balance - _az_RETRY_BUDGET_TOKEN));
+
+  return true;
+}
+
+static _az_http_policy_retry_random_fn _az_http_policy_retry_random_callback = NULL;
+
+void _az_http_policy_retry_set_random_callback(_az_http_policy_retry_random_fn random_callback)
+{
+  _az_http_policy_retry_random_callback = random_callback;
+}
+
+// xorshift32: statistical quality doesn't matter here, only that processes don't agree.
+// Each request keeps its own state, 0 until its first retry, so concurrent requests don't share it.
+static uint32_t _az_http_policy_retry_random(uint32_t* ref_state)
+{
+  if (_az_http_policy_retry_random_callback != NULL)
+  {
+    return _az_http_policy_retry_random_callback();
+  }
+
+  uint32_t x = *ref_state;
+  if (x == 0)
+  {
+    // Requests started together still differ in where their thread's stack was mapped.
+    x = (uint32_t)az_platform_clock_usec() ^ (uint32_t)(uintptr_t)ref_state;
+    x = x != 0 ? x : 1;
+  }
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *ref_state = x;
+  return x;
+}
+
+// Returns a random number between min and max, both included.
+AZ_NODISCARD AZ_INLINE int32_t
+_az_http_policy_retry_random_between(uint32_t* ref_random_state, int32_t min, int32_t max)
+{
+  return min
+      + (int32_t)(_az_http_policy_retry_random(ref_random_state) % ((uint32_t)(max - min) + 1));
+}
+
+AZ_NODISCARD AZ_INLINE int32_t _az_http_policy_retry_calc_delay(
+    az_http_policy_retry_options const* retry_options,
+    int16_t attempt,
+    int32_t previous_delay_msec,
+    uint32_t* ref_random_state)
+{
+  int32_t const retry_delay_msec = retry_options->retry_delay_msec;
+  int32_t const max_retry_delay_msec = retry_options->max_retry_delay_msec;
+
+  switch (retry_options->jitter)
+  {
+    case AZ_HTTP_POLICY_RETRY_JITTER_FULL:
+      return _az_http_policy_retry_random_between(
+          ref_random_state,
+          0,
+          _az_retry_calc_delay(attempt, retry_delay_msec, max_retry_delay_msec));
+
+    case AZ_HTTP_POLICY_RETRY_JITTER_DECORRELATED:
+    {
+      int64_t const upper = (int64_t)previous_delay_msec * 3;
+      int32_t const delay = _az_http_policy_retry_random_between(
+          ref_random_state, retry_delay_msec, upper < INT32_MAX ? (int32_t)upper : INT32_MAX);
+      return delay < max_retry_delay_msec ? delay : max_retry_delay_msec;
+    }
+
+    default:
+      return _az_retry_calc_delay(attempt, retry_delay_msec, max_retry_delay_msec);
+  }
+}
+
 // TODO: Add unit tests
 AZ_INLINE az_result _az_http_policy_retry_append_http_retry_msg(
     int16_t attempt,
+    az_span infix_string,
     int32_t delay_msec,
     az_span* ref_log_msg)
 {
@@ -50,7 +220,6 @@ AZ_INLINE az_result _az_http_policy_retry_append_http_retry_msg(
 
   AZ_RETURN_IF_FAILED(az_span_i32toa(remainder, (int32_t)attempt, &remainder));
 
-  az_span infix_string = AZ_SPAN_FROM_STR(" will be made in ");
   AZ_RETURN_IF_NOT_ENOUGH_SIZE(remainder, az_span_size(infix_string));
   remainder = az_span_copy(remainder, infix_string);
 
@@ -65,27 +234,17 @@ AZ_INLINE az_result _az_http_policy_retry_append_http_retry_msg(
   return AZ_OK;
 }
 
-AZ_INLINE void _az_http_policy_retry_log(int16_t attempt, int32_t delay_msec)
+// Logs "HTTP Retry attempt #<attempt><infix_string><delay_msec>ms."
+AZ_INLINE void _az_http_policy_retry_log(int16_t attempt, az_span infix_string, int32_t delay_msec)
 {
   uint8_t log_msg_buf[AZ_LOG_MSG_BUF_SIZE] = { 0 };
   az_span log_msg = AZ_SPAN_FROM_BUFFER(log_msg_buf);
 
-  (void)_az_http_policy_retry_append_http_retry_msg(attempt, delay_msec, &log_msg);
+  (void)_az_http_policy_retry_append_http_retry_msg(attempt, infix_string, delay_msec, &log_msg);
 
   az_log_write(AZ_LOG_HTTP_RETRY, log_msg);
 }
 
-AZ_INLINE AZ_NODISCARD int32_t _az_uint32_span_to_int32(az_span span)
-{
-  uint32_t value = 0;
-  if (az_succeeded(az_span_atou32(span, &value)))
-  {
-    return value < INT32_MAX ? (int32_t)value : INT32_MAX;
-  }
-
-  return -1;
-}
-
 AZ_INLINE AZ_NODISCARD az_result _az_http_policy_retry_get_retry_after(
     az_http_response* ref_response,
     az_http_status_code const* status_codes,
@@ -98,50 +257,12 @@ AZ_INLINE AZ_NODISCARD az_result _az_http_policy_retry_get_retry_after(
 
   for (; *status_codes != AZ_HTTP_STATUS_CODE_NONE; ++status_codes)
   {
-    if (*status_codes != response_code)
-    {
-      continue;
-    }
-
-    // Try to get the value of retry-after header, if there's one.
-    *should_retry = true;
-
-    az_pair header = { 0 };
-    while (az_http_response_get_next_header(ref_response, &header) == AZ_OK)
+    if (*status_codes == response_code)
     {
-      if (az_span_is_content_equal_ignoring_case(header.key, AZ_SPAN_FROM_STR("retry-after-ms"))
-          || az_span_is_content_equal_ignoring_case(
-              header.key, AZ_SPAN_FROM_STR("x-ms-retry-after-ms")))
-      {
-        // The value is in milliseconds.
-        int32_t const msec = _az_uint32_span_to_int32(header.value);
-        if (msec >= 0) // int32_t max == ~24 days
-        {
-          *retry_after_msec = msec;
-          return AZ_OK;
-        }
-      }
-      else if (az_span_is_content_equal_ignoring_case(header.key, AZ_SPAN_FROM_STR("Retry-After")))
-      {
-        // The vaule is either seconds or date.
-        int32_t const seconds = _az_uint32_span_to_int32(header.value);
-        if (seconds >= 0) // int32_t max == ~68 years
-        {
-          *retry_after_msec = (seconds <= (INT32_MAX / _az_TIME_MILLISECONDS_PER_SECOND))
-              ? seconds * _az_TIME_MILLISECONDS_PER_SECOND
-              : INT32_MAX;
-
-          return AZ_OK;
-        }
-
-        // TODO: Other possible value is HTTP Date. For that, we'll need to parse date, get
-        // current date, subtract one from another, get seconds. And the device should have a
-        // sense of calendar clock.
-      }
+      // Try to get the value of retry-after header, if there's one.
+      *should_retry = true;
+      return _az_http_response_get_retry_after_msec(ref_response, retry_after_msec);
     }
-
-    *retry_after_msec = -1;
-    return AZ_OK;
   }
 
   *should_retry = false;
@@ -159,9 +280,8 @@ AZ_NODISCARD az_result az_http_pipeline_policy_retry(
       = (az_http_policy_retry_options const*)p_data;
 
   int16_t const max_retries = retry_options->max_retries;
-  int32_t const retry_delay_msec = retry_options->retry_delay_msec;
-  int32_t const max_retry_delay_msec = retry_options->max_retry_delay_msec;
   az_http_status_code const* const status_codes = retry_options->status_codes;
+  az_http_policy_retry_budget* const budget = retry_options->budget;
 
   AZ_RETURN_IF_FAILED(_az_http_request_mark_retry_headers_start(p_request));
 
@@ -170,6 +290,8 @@ AZ_NODISCARD az_result az_http_pipeline_policy_retry(
   bool const should_log = az_log_should_write(AZ_LOG_HTTP_RETRY);
   az_result result = AZ_OK;
   int16_t attempt = 1;
+  int32_t delay_msec = retry_options->retry_delay_msec;
+  uint32_t random_state = 0;
   while (true)
   {
     AZ_RETURN_IF_FAILED(az_http_response_init(p_response, p_response->_internal.http_response));
@@ -178,7 +300,14 @@ AZ_NODISCARD az_result az_http_pipeline_policy_retry(
     result = az_http_pipeline_nextpolicy(p_policies, p_request, p_response);
 
     // Even HTTP 429, or 502 are expected to be AZ_OK, so the failed result is not retriable.
-    if (attempt > max_retries || az_failed(result))
+    if (az_failed(result))
+    {
+      return result;
+    }
+
+    // The last response is returned as is, before its headers are parsed, so that a malformed
+    // Retry-After header can't turn it into an error.
+    if (attempt > max_retries)
     {
       return result;
     }
@@ -191,6 +320,11 @@ AZ_NODISCARD az_result az_http_pipeline_policy_retry(
 
     if (!should_retry)
     {
+      if (budget != NULL)
+      {
+        _az_http_policy_retry_budget_deposit(budget);
+      }
+
       return result;
     }
 
@@ -198,17 +332,52 @@ AZ_NODISCARD az_result az_http_pipeline_policy_retry(
 
     if (retry_after_msec < 0)
     { // there wasn't any kind of "retry-after" response header
-      retry_after_msec = _az_retry_calc_delay(attempt, retry_delay_msec, max_retry_delay_msec);
+      delay_msec = _az_http_policy_retry_calc_delay(
+          retry_options, attempt, delay_msec, &random_state);
+      retry_after_msec = delay_msec;
+    }
+
+    int64_t expiration = _az_CONTEXT_MAX_EXPIRATION;
+    if (context != NULL)
+    {
+      int64_t const now = az_platform_clock_msec();
+      expiration = az_context_get_expiration(context);
+      if (expiration < now)
+      {
+        return AZ_ERROR_CANCELED;
+      }
+
+      // Don't wait for an attempt that would only start after the deadline; the last response is
+      // as good an answer as the caller is going to get.
+      if (expiration - now < retry_after_msec)
+      {
+        return result;
+      }
+    }
+
+    // Past a retry storm's share of the traffic, give the service a break rather than retry.
+    if (budget != NULL && !_az_http_policy_retry_budget_withdraw(budget))
+    {
+      return result;
     }
 
     if (should_log)
     {
-      _az_http_policy_retry_log(attempt, retry_after_msec);
+      _az_http_policy_retry_log(attempt, AZ_SPAN_FROM_STR(" will be made in "), retry_after_msec);
     }
 
-    az_platform_sleep_msec(retry_after_msec);
+    // Canceling the context ends the wait early.
+    int32_t const waited_msec = az_platform_wait_msec(context, retry_after_msec);
+
+    if (should_log)
+    {
+      // How long was actually spent waiting, which is less than announced if canceled.
+      _az_http_policy_retry_log(attempt, AZ_SPAN_FROM_STR(" waited "), waited_msec);
+    }
 
-    if (context != NULL && az_context_has_expired(context, az_platform_clock_msec()))
+    // The deadline was checked before waiting, so only moving it earlier (canceling the context)
+    // can have made it pass.
+    if (context != NULL && az_context_get_expiration(context) < expiration)
     {
       return AZ_ERROR_CANCELED;
     }
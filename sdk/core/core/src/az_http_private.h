@@ -32,11 +32,23 @@ AZ_NODISCARD AZ_INLINE az_result _az_http_request_mark_retry_headers_start(_az_h
   return AZ_OK;
 }
 
+/**
+ * @brief Rebuilds the header name index of a request from its headers, after some were removed.
+ *
+ * @param p_hrb HTTP request builder.
+ */
+void _az_http_request_index_headers(_az_http_request* p_hrb);
+
 AZ_NODISCARD AZ_INLINE az_result _az_http_request_remove_retry_headers(_az_http_request* p_hrb)
 {
   _az_PRECONDITION_NOT_NULL(p_hrb);
-  p_hrb->_internal.headers_length
+  int32_t const headers_length
       = p_hrb->_internal.retry_headers_start_byte_offset / (int32_t)sizeof(az_pair);
+  if (headers_length != p_hrb->_internal.headers_length)
+  {
+    p_hrb->_internal.headers_length = headers_length;
+    _az_http_request_index_headers(p_hrb);
+  }
   return AZ_OK;
 }
 
@@ -46,6 +58,14 @@ AZ_NODISCARD AZ_INLINE az_result _az_http_request_remove_retry_headers(_az_http_
  */
 void _az_http_response_reset(az_http_response* http_response);
 
+/**
+ * @brief Reads the retry-after-ms, x-ms-retry-after-ms or Retry-After header of the response,
+ * whose status line was already read. Sets \p out_msec to -1 if there's none.
+ *
+ */
+AZ_NODISCARD az_result
+_az_http_response_get_retry_after_msec(az_http_response* ref_response, int32_t* out_msec);
+
 #include <_az_cfg_suffix.h>
 
 #endif // _az_HTTP_PRIVATE_H
@@ -9,8 +9,10 @@
 #include <az_http_transport.h>
 #include <az_precondition.h>
 #include <az_precondition_internal.h>
+#include <az_span_internal.h>
 
 #include <assert.h>
+#include <string.h>
 
 #include <_az_cfg.h>
 
@@ -54,6 +56,7 @@ AZ_NODISCARD az_result az_http_request_init(
                                 = az_span_size(headers_buffer) / (int32_t)sizeof(az_pair),
                                 .retry_headers_start_byte_offset = 0,
                                 .body = body,
+                                .body_list = NULL,
                             } };
 
   return AZ_OK;
@@ -68,24 +71,23 @@ AZ_NODISCARD az_result az_http_request_append_path(_az_http_request* p_request,
   int32_t query_start = url_with_question_mark ? p_request->_internal.query_start - 1
                                                : p_request->_internal.url_length;
 
-  /* use replace twice. Yes, we will have 2 right shift (one on each replace), but we rely on
-   * replace functionfor doing this movements only and avoid updating manually. We could also create
-   * a temp buffer to join "/" and path and then use replace. But that will cost us more stack
-   * memory.
-   */
-  AZ_RETURN_IF_FAILED(_az_span_replace(
-      p_request->_internal.url,
-      p_request->_internal.url_length,
-      query_start,
-      query_start,
-      AZ_SPAN_FROM_STR("/")));
-  query_start += 1; // a size of "/"
-  p_request->_internal.url_length++;
-
-  AZ_RETURN_IF_FAILED(_az_span_replace(
-      p_request->_internal.url, p_request->_internal.url_length, query_start, query_start, path));
-  query_start += az_span_size(path);
-  p_request->_internal.url_length += az_span_size(path);
+  // Shift the query (if any) right once, to make room for both the separator and the path.
+  int32_t const required_length = 1 + az_span_size(path);
+  az_span url_remainder
+      = az_span_slice_to_end(p_request->_internal.url, p_request->_internal.url_length);
+  AZ_RETURN_IF_NOT_ENOUGH_SIZE(url_remainder, required_length);
+
+  if (query_start < p_request->_internal.url_length)
+  {
+    az_span_copy(
+        az_span_slice_to_end(p_request->_internal.url, query_start + required_length),
+        az_span_slice(p_request->_internal.url, query_start, p_request->_internal.url_length));
+  }
+
+  az_span_copy(
+      az_span_copy_u8(az_span_slice_to_end(p_request->_internal.url, query_start), '/'), path);
+  query_start += required_length;
+  p_request->_internal.url_length += required_length;
 
   // update query start
   if (url_with_question_mark)
@@ -143,6 +145,84 @@ az_http_request_set_query_parameter(_az_http_request* p_request, az_span name, a
   return AZ_OK;
 }
 
+// Looks a header up in the header name index. Returns its position, or -1 if it is not indexed. In
+// both cases, out_slot receives the slot of the index where it is (or would be inserted).
+static AZ_NODISCARD int32_t _az_http_request_find_indexed_header(
+    _az_http_request const* request,
+    az_span name,
+    int32_t* out_slot)
+{
+  az_pair const* const headers = (az_pair const*)az_span_ptr(request->_internal.headers);
+  uint32_t const mask = _az_HTTP_REQUEST_HEADER_INDEX_SIZE - 1;
+
+  // The index is never more than half full, so there always is an empty slot to stop at.
+  uint32_t slot = _az_span_hash_ignoring_case(name) & mask;
+  while (request->_internal.header_index[slot] != 0)
+  {
+    int32_t const position = request->_internal.header_index[slot] - 1;
+    if (az_span_is_content_equal_ignoring_case(headers[position].key, name))
+    {
+      *out_slot = (int32_t)slot;
+      return position;
+    }
+
+    slot = (slot + 1) & mask;
+  }
+
+  *out_slot = (int32_t)slot;
+  return -1;
+}
+
+// Returns the position of the first header named name, or -1 if there is none.
+static AZ_NODISCARD int32_t
+_az_http_request_find_header(_az_http_request const* request, az_span name)
+{
+  int32_t slot = 0;
+  int32_t const position = _az_http_request_find_indexed_header(request, name, &slot);
+  if (position >= 0)
+  {
+    return position;
+  }
+
+  // Headers past the indexed ones are compared one by one.
+  az_pair const* const headers = (az_pair const*)az_span_ptr(request->_internal.headers);
+  for (int32_t i = _az_HTTP_REQUEST_INDEXED_HEADERS_MAX; i < request->_internal.headers_length;
+       ++i)
+  {
+    if (az_span_is_content_equal_ignoring_case(headers[i].key, name))
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static void _az_http_request_index_header(_az_http_request* p_request, int32_t position)
+{
+  if (position >= _az_HTTP_REQUEST_INDEXED_HEADERS_MAX)
+  {
+    return;
+  }
+
+  // Only the first header with a given name is indexed, as lookups return the first one.
+  az_pair const* const headers = (az_pair const*)az_span_ptr(p_request->_internal.headers);
+  int32_t slot = 0;
+  if (_az_http_request_find_indexed_header(p_request, headers[position].key, &slot) < 0)
+  {
+    p_request->_internal.header_index[slot] = (uint8_t)(position + 1);
+  }
+}
+
+void _az_http_request_index_headers(_az_http_request* p_hrb)
+{
+  memset(p_hrb->_internal.header_index, 0, sizeof(p_hrb->_internal.header_index));
+  for (int32_t i = 0; i < p_hrb->_internal.headers_length; ++i)
+  {
+    _az_http_request_index_header(p_hrb, i);
+  }
+}
+
 AZ_NODISCARD az_result
 az_http_request_append_header(_az_http_request* p_request, az_span key, az_span value)
 {
@@ -153,21 +233,178 @@ az_http_request_append_header(_az_http_request* p_request, az_span key, az_span
   value = _az_span_trim_white_space(value);
 
   _az_PRECONDITION_VALID_SPAN(key, 1, false);
-  az_span headers = p_request->_internal.headers;
+  az_span headers_remainder = az_span_slice_to_end(
+      p_request->_internal.headers, (int32_t)sizeof(az_pair) * p_request->_internal.headers_length);
 
   az_pair header_to_append = az_pair_init(key, value);
 
-  AZ_RETURN_IF_NOT_ENOUGH_SIZE(headers, (int32_t)sizeof header_to_append);
+  AZ_RETURN_IF_NOT_ENOUGH_SIZE(headers_remainder, (int32_t)sizeof header_to_append);
 
   az_span_copy(
-      az_span_slice_to_end(headers, (int32_t)sizeof(az_pair) * p_request->_internal.headers_length),
-      az_span_init((uint8_t*)&header_to_append, sizeof header_to_append));
+      headers_remainder, az_span_init((uint8_t*)&header_to_append, sizeof header_to_append));
 
+  _az_http_request_index_header(p_request, p_request->_internal.headers_length);
   p_request->_internal.headers_length++;
 
   return AZ_OK;
 }
 
+AZ_NODISCARD az_result
+az_http_request_set_header(_az_http_request* p_request, az_span key, az_span value)
+{
+  _az_PRECONDITION_NOT_NULL(p_request);
+
+  int32_t const position
+      = _az_http_request_find_header(p_request, _az_span_trim_white_space(key));
+  if (position < 0)
+  {
+    return az_http_request_append_header(p_request, key, value);
+  }
+
+  ((az_pair*)az_span_ptr(p_request->_internal.headers))[position].value
+      = _az_span_trim_white_space(value);
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_request_remove_header(_az_http_request* p_request, az_span key)
+{
+  _az_PRECONDITION_NOT_NULL(p_request);
+
+  int32_t const position
+      = _az_http_request_find_header(p_request, _az_span_trim_white_space(key));
+  if (position < 0)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  // Shift the headers after the removed one left, so that they keep their order.
+  int32_t const offset = position * (int32_t)sizeof(az_pair);
+  int32_t const headers_size = p_request->_internal.headers_length * (int32_t)sizeof(az_pair);
+  az_span_copy(
+      az_span_slice_to_end(p_request->_internal.headers, offset),
+      az_span_slice(p_request->_internal.headers, offset + (int32_t)sizeof(az_pair), headers_size));
+  p_request->_internal.headers_length--;
+
+  if (offset < p_request->_internal.retry_headers_start_byte_offset)
+  {
+    p_request->_internal.retry_headers_start_byte_offset -= (int32_t)sizeof(az_pair);
+  }
+
+  _az_http_request_index_headers(p_request);
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_http_request_set_body_list(
+    _az_http_request* p_request,
+    az_span_list const* body,
+    az_span buffer)
+{
+  _az_PRECONDITION_NOT_NULL(p_request);
+  _az_PRECONDITION_NOT_NULL(body);
+  _az_PRECONDITION_VALID_SPAN(buffer, 0, true);
+
+  p_request->_internal.body = buffer;
+  p_request->_internal.body_list = body;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result _az_http_request_template_init(
+    _az_http_request_template* out_template,
+    az_span url_buffer,
+    az_span url,
+    az_span headers_buffer)
+{
+  _az_PRECONDITION_NOT_NULL(out_template);
+  _az_PRECONDITION_VALID_SPAN(url_buffer, 1, false);
+  _az_PRECONDITION_VALID_SPAN(url, 0, true);
+
+  int32_t const url_size = az_span_size(url);
+  AZ_RETURN_IF_NOT_ENOUGH_SIZE(url_buffer, url_size);
+  az_span_copy(url_buffer, url);
+
+  // The method, context and body are placeholders, requests get their own at init.
+  return az_http_request_init(
+      &out_template->_internal.request,
+      &az_context_app,
+      az_http_method_get(),
+      url_buffer,
+      url_size,
+      headers_buffer,
+      AZ_SPAN_NULL);
+}
+
+AZ_NODISCARD az_result _az_http_request_template_set_query_parameter(
+    _az_http_request_template* request_template,
+    az_span name,
+    az_span value)
+{
+  _az_PRECONDITION_NOT_NULL(request_template);
+
+  return az_http_request_set_query_parameter(&request_template->_internal.request, name, value);
+}
+
+AZ_NODISCARD az_result _az_http_request_template_append_header(
+    _az_http_request_template* request_template,
+    az_span key,
+    az_span value)
+{
+  _az_PRECONDITION_NOT_NULL(request_template);
+
+  return az_http_request_append_header(&request_template->_internal.request, key, value);
+}
+
+AZ_NODISCARD az_result _az_http_request_init_from_template(
+    _az_http_request* p_request,
+    az_context* context,
+    az_http_method method,
+    az_span url_buffer,
+    az_span headers_buffer,
+    az_span body,
+    _az_http_request_template const* request_template)
+{
+  _az_PRECONDITION_NOT_NULL(p_request);
+  _az_PRECONDITION_NOT_NULL(request_template);
+  _az_PRECONDITION_VALID_SPAN(method, 1, false);
+  _az_PRECONDITION_VALID_SPAN(url_buffer, 1, false);
+  _az_PRECONDITION_VALID_SPAN(headers_buffer, 0, false);
+
+  _az_http_request const* prototype = &request_template->_internal.request;
+  int32_t const url_length = prototype->_internal.url_length;
+  int32_t const headers_size = prototype->_internal.headers_length * (int32_t)sizeof(az_pair);
+
+  AZ_RETURN_IF_NOT_ENOUGH_SIZE(url_buffer, url_length);
+  AZ_RETURN_IF_NOT_ENOUGH_SIZE(headers_buffer, headers_size);
+
+  // The rendered URL and headers are copied as they are, nothing is parsed again.
+  az_span_copy(url_buffer, az_span_slice(prototype->_internal.url, 0, url_length));
+  az_span_copy(headers_buffer, az_span_slice(prototype->_internal.headers, 0, headers_size));
+
+  *p_request = (_az_http_request){ ._internal = {
+                                       .context = context,
+                                       .method = method,
+                                       .url = url_buffer,
+                                       .url_length = url_length,
+                                       .query_start = prototype->_internal.query_start,
+                                       .headers = headers_buffer,
+                                       .headers_length = prototype->_internal.headers_length,
+                                       .max_headers
+                                       = az_span_size(headers_buffer) / (int32_t)sizeof(az_pair),
+                                       .retry_headers_start_byte_offset = 0,
+                                       .body = body,
+                                       .body_list = NULL,
+                                   } };
+
+  // The headers are at the same positions as in the template, so is its index.
+  memcpy(
+      p_request->_internal.header_index,
+      prototype->_internal.header_index,
+      sizeof(p_request->_internal.header_index));
+
+  return AZ_OK;
+}
+
 AZ_NODISCARD az_result
 az_http_request_get_header(_az_http_request const* request, int32_t index, az_pair* out_header)
 {
@@ -183,6 +420,24 @@ az_http_request_get_header(_az_http_request const* request, int32_t index, az_pa
   return AZ_OK;
 }
 
+AZ_NODISCARD az_result az_http_request_get_header_by_name(
+    _az_http_request const* request,
+    az_span name,
+    az_span* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(request);
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  int32_t const position = _az_http_request_find_header(request, name);
+  if (position < 0)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  *out_value = ((az_pair*)az_span_ptr(request->_internal.headers))[position].value;
+  return AZ_OK;
+}
+
 AZ_NODISCARD az_result
 az_http_request_get_method(_az_http_request const* request, az_http_method* out_method)
 {
@@ -209,7 +464,61 @@ AZ_NODISCARD az_result az_http_request_get_body(_az_http_request const* request,
   _az_PRECONDITION_NOT_NULL(request);
   _az_PRECONDITION_NOT_NULL(out_body);
 
-  *out_body = request->_internal.body;
+  az_span_list const* const body_list = request->_internal.body_list;
+  if (body_list == NULL)
+  {
+    *out_body = request->_internal.body;
+    return AZ_OK;
+  }
+
+  if (az_span_list_count(body_list) <= 1)
+  {
+    *out_body
+        = az_span_list_count(body_list) == 0 ? AZ_SPAN_NULL : az_span_list_get(body_list, 0);
+    return AZ_OK;
+  }
+
+  // The spans are copied on every call, since the list may have changed in between.
+  az_span remainder;
+  AZ_RETURN_IF_FAILED(az_span_list_flatten(body_list, request->_internal.body, &remainder));
+  *out_body = az_span_slice(request->_internal.body, 0, az_span_list_size(body_list));
+  return AZ_OK;
+}
+
+AZ_NODISCARD int32_t az_http_request_body_spans_count(_az_http_request const* request)
+{
+  _az_PRECONDITION_NOT_NULL(request);
+
+  if (request->_internal.body_list != NULL)
+  {
+    return az_span_list_count(request->_internal.body_list);
+  }
+
+  return az_span_size(request->_internal.body) > 0 ? 1 : 0;
+}
+
+AZ_NODISCARD int32_t az_http_request_body_size(_az_http_request const* request)
+{
+  _az_PRECONDITION_NOT_NULL(request);
+
+  return request->_internal.body_list != NULL ? az_span_list_size(request->_internal.body_list)
+                                              : az_span_size(request->_internal.body);
+}
+
+AZ_NODISCARD az_result
+az_http_request_get_body_span(_az_http_request const* request, int32_t index, az_span* out_span)
+{
+  _az_PRECONDITION_NOT_NULL(request);
+  _az_PRECONDITION_NOT_NULL(out_span);
+
+  if (index < 0 || index >= az_http_request_body_spans_count(request))
+  {
+    return AZ_ERROR_ARG;
+  }
+
+  *out_span = request->_internal.body_list != NULL
+      ? az_span_list_get(request->_internal.body_list, index)
+      : request->_internal.body;
   return AZ_OK;
 }
 
@@ -5,22 +5,17 @@
 
 #include "az_http_private.h"
 #include "az_span_private.h"
+#include <az_config_internal.h>
 #include <az_precondition.h>
 #include <az_precondition_internal.h>
+#include <az_span_internal.h>
 
 #include <_az_cfg.h>
 #include <ctype.h>
+#include <stdint.h>
 
 // HTTP Response utility functions
 
-AZ_NODISCARD AZ_INLINE az_result _az_is_char(az_span slice, uint8_t c)
-{
-  return az_span_ptr(slice)[0] == c ? AZ_OK : AZ_CONTINUE;
-}
-
-static AZ_NODISCARD az_result _az_is_a_colon(az_span slice) { return _az_is_char(slice, ':'); }
-static AZ_NODISCARD az_result _az_is_new_line(az_span slice) { return _az_is_char(slice, '\n'); }
-
 static AZ_NODISCARD bool _az_is_http_whitespace(uint8_t c)
 {
   switch (c)
@@ -95,8 +90,11 @@ _az_get_http_status_line(az_span* self, az_http_response_status_line* out_status
   // reason-phrase = *(HTAB / SP / VCHAR / obs-text)
   // HTAB = "\t"
   // VCHAR or obs-text is %x21-FF,
-  int32_t offset = 0;
-  AZ_RETURN_IF_FAILED(_az_span_scan_until(*self, _az_is_new_line, &offset));
+  int32_t const offset = _az_span_find_byte(*self, '\n');
+  if (offset < 0)
+  {
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
 
   // save reason-phrase in status line now that we got the offset. Remove 1 last chars(\r)
   out_status_line->reason_phrase = az_span_slice(*self, 0, offset - 1);
@@ -108,70 +106,24 @@ _az_get_http_status_line(az_span* self, az_http_response_status_line* out_status
   return AZ_OK;
 }
 
-AZ_NODISCARD az_result az_http_response_get_status_line(
-    az_http_response* response,
-    az_http_response_status_line* out_status_line)
-{
-  _az_PRECONDITION_NOT_NULL(response);
-  _az_PRECONDITION_NOT_NULL(out_status_line);
-
-  // Restart parser to the beggining
-  response->_internal.parser.remaining = response->_internal.http_response;
-
-  // read an HTTP status line.
-  AZ_RETURN_IF_FAILED(
-      _az_get_http_status_line(&response->_internal.parser.remaining, out_status_line));
-
-  // set state.kind of the next HTTP response value.
-  response->_internal.parser.next_kind = _az_HTTP_RESPONSE_KIND_HEADER;
-
-  return AZ_OK;
-}
-
-AZ_NODISCARD az_result
-az_http_response_get_next_header(az_http_response* response, az_pair* out_header)
+// Parses the header at the beginning of reader, moving it to the next line.
+static AZ_NODISCARD az_result _az_http_response_parse_header(az_span* reader, az_pair* out_header)
 {
-  _az_PRECONDITION_NOT_NULL(response);
-  _az_PRECONDITION_NOT_NULL(out_header);
-  az_span* reader = &response->_internal.parser.remaining;
-  {
-    _az_http_response_kind const kind = response->_internal.parser.next_kind;
-    // if reader is expecting to read body (all headers were read), return ITEM_NOT_FOUND so we
-    // know we reach end of headers
-    if (kind == _az_HTTP_RESPONSE_KIND_BODY)
-    {
-      return AZ_ERROR_ITEM_NOT_FOUND;
-    }
-    // Can't read a header if status line was not previously called,
-    // User needs to call az_http_response_status_line() which would reset parser and set kind to
-    // headers
-    if (kind != _az_HTTP_RESPONSE_KIND_HEADER)
-    {
-      return AZ_ERROR_HTTP_INVALID_STATE;
-    }
-  }
-
-  // check if we are at the end of all headers to change state to Body.
-  // We keep state to Headers if current char is not '\r' (there is another header)
-  if (az_span_ptr(response->_internal.parser.remaining)[0] == '\r')
-  {
-    AZ_RETURN_IF_FAILED(_az_is_expected_span(reader, AZ_SPAN_FROM_STR("\r\n")));
-    response->_internal.parser.next_kind = _az_HTTP_RESPONSE_KIND_BODY;
-    return AZ_ERROR_ITEM_NOT_FOUND;
-  }
-
   // https://tools.ietf.org/html/rfc7230#section-3.2
   // header-field   = field-name ":" OWS field-value OWS
   // field-name     = token
   {
-    int32_t field_name_length = 0;
     // https://tools.ietf.org/html/rfc7230#section-3.2.6
     // token = 1*tchar
     // tchar = "!" / "#" / "$" / "%" / "&" / "'" / "*" / "+" / "-" / "." / "^" /
     //         "_" / "`" / "|" / "~" / DIGIT / ALPHA;
     // any VCHAR,
     //    except delimiters
-    AZ_RETURN_IF_FAILED(_az_span_scan_until(*reader, _az_is_a_colon, &field_name_length));
+    int32_t const field_name_length = _az_span_find_byte(*reader, ':');
+    if (field_name_length < 0)
+    {
+      return AZ_ERROR_ITEM_NOT_FOUND;
+    }
 
     // form a header name. Reader is currently at char ':'
     out_header->key = az_span_slice(*reader, 0, field_name_length);
@@ -196,27 +148,30 @@ az_http_response_get_next_header(az_http_response* response, az_pair* out_header
   //
   // Note: obs-fold is not implemented.
   {
+    // Spaces and tabs are accepted anywhere in the value, other control characters are not. The
+    // value ends at the first '\r', which is a control character as well, so looking for control
+    // characters finds the end of the value and validates it at the same time.
     int32_t offset = 0;
-    int32_t offset_value_end = offset;
     while (true)
     {
-      uint8_t c = az_span_ptr(*reader)[offset];
-      offset += 1;
-      if (c == '\r')
+      int32_t const control = _az_span_find_byte_below(az_span_slice_to_end(*reader, offset), ' ');
+      if (control < 0)
       {
-        break; // break as soon as end of value char is found
+        return AZ_ERROR_PARSER_UNEXPECTED_CHAR;
       }
-      if (_az_is_http_whitespace(c))
+
+      uint8_t const c = az_span_ptr(*reader)[offset + control];
+      offset += control + 1;
+      if (c == '\r')
       {
-        continue; // white space or tab is accepted. It can be any number after value (OWS)
+        break; // break as soon as end of value char is found
       }
-      if (c <= ' ')
+      if (c != '\t')
       {
         return AZ_ERROR_PARSER_UNEXPECTED_CHAR;
       }
-      offset_value_end = offset; // increasing index only for valid chars,
     }
-    out_header->value = az_span_slice(*reader, 0, offset_value_end);
+    out_header->value = az_span_slice(*reader, 0, offset - 1);
     // moving reader. It is currently after \r was found
     *reader = az_span_slice_to_end(*reader, offset);
 
@@ -229,6 +184,168 @@ az_http_response_get_next_header(az_http_response* response, az_pair* out_header
   return AZ_OK;
 }
 
+// Returns true once all the headers of the response have been received and indexed.
+AZ_NODISCARD AZ_INLINE bool _az_http_response_is_indexed(az_http_response const* response)
+{
+  return response->_internal.index.body_start > 0 && response->_internal.index.headers_count >= 0;
+}
+
+static AZ_NODISCARD az_pair
+_az_http_response_get_indexed_header(az_http_response const* response, int32_t position)
+{
+  az_span const buffer = response->_internal.http_response;
+  _az_http_response_header_location const* location = &response->_internal.index.headers[position];
+
+  return az_pair_init(
+      az_span_slice(
+          buffer, location->name_offset, location->name_offset + location->name_length),
+      az_span_slice(
+          buffer, location->value_offset, location->value_offset + location->value_length));
+}
+
+// Indexes the line of the response that ends with the '\n' at line_end.
+static void _az_http_response_index_line(az_http_response* response, int32_t line_end)
+{
+  az_span const buffer = response->_internal.http_response;
+  uint8_t const* const ptr = az_span_ptr(buffer);
+  int32_t const line_start = response->_internal.index.line_start;
+  response->_internal.index.line_start = line_end + 1;
+
+  // The status line is parsed when it is read.
+  if (line_start == 0)
+  {
+    return;
+  }
+
+  // An empty line ends the headers.
+  if (line_end == line_start + 1 && ptr[line_start] == '\r')
+  {
+    response->_internal.index.body_start = line_end + 1;
+    return;
+  }
+
+  int32_t const count = response->_internal.index.headers_count;
+  if (count < 0)
+  {
+    return;
+  }
+
+  // Responses with more headers, or with lines that don't end with CRLF, are parsed when they are
+  // read instead, as if they were not indexed.
+  az_pair header = { 0 };
+  az_span reader = az_span_slice(buffer, line_start, line_end + 1);
+  if (count == _az_HTTP_RESPONSE_INDEXED_HEADERS_MAX || line_end == line_start
+      || ptr[line_end - 1] != '\r' || az_failed(_az_http_response_parse_header(&reader, &header)))
+  {
+    response->_internal.index.headers_count = -1;
+    return;
+  }
+
+  response->_internal.index.headers[count] = (_az_http_response_header_location){
+    .name_offset = (int32_t)(az_span_ptr(header.key) - ptr),
+    .name_length = az_span_size(header.key),
+    .value_offset = (int32_t)(az_span_ptr(header.value) - ptr),
+    .value_length = az_span_size(header.value),
+    .name_hash = _az_span_hash_ignoring_case(header.key),
+  };
+  response->_internal.index.headers_count = count + 1;
+}
+
+// Indexes the lines of the headers received since the last call.
+static void _az_http_response_index_headers(az_http_response* response)
+{
+  int32_t const written = response->_internal.written;
+  az_span const buffer = az_span_slice(response->_internal.http_response, 0, written);
+
+  for (int32_t i = response->_internal.index.scanned;
+       i < written && response->_internal.index.body_start == 0;
+       ++i)
+  {
+    int32_t const new_line = _az_span_find_byte(az_span_slice_to_end(buffer, i), '\n');
+    if (new_line < 0)
+    {
+      break;
+    }
+
+    i += new_line;
+    _az_http_response_index_line(response, i);
+  }
+
+  response->_internal.index.scanned = written;
+}
+
+AZ_NODISCARD az_result az_http_response_get_status_line(
+    az_http_response* response,
+    az_http_response_status_line* out_status_line)
+{
+  _az_PRECONDITION_NOT_NULL(response);
+  _az_PRECONDITION_NOT_NULL(out_status_line);
+
+  // Restart parser to the beggining
+  response->_internal.parser.remaining = response->_internal.http_response;
+
+  // read an HTTP status line.
+  AZ_RETURN_IF_FAILED(
+      _az_get_http_status_line(&response->_internal.parser.remaining, out_status_line));
+
+  // set state.kind of the next HTTP response value.
+  response->_internal.parser.next_kind = _az_HTTP_RESPONSE_KIND_HEADER;
+  response->_internal.parser.next_header = 0;
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result
+az_http_response_get_next_header(az_http_response* response, az_pair* out_header)
+{
+  _az_PRECONDITION_NOT_NULL(response);
+  _az_PRECONDITION_NOT_NULL(out_header);
+  az_span* reader = &response->_internal.parser.remaining;
+  {
+    _az_http_response_kind const kind = response->_internal.parser.next_kind;
+    // if reader is expecting to read body (all headers were read), return ITEM_NOT_FOUND so we
+    // know we reach end of headers
+    if (kind == _az_HTTP_RESPONSE_KIND_BODY)
+    {
+      return AZ_ERROR_ITEM_NOT_FOUND;
+    }
+    // Can't read a header if status line was not previously called,
+    // User needs to call az_http_response_status_line() which would reset parser and set kind to
+    // headers
+    if (kind != _az_HTTP_RESPONSE_KIND_HEADER)
+    {
+      return AZ_ERROR_HTTP_INVALID_STATE;
+    }
+  }
+
+  if (_az_http_response_is_indexed(response))
+  {
+    if (response->_internal.parser.next_header < response->_internal.index.headers_count)
+    {
+      *out_header
+          = _az_http_response_get_indexed_header(response, response->_internal.parser.next_header);
+      response->_internal.parser.next_header++;
+      return AZ_OK;
+    }
+
+    *reader = az_span_slice_to_end(
+        response->_internal.http_response, response->_internal.index.body_start);
+    response->_internal.parser.next_kind = _az_HTTP_RESPONSE_KIND_BODY;
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  // check if we are at the end of all headers to change state to Body.
+  // We keep state to Headers if current char is not '\r' (there is another header)
+  if (az_span_ptr(response->_internal.parser.remaining)[0] == '\r')
+  {
+    AZ_RETURN_IF_FAILED(_az_is_expected_span(reader, AZ_SPAN_FROM_STR("\r\n")));
+    response->_internal.parser.next_kind = _az_HTTP_RESPONSE_KIND_BODY;
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  return _az_http_response_parse_header(reader, out_header);
+}
+
 AZ_NODISCARD az_result az_http_response_get_body(az_http_response* response, az_span* out_body)
 {
   _az_PRECONDITION_NOT_NULL(response);
@@ -248,8 +365,13 @@ AZ_NODISCARD az_result az_http_response_get_body(az_http_response* response, az_
       // update current parsing section
       current_parsing_section = response->_internal.parser.next_kind;
     }
-    // parse any remaining header
-    if (current_parsing_section == _az_HTTP_RESPONSE_KIND_HEADER)
+    // parse any remaining header, unless they were all indexed and the body is known already
+    if (_az_http_response_is_indexed(response))
+    {
+      response->_internal.parser.remaining = az_span_slice_to_end(
+          response->_internal.http_response, response->_internal.index.body_start);
+    }
+    else if (current_parsing_section == _az_HTTP_RESPONSE_KIND_HEADER)
     {
       // Parse and ignore all remaining headers
       for (az_pair h; az_http_response_get_next_header(response, &h) == AZ_OK;)
@@ -266,6 +388,54 @@ AZ_NODISCARD az_result az_http_response_get_body(az_http_response* response, az_
   return AZ_OK;
 }
 
+AZ_NODISCARD az_result az_http_response_get_header_by_name(
+    az_http_response const* response,
+    az_span name,
+    az_span* out_value)
+{
+  _az_PRECONDITION_NOT_NULL(response);
+  _az_PRECONDITION_NOT_NULL(out_value);
+
+  if (_az_http_response_is_indexed(response))
+  {
+    uint32_t const name_hash = _az_span_hash_ignoring_case(name);
+    for (int32_t i = 0; i < response->_internal.index.headers_count; ++i)
+    {
+      if (response->_internal.index.headers[i].name_hash != name_hash)
+      {
+        continue;
+      }
+
+      az_pair const header = _az_http_response_get_indexed_header(response, i);
+      if (az_span_is_content_equal_ignoring_case(header.key, name))
+      {
+        *out_value = header.value;
+        return AZ_OK;
+      }
+    }
+
+    return AZ_ERROR_ITEM_NOT_FOUND;
+  }
+
+  // Parse a copy, so that the state of the caller's parser is left as it is.
+  az_http_response response_copy = *response;
+  az_http_response_status_line status_line = { 0 };
+  AZ_RETURN_IF_FAILED(az_http_response_get_status_line(&response_copy, &status_line));
+
+  az_pair header = { 0 };
+  az_result result = AZ_OK;
+  while (az_succeeded(result = az_http_response_get_next_header(&response_copy, &header)))
+  {
+    if (az_span_is_content_equal_ignoring_case(header.key, name))
+    {
+      *out_value = header.value;
+      return AZ_OK;
+    }
+  }
+
+  return result;
+}
+
 void _az_http_response_reset(az_http_response* http_response)
 {
   // never fails, discard the result
@@ -292,5 +462,86 @@ AZ_NODISCARD az_result az_http_response_write_span(az_http_response* response, a
   remaining = az_span_copy(remaining, source);
   response->_internal.written += write_size;
 
+  if (response->_internal.index.body_start == 0)
+  {
+    _az_http_response_index_headers(response);
+  }
+
+  return AZ_OK;
+}
+
+AZ_INLINE AZ_NODISCARD int32_t _az_uint32_span_to_int32(az_span span)
+{
+  uint32_t value = 0;
+  if (az_succeeded(az_span_atou32(span, &value)))
+  {
+    return value < INT32_MAX ? (int32_t)value : INT32_MAX;
+  }
+
+  return -1;
+}
+
+enum
+{
+  _az_RETRY_AFTER_MS_HEADER,
+  _az_X_MS_RETRY_AFTER_MS_HEADER,
+  _az_RETRY_AFTER_HEADER,
+};
+
+// Indexed by the values above; built once rather than for every response.
+static _az_span_name_matcher const _retry_after_matcher = {
+  ._internal = {
+    .names = {
+      AZ_SPAN_LITERAL_FROM_STR("retry-after-ms"),
+      AZ_SPAN_LITERAL_FROM_STR("x-ms-retry-after-ms"),
+      AZ_SPAN_LITERAL_FROM_STR("Retry-After"),
+    },
+    .prefixes = {
+      _az_SPAN_NAME_MATCHER_PREFIX('r', 'e', 't', 'r', 'y', '-', 'a', 'f'),
+      _az_SPAN_NAME_MATCHER_PREFIX('x', '-', 'm', 's', '-', 'r', 'e', 't'),
+      _az_SPAN_NAME_MATCHER_PREFIX('r', 'e', 't', 'r', 'y', '-', 'a', 'f'),
+    },
+    .count = 3,
+  },
+};
+
+AZ_NODISCARD az_result
+_az_http_response_get_retry_after_msec(az_http_response* ref_response, int32_t* out_msec)
+{
+  az_pair header = { 0 };
+  while (az_http_response_get_next_header(ref_response, &header) == AZ_OK)
+  {
+    int32_t const header_index = _az_span_name_matcher_find(&_retry_after_matcher, header.key);
+    if (header_index == _az_RETRY_AFTER_MS_HEADER
+        || header_index == _az_X_MS_RETRY_AFTER_MS_HEADER)
+    {
+      // The value is in milliseconds.
+      int32_t const msec = _az_uint32_span_to_int32(header.value);
+      if (msec >= 0) // int32_t max == ~24 days
+      {
+        *out_msec = msec;
+        return AZ_OK;
+      }
+    }
+    else if (header_index == _az_RETRY_AFTER_HEADER)
+    {
+      // The vaule is either seconds or date.
+      int32_t const seconds = _az_uint32_span_to_int32(header.value);
+      if (seconds >= 0) // int32_t max == ~68 years
+      {
+        *out_msec = (seconds <= (INT32_MAX / _az_TIME_MILLISECONDS_PER_SECOND))
+            ? seconds * _az_TIME_MILLISECONDS_PER_SECOND
+            : INT32_MAX;
+
+        return AZ_OK;
+      }
+
+      // TODO: Other possible value is HTTP Date. For that, we'll need to parse date, get
+      // current date, subtract one from another, get seconds. And the device should have a
+      // sense of calendar clock.
+    }
+  }
+
+  *out_msec = -1;
   return AZ_OK;
 }
@@ -0,0 +1,35 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+// The HMAC-SHA256 functions of the built-in platforms (AZ_PLATFORM_IMPL=USER provides its own).
+// They are kept apart from az_crypto.c so that using SHA-256 alone doesn't need a platform key.
+
+#include <az_crypto_internal.h>
+#include <az_platform_internal.h>
+#include <az_precondition_internal.h>
+
+#include <_az_cfg.h>
+
+void az_platform_hmac_sha256_key_destroy(az_platform_hmac_sha256_key* key)
+{
+  _az_PRECONDITION_NOT_NULL(key);
+  _az_crypto_wipe(key, sizeof(*key));
+}
+
+AZ_NODISCARD az_result
+az_platform_hmac_sha256_key_init(az_platform_hmac_sha256_key* key, az_span key_bytes)
+{
+  _az_PRECONDITION_NOT_NULL(key);
+  _az_hmac_sha256_key_init(&key->_internal.key, key_bytes);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_platform_hmac_sha256_sign(
+    az_platform_hmac_sha256_key const* key,
+    az_span bytes_to_sign,
+    az_span destination,
+    az_span* out_signature)
+{
+  _az_PRECONDITION_NOT_NULL(key);
+  return _az_hmac_sha256_sign(&key->_internal.key, bytes_to_sign, destination, out_signature);
+}
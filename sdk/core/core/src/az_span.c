@@ -82,6 +82,34 @@ AZ_NODISCARD AZ_INLINE uint8_t _az_tolower(uint8_t value)
   return value;
 }
 
+// Reads up to 8 bytes into a word, padding it with zeros. The first byte goes in the least
+// significant byte, regardless of the platform's endianness.
+AZ_NODISCARD AZ_INLINE uint64_t _az_span_load_word(uint8_t const* bytes, int32_t size)
+{
+  uint64_t word = 0;
+  for (int32_t i = (size < 8 ? size : 8) - 1; i >= 0; i--)
+  {
+    word = (word << 8) | bytes[i];
+  }
+  return word;
+}
+
+// Lower-cases the ASCII letters in all of the 8 bytes of `word` at once (SWAR).
+AZ_NODISCARD AZ_INLINE uint64_t _az_tolower_word(uint64_t word)
+{
+  uint64_t const ones = 0x0101010101010101ULL;
+  uint64_t const heptets = word & (0x7F * ones);
+
+  // The high bit of each byte is set when the byte is >= 'A', and when it is > 'Z' respectively.
+  // Adding to the low 7 bits can never carry into the next byte.
+  uint64_t const at_least_a = heptets + (0x80 - 'A') * ones;
+  uint64_t const above_z = heptets + (0x80 - 'Z' - 1) * ones;
+  uint64_t const is_upper = at_least_a & ~above_z & ~word & (0x80 * ones);
+
+  // 0x80 >> 2 is the difference between upper and lower case letters.
+  return word | (is_upper >> 2);
+}
+
 AZ_NODISCARD bool az_span_is_content_equal_ignoring_case(az_span span1, az_span span2)
 {
   int32_t const size = az_span_size(span1);
@@ -89,9 +117,25 @@ AZ_NODISCARD bool az_span_is_content_equal_ignoring_case(az_span span1, az_span
   {
     return false;
   }
-  for (int32_t i = 0; i < size; ++i)
+
+  uint8_t const* const ptr1 = az_span_ptr(span1);
+  uint8_t const* const ptr2 = az_span_ptr(span2);
+
+  // Compare 8 bytes at a time, only folding the case when they are not identical already.
+  int32_t i = 0;
+  for (; i + 8 <= size; i += 8)
   {
-    if (_az_tolower(az_span_ptr(span1)[i]) != _az_tolower(az_span_ptr(span2)[i]))
+    uint64_t const word1 = _az_span_load_word(ptr1 + i, 8);
+    uint64_t const word2 = _az_span_load_word(ptr2 + i, 8);
+    if (word1 != word2 && _az_tolower_word(word1) != _az_tolower_word(word2))
+    {
+      return false;
+    }
+  }
+
+  for (; i < size; ++i)
+  {
+    if (_az_tolower(ptr1[i]) != _az_tolower(ptr2[i]))
     {
       return false;
     }
@@ -99,27 +143,182 @@ AZ_NODISCARD bool az_span_is_content_equal_ignoring_case(az_span span1, az_span
   return true;
 }
 
-AZ_NODISCARD az_result az_span_atou64(az_span span, uint64_t* out_number)
+AZ_NODISCARD az_result _az_span_name_matcher_init(
+    _az_span_name_matcher* out_matcher,
+    az_span const* names,
+    int32_t names_count)
 {
-  _az_PRECONDITION_VALID_SPAN(span, 1, false);
-  _az_PRECONDITION_NOT_NULL(out_number);
+  _az_PRECONDITION_NOT_NULL(out_matcher);
+  _az_PRECONDITION_NOT_NULL(names);
+  _az_PRECONDITION_RANGE(0, names_count, _az_SPAN_NAME_MATCHER_MAX_NAMES);
+
+  out_matcher->_internal.count = names_count;
+  for (int32_t i = 0; i < names_count; ++i)
+  {
+    out_matcher->_internal.names[i] = names[i];
+    out_matcher->_internal.prefixes[i] = _az_tolower_word(
+        _az_span_load_word(az_span_ptr(names[i]), az_span_size(names[i])));
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD int32_t
+_az_span_name_matcher_find(_az_span_name_matcher const* matcher, az_span name)
+{
+  _az_PRECONDITION_NOT_NULL(matcher);
+
+  int32_t const size = az_span_size(name);
+  uint64_t const prefix = _az_tolower_word(_az_span_load_word(az_span_ptr(name), size));
+
+  for (int32_t i = 0; i < matcher->_internal.count; ++i)
+  {
+    az_span const candidate = matcher->_internal.names[i];
+
+    // Names of up to 8 bytes are entirely compared by their prefix.
+    if (az_span_size(candidate) == size && matcher->_internal.prefixes[i] == prefix
+        && (size <= 8
+            || az_span_is_content_equal_ignoring_case(
+                az_span_slice_to_end(candidate, 8), az_span_slice_to_end(name, 8))))
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+// Returns the index of the lowest byte of a non-zero `flags` that has its high bit set.
+AZ_NODISCARD AZ_INLINE int32_t _az_span_lowest_flagged_byte(uint64_t flags)
+{
+  int32_t index = 0;
+  while ((flags & 0x80) == 0)
+  {
+    flags >>= 8;
+    index++;
+  }
+  return index;
+}
+
+AZ_NODISCARD int32_t _az_span_find_byte_below(az_span span, uint8_t bound)
+{
+  _az_PRECONDITION(bound <= 0x80);
+
+  uint8_t const* const ptr = az_span_ptr(span);
+  int32_t const size = az_span_size(span);
+  uint64_t const ones = 0x0101010101010101ULL;
+
+  int32_t i = 0;
+  for (; i + 8 <= size; i += 8)
+  {
+    // The high bit of a byte is set when it is less than `bound`. Borrows may only flag bytes above
+    // one that actually is, so the lowest flagged byte is always accurate.
+    uint64_t const word = _az_span_load_word(ptr + i, 8);
+    uint64_t const below = (word - bound * ones) & ~word & (0x80 * ones);
+    if (below != 0)
+    {
+      return i + _az_span_lowest_flagged_byte(below);
+    }
+  }
+
+  for (; i < size; ++i)
+  {
+    if (ptr[i] < bound)
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+AZ_NODISCARD int32_t _az_span_find_byte(az_span span, uint8_t byte)
+{
+  int32_t const size = az_span_size(span);
+  if (size == 0)
+  {
+    return -1;
+  }
+
+  // The C library's memchr() already compares many bytes at once.
+  uint8_t const* const ptr = az_span_ptr(span);
+  uint8_t const* const found = (uint8_t const*)memchr(ptr, byte, (size_t)size);
+  return found == NULL ? -1 : (int32_t)(found - ptr);
+}
+
+AZ_NODISCARD uint32_t _az_span_hash_ignoring_case(az_span span)
+{
+  uint8_t const* const ptr = az_span_ptr(span);
+  int32_t const size = az_span_size(span);
+
+  uint32_t hash = 2166136261U; // FNV-1a 32-bit offset basis
+  for (int32_t i = 0; i < size; ++i)
+  {
+    hash = (hash ^ _az_tolower(ptr[i])) * 16777619U; // FNV-1a 32-bit prime
+  }
+
+  return hash;
+}
+
+// Parses 8 ASCII digits at once, handling them as the bytes of a single 64-bit word (SWAR).
+// Returns false if any of them is not a digit.
+AZ_NODISCARD AZ_INLINE bool _az_span_parse_eight_digits(uint8_t const* digits, uint64_t* out_value)
+{
+  // The first digit goes in the least significant byte, regardless of the platform's endianness.
+  uint64_t chunk = 0;
+  for (int32_t i = 7; i >= 0; i--)
+  {
+    chunk = (chunk << 8) | digits[i];
+  }
+
+  // Every byte must be within 0x30 ('0') and 0x39 ('9'): its high nibble must be 3, and must remain
+  // so after adding 6 to the low nibble.
+  if ((chunk & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL
+      || ((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL)
+  {
+    return false;
+  }
+
+  // Combine adjacent digits into 2-digit, then 4-digit, then 8-digit values.
+  chunk = ((chunk & 0x0F0F0F0F0F0F0F0FULL) * (1 + (10 << 8))) >> 8;
+  chunk = ((chunk & 0x00FF00FF00FF00FFULL) * (1 + (100 << 16))) >> 16;
+  *out_value = ((chunk & 0x0000FFFF0000FFFFULL) * (1 + (10000ULL << 32))) >> 32;
+  return true;
+}
 
-  int32_t self_size = az_span_size(span);
+// Parses all of the digits in `span` into `out_number`, failing if the value exceeds `max_value`.
+AZ_NODISCARD static az_result _az_span_atou(az_span span, uint64_t max_value, uint64_t* out_number)
+{
+  enum
+  {
+    _az_EIGHT_DIGITS_BASE = 100000000,
+  };
+
+  uint8_t const* digits = az_span_ptr(span);
+  int32_t remaining = az_span_size(span);
   uint64_t value = 0;
 
-  for (int32_t i = 0; i < self_size; ++i)
+  // Overflow is exact: a chunk can only be added if the value it produces is within `max_value`.
+  while (remaining >= 8)
   {
-    uint8_t result = az_span_ptr(span)[i];
-    if (!isdigit(result))
+    uint64_t chunk;
+    if (!_az_span_parse_eight_digits(digits, &chunk)
+        || value > (max_value - chunk) / _az_EIGHT_DIGITS_BASE)
     {
       return AZ_ERROR_PARSER_UNEXPECTED_CHAR;
     }
-    uint64_t const d = (uint64_t)result - '0';
-    if ((UINT64_MAX - d) / 10 < value)
+    value = value * _az_EIGHT_DIGITS_BASE + chunk;
+    digits += 8;
+    remaining -= 8;
+  }
+
+  for (int32_t i = 0; i < remaining; ++i)
+  {
+    uint64_t const d = (uint64_t)digits[i] - '0';
+    if (d > 9 || value > (max_value - d) / 10)
     {
       return AZ_ERROR_PARSER_UNEXPECTED_CHAR;
     }
-
     value = value * 10 + d;
   }
 
@@ -127,56 +326,197 @@ AZ_NODISCARD az_result az_span_atou64(az_span span, uint64_t* out_number)
   return AZ_OK;
 }
 
+AZ_NODISCARD az_result az_span_atou64(az_span span, uint64_t* out_number)
+{
+  _az_PRECONDITION_VALID_SPAN(span, 1, false);
+  _az_PRECONDITION_NOT_NULL(out_number);
+
+  return _az_span_atou(span, UINT64_MAX, out_number);
+}
+
 AZ_NODISCARD az_result az_span_atou32(az_span span, uint32_t* out_number)
 {
   _az_PRECONDITION_VALID_SPAN(span, 1, false);
   _az_PRECONDITION_NOT_NULL(out_number);
 
-  int32_t self_size = az_span_size(span);
-  uint32_t value = 0;
+  uint64_t value;
+  AZ_RETURN_IF_FAILED(_az_span_atou(span, UINT32_MAX, &value));
+
+  *out_number = (uint32_t)value;
+  return AZ_OK;
+}
+
+enum
+{
+  // Targets shorter than this are searched by filtering candidate positions on their first and
+  // last bytes. Longer ones use the two-way algorithm, which is linear regardless of the input.
+  _az_SPAN_FIND_TWO_WAY_MIN_TARGET_SIZE = 32,
+};
 
-  for (int32_t i = 0; i < self_size; ++i)
+// Computes the critical factorization of `target` used by the two-way algorithm, returning the
+// index where its right half starts, and the period of that right half in `out_period`.
+AZ_NODISCARD static int32_t _az_span_find_critical_factorization(
+    uint8_t const* target,
+    int32_t target_size,
+    int32_t* out_period)
+{
+  // Maximal suffix for the "<" ordering.
+  int32_t max_suffix = -1;
+  int32_t j = 0;
+  int32_t k = 1;
+  int32_t period = 1;
+  while (j + k < target_size)
   {
-    uint8_t result = az_span_ptr(span)[i];
-    if (!isdigit(result))
+    uint8_t const a = target[j + k];
+    uint8_t const b = target[max_suffix + k];
+    if (a < b)
     {
-      return AZ_ERROR_PARSER_UNEXPECTED_CHAR;
+      j += k;
+      k = 1;
+      period = j - max_suffix;
     }
-    uint32_t const d = (uint32_t)result - '0';
-    if ((UINT32_MAX - d) / 10 < value)
+    else if (a == b)
     {
-      return AZ_ERROR_PARSER_UNEXPECTED_CHAR;
+      if (k != period)
+      {
+        k++;
+      }
+      else
+      {
+        j += period;
+        k = 1;
+      }
     }
+    else
+    {
+      max_suffix = j++;
+      k = period = 1;
+    }
+  }
+  *out_period = period;
+
+  // Maximal suffix for the ">" ordering.
+  int32_t max_suffix_reverse = -1;
+  j = 0;
+  k = 1;
+  period = 1;
+  while (j + k < target_size)
+  {
+    uint8_t const a = target[j + k];
+    uint8_t const b = target[max_suffix_reverse + k];
+    if (b < a)
+    {
+      j += k;
+      k = 1;
+      period = j - max_suffix_reverse;
+    }
+    else if (a == b)
+    {
+      if (k != period)
+      {
+        k++;
+      }
+      else
+      {
+        j += period;
+        k = 1;
+      }
+    }
+    else
+    {
+      max_suffix_reverse = j++;
+      k = period = 1;
+    }
+  }
 
-    value = value * 10 + d;
+  // The critical factorization is given by the longest of the two suffixes.
+  if (max_suffix_reverse < max_suffix)
+  {
+    return max_suffix + 1;
   }
+  *out_period = period;
+  return max_suffix_reverse + 1;
+}
 
-  *out_number = value;
-  return AZ_OK;
+// Crochemore-Perrin two-way string matching: O(n + m) comparisons with constant extra space.
+AZ_NODISCARD static int32_t _az_span_find_two_way(
+    uint8_t const* source,
+    int32_t source_size,
+    uint8_t const* target,
+    int32_t target_size)
+{
+  int32_t period;
+  int32_t const suffix = _az_span_find_critical_factorization(target, target_size, &period);
+  int32_t j = 0;
+
+  if (memcmp(target, target + period, (size_t)suffix) == 0)
+  {
+    // The target is periodic: remember how much of its left half is known to match after a shift
+    // by `period`, so those bytes are not compared again.
+    int32_t memory = 0;
+    while (j <= source_size - target_size)
+    {
+      int32_t i = suffix > memory ? suffix : memory;
+      while (i < target_size && target[i] == source[i + j])
+      {
+        i++;
+      }
+      if (i < target_size)
+      {
+        j += i - suffix + 1;
+        memory = 0;
+        continue;
+      }
+
+      i = suffix - 1;
+      while (i >= memory && target[i] == source[i + j])
+      {
+        i--;
+      }
+      if (i < memory)
+      {
+        return j;
+      }
+      j += period;
+      memory = target_size - period;
+    }
+  }
+  else
+  {
+    // The halves of the target are distinct: a mismatch on the left half allows shifting by more
+    // than either of them.
+    period = (suffix > target_size - suffix ? suffix : target_size - suffix) + 1;
+    while (j <= source_size - target_size)
+    {
+      int32_t i = suffix;
+      while (i < target_size && target[i] == source[i + j])
+      {
+        i++;
+      }
+      if (i < target_size)
+      {
+        j += i - suffix + 1;
+        continue;
+      }
+
+      i = suffix - 1;
+      while (i >= 0 && target[i] == source[i + j])
+      {
+        i--;
+      }
+      if (i < 0)
+      {
+        return j;
+      }
+      j += period;
+    }
+  }
+
+  return -1;
 }
 
 AZ_NODISCARD int32_t az_span_find(az_span source, az_span target)
 {
-  /* This function implements the Naive string-search algorithm.
-   * The rationale to use this algorithm instead of other potentialy more
-   * performing ones (Rabin-Karp, e.g.) is due to no additional space needed.
-   * The logic:
-   * 1. The function will look into each position of `source` if it contains the same value as the
-   * first position of `target`.
-   * 2. If it does, it could be that the next bytes in `source` are a perfect match of the remaining
-   * bytes of `target`.
-   * 3. Being so, it loops through the remaining bytes of `target` and see if they match exactly the
-   * next bytes of `source`.
-   * 4. If the loop gets to the end (all bytes of `target` are evaluated), it means `target` indeed
-   * occurs in that position of `source`.
-   * 5. If the loop gets interrupted before cruising through the entire `target`, the function must
-   * go back to step 1. from  the next position in `source`.
-   *   The loop in 5. gets interrupted if
-   *     - a byte in `target` is different than `source`, in the expected corresponding position;
-   *     - the loop has reached the end of `source` (and there are still remaing bytes of `target`
-   *         to be checked).
-   */
-
   int32_t source_size = az_span_size(source);
   int32_t target_size = az_span_size(target);
   const int32_t target_not_found = -1;
@@ -189,45 +529,34 @@ AZ_NODISCARD int32_t az_span_find(az_span source, az_span target)
   {
     return target_not_found;
   }
-  else
+
+  uint8_t* source_ptr = az_span_ptr(source);
+  uint8_t* target_ptr = az_span_ptr(target);
+
+  if (target_size >= _az_SPAN_FIND_TWO_WAY_MIN_TARGET_SIZE)
   {
-    uint8_t* source_ptr = az_span_ptr(source);
-    uint8_t* target_ptr = az_span_ptr(target);
+    return _az_span_find_two_way(source_ptr, source_size, target_ptr, target_size);
+  }
+
+  // Candidate positions are found with memchr() on the first byte of `target` (which the C library
+  // implements with word-wide or vector compares), and discarded early if the last byte of
+  // `target` does not match either. Only the remaining ones compare the bytes in between.
+  uint8_t const first = target_ptr[0];
+  uint8_t const last = target_ptr[target_size - 1];
+  uint8_t* current = source_ptr;
+  uint8_t* const end = source_ptr + (source_size - target_size) + 1;
 
-    // This loop traverses `source` position by position (step 1.)
-    for (int32_t i = 0; i < (source_size - target_size + 1); i++)
+  while (current < end
+         && (current = (uint8_t*)memchr(current, first, (size_t)(end - current))) != NULL)
+  {
+    if (current[target_size - 1] == last
+        && memcmp(current + 1, target_ptr + 1, (size_t)(target_size - 1)) == 0)
     {
-      // This is the check done in step 1. above.
-      if (source_ptr[i] == target_ptr[0])
-      {
-        // The condition in step 2. has been satisfied.
-        int32_t j;
-        // This is the loop defined in step 3.
-        // The loop must be broken if it reaches the ends of `target` (step 3.) OR `source`
-        // (step 5.).
-        for (j = 1; j < target_size && (i + j) < source_size; j++)
-        {
-          // Condition defined in step 5.
-          if (source_ptr[i + j] != target_ptr[j])
-          {
-            break;
-          }
-        }
-
-        if (j == target_size)
-        {
-          // All bytes in `target` have been checked and matched the corresponding bytes in `source`
-          // (from the start point `i`), so this is indeed an instance of `target` in that position
-          // of `source` (step 4.).
-
-          return i;
-        }
-      }
+      return (int32_t)(current - source_ptr);
     }
+    current++;
   }
 
-  // If the function hasn't returned before, all positions
-  // of `source` have been evaluated but `target` could not be found.
   return target_not_found;
 }
 
@@ -371,6 +700,8 @@ _az_span_replace(az_span self, int32_t current_size, int32_t start, int32_t end,
   return AZ_OK;
 }
 
+static AZ_NODISCARD az_result _az_span_builder_append_uint64(az_span* self, uint64_t n);
+
 AZ_NODISCARD az_result az_span_dtoa(az_span destination, double source, az_span* out_span)
 {
   _az_PRECONDITION_VALID_SPAN(destination, 0, false);
@@ -402,28 +733,7 @@ AZ_NODISCARD az_result az_span_dtoa(az_span destination, double source, az_span*
 
     if (*source_bin_rep_view == *u_bin_rep_view)
     {
-      uint64_t base = 1;
-      int32_t digit_count = 1;
-      {
-        uint64_t i = u;
-        while (10 <= i)
-        {
-          i /= 10;
-          base *= 10;
-          digit_count++;
-        }
-      }
-
-      AZ_RETURN_IF_NOT_ENOUGH_SIZE(*out_span, digit_count);
-
-      do
-      {
-        uint8_t dec = (uint8_t)((u / base) + '0');
-        u %= base;
-        base /= 10;
-        *out_span = az_span_copy_u8(*out_span, dec);
-      } while (1 <= base);
-      return AZ_OK;
+      return _az_span_builder_append_uint64(out_span, u);
     }
   }
 
@@ -443,38 +753,130 @@ AZ_NODISCARD az_result az_span_dtoa(az_span destination, double source, az_span*
   }
 }
 
-AZ_INLINE uint8_t _az_decimal_to_ascii(uint8_t d) { return (uint8_t)(('0' + d) & 0xFF); }
+// Decimal representation of every number from 0 to 99, so that digits are emitted two at a time.
+static uint8_t const _az_two_digits[] = "00010203040506070809"
+                                        "10111213141516171819"
+                                        "20212223242526272829"
+                                        "30313233343536373839"
+                                        "40414243444546474849"
+                                        "50515253545556575859"
+                                        "60616263646566676869"
+                                        "70717273747576777879"
+                                        "80818283848586878889"
+                                        "90919293949596979899";
+
+static uint64_t const _az_powers_of_ten[] = {
+  1ULL,
+  10ULL,
+  100ULL,
+  1000ULL,
+  10000ULL,
+  100000ULL,
+  1000000ULL,
+  10000000ULL,
+  100000000ULL,
+  1000000000ULL,
+  10000000000ULL,
+  100000000000ULL,
+  1000000000000ULL,
+  10000000000000ULL,
+  100000000000000ULL,
+  1000000000000000ULL,
+  10000000000000000ULL,
+  100000000000000000ULL,
+  1000000000000000000ULL,
+  10000000000000000000ULL,
+};
 
-static AZ_NODISCARD az_result _az_span_builder_append_uint64(az_span* self, uint64_t n)
+// Number of bits needed to represent `n`, which must not be 0.
+AZ_NODISCARD AZ_INLINE int32_t _az_bit_length(uint64_t n)
 {
-  AZ_RETURN_IF_NOT_ENOUGH_SIZE(*self, 1);
+#if defined(__GNUC__) || defined(__clang__)
+  return 64 - __builtin_clzll(n);
+#else // !__GNUC__ !__clang__
+  int32_t length = 1;
+  for (int32_t shift = 32; shift > 0; shift /= 2)
+  {
+    if (n >> shift != 0)
+    {
+      n >>= shift;
+      length += shift;
+    }
+  }
+  return length;
+#endif // __GNUC__ || __clang__
+}
 
-  if (n == 0)
+AZ_NODISCARD int32_t _az_span_u64toa_size(uint64_t number)
+{
+  // `number | 1` has the same digit count as `number`, and is never 0.
+  uint64_t const n = number | 1;
+
+  // 1233 / 4096 approximates log10(2): this gives the digit count of 2^bit_length - 1, which is
+  // either the digit count of n or one less.
+  int32_t const guess = (_az_bit_length(n) * 1233) >> 12;
+  return guess + (n >= _az_powers_of_ten[guess] ? 1 : 0);
+}
+
+AZ_NODISCARD int32_t _az_span_u32toa_size(uint32_t number)
+{
+  return _az_span_u64toa_size(number);
+}
+
+// Writes the `digit_count` decimal digits of `n` at `destination`, two digits per division.
+static void _az_span_write_u64_digits(uint8_t* destination, int32_t digit_count, uint64_t n)
+{
+  uint8_t* p = destination + digit_count;
+  while (n >= 100)
   {
-    *self = az_span_copy_u8(*self, '0');
-    return AZ_OK;
+    uint8_t const* const pair = _az_two_digits + (n % 100) * 2;
+    n /= 100;
+    *--p = pair[1];
+    *--p = pair[0];
   }
 
-  uint64_t div = 10000000000000000000ull;
-  uint64_t nn = n;
-  int32_t digit_count = 20;
-  while (nn / div == 0)
+  if (n >= 10)
   {
-    div /= 10;
-    digit_count--;
+    *--p = _az_two_digits[n * 2 + 1];
+    *--p = _az_two_digits[n * 2];
   }
+  else
+  {
+    *--p = (uint8_t)('0' + n);
+  }
+}
 
-  AZ_RETURN_IF_NOT_ENOUGH_SIZE(*self, digit_count);
+// Same as _az_span_write_u64_digits, using 32-bit divisions (which are much cheaper than 64-bit
+// ones on 32-bit targets).
+static void _az_span_write_u32_digits(uint8_t* destination, int32_t digit_count, uint32_t n)
+{
+  uint8_t* p = destination + digit_count;
+  while (n >= 100)
+  {
+    uint8_t const* const pair = _az_two_digits + (n % 100) * 2;
+    n /= 100;
+    *--p = pair[1];
+    *--p = pair[0];
+  }
 
-  while (div > 1)
+  if (n >= 10)
+  {
+    *--p = _az_two_digits[n * 2 + 1];
+    *--p = _az_two_digits[n * 2];
+  }
+  else
   {
-    uint8_t value_to_append = _az_decimal_to_ascii((uint8_t)(nn / div));
-    *self = az_span_copy_u8(*self, value_to_append);
-    nn %= div;
-    div /= 10;
+    *--p = (uint8_t)('0' + n);
   }
-  uint8_t value_to_append = _az_decimal_to_ascii((uint8_t)nn);
-  *self = az_span_copy_u8(*self, value_to_append);
+}
+
+static AZ_NODISCARD az_result _az_span_builder_append_uint64(az_span* self, uint64_t n)
+{
+  int32_t const digit_count = _az_span_u64toa_size(n);
+  AZ_RETURN_IF_NOT_ENOUGH_SIZE(*self, digit_count);
+
+  _az_span_write_u64_digits(az_span_ptr(*self), digit_count, n);
+  *self = az_span_slice_to_end(*self, digit_count);
   return AZ_OK;
 }
 
@@ -496,7 +898,8 @@ AZ_NODISCARD az_result az_span_i64toa(az_span destination, int64_t source, az_sp
   {
     AZ_RETURN_IF_NOT_ENOUGH_SIZE(destination, 1);
     *out_span = az_span_copy_u8(destination, '-');
-    return _az_span_builder_append_uint64(out_span, (uint64_t)-source);
+    // Negate as unsigned, since -INT64_MIN overflows int64_t.
+    return _az_span_builder_append_uint64(out_span, 0 - (uint64_t)source);
   }
 
   // make out_span point to destination before trying to write on it (might be an empty az_span or
@@ -508,38 +911,11 @@ AZ_NODISCARD az_result az_span_i64toa(az_span destination, int64_t source, az_sp
 static AZ_NODISCARD az_result
 _az_span_builder_append_u32toa(az_span self, uint32_t n, az_span* out_span)
 {
-  AZ_RETURN_IF_NOT_ENOUGH_SIZE(self, 1);
-
-  if (n == 0)
-  {
-    *out_span = az_span_copy_u8(self, '0');
-    return AZ_OK;
-  }
-
-  uint32_t div = 1000000000;
-  uint32_t nn = n;
-  int32_t digit_count = 10;
-  while (nn / div == 0)
-  {
-    div /= 10;
-    digit_count--;
-  }
-
+  int32_t const digit_count = _az_span_u32toa_size(n);
   AZ_RETURN_IF_NOT_ENOUGH_SIZE(self, digit_count);
 
-  *out_span = self;
-
-  while (div > 1)
-  {
-    uint8_t value_to_append = _az_decimal_to_ascii((uint8_t)(nn / div));
-    *out_span = az_span_copy_u8(*out_span, value_to_append);
-
-    nn %= div;
-    div /= 10;
-  }
-
-  uint8_t value_to_append = _az_decimal_to_ascii((uint8_t)nn);
-  *out_span = az_span_copy_u8(*out_span, value_to_append);
+  _az_span_write_u32_digits(az_span_ptr(self), digit_count, n);
+  *out_span = az_span_slice_to_end(self, digit_count);
   return AZ_OK;
 }
 
@@ -561,7 +937,8 @@ AZ_NODISCARD az_result az_span_i32toa(az_span destination, int32_t source, az_sp
   {
     AZ_RETURN_IF_NOT_ENOUGH_SIZE(*out_span, 1);
     *out_span = az_span_copy_u8(*out_span, '-');
-    source = -source;
+    // Negate as unsigned, since -INT32_MIN overflows int32_t.
+    return _az_span_builder_append_u32toa(*out_span, 0 - (uint32_t)source, out_span);
   }
 
   return _az_span_builder_append_u32toa(*out_span, (uint32_t)source, out_span);
@@ -692,56 +1069,86 @@ AZ_NODISCARD az_span _az_span_trim_white_space_from_end(az_span source)
   return _az_span_trim_side(source, RIGHT);
 }
 
-AZ_NODISCARD AZ_INLINE bool _az_span_url_should_encode(uint8_t c)
+// 1 for the characters that are never URL-encoded: the unreserved characters of RFC 3986.
+static uint8_t const _az_span_url_unreserved[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x00
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x10
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, // 0x20
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, // 0x30
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x40
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1, // 0x50
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x60
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 0, // 0x70
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x80
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x90
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xA0
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xB0
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xC0
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xD0
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xE0
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xF0
+};
+
+// Returns the number of unreserved characters at the start of `bytes`.
+AZ_NODISCARD AZ_INLINE int32_t _az_span_url_unreserved_run(uint8_t const* bytes, int32_t size)
 {
-  switch (c)
+  int32_t i = 0;
+  while (i < size && _az_span_url_unreserved[bytes[i]])
   {
-    case '-':
-    case '_':
-    case '.':
-    case '~':
-      return false;
-    default:
-      return !(('0' <= c && c <= '9') || ('A' <= c && c <= 'Z') || ('a' <= c && c <= 'z'));
+    i++;
   }
+  return i;
 }
 
-AZ_NODISCARD az_result _az_span_url_encode(az_span destination, az_span source, int32_t* out_length)
+AZ_NODISCARD int32_t _az_span_url_encode_size(az_span source)
 {
-  _az_PRECONDITION_NOT_NULL(out_length);
   _az_PRECONDITION_VALID_SPAN(source, 0, true);
 
+  uint8_t const* const src_ptr = az_span_ptr(source);
   int32_t const source_size = az_span_size(source);
-  _az_PRECONDITION_VALID_SPAN(destination, source_size, false);
 
-  int32_t result_size = 0;
+  // Each reserved character takes 2 more bytes once encoded.
+  int32_t result_size = source_size;
   for (int32_t i = 0; i < source_size; ++i)
   {
-    result_size += _az_span_url_should_encode(az_span_ptr(source)[i]) ? 3 : 1;
+    result_size += (1 - _az_span_url_unreserved[src_ptr[i]]) * 2;
   }
+  return result_size;
+}
+
+AZ_NODISCARD az_result _az_span_url_encode(az_span destination, az_span source, int32_t* out_length)
+{
+  _az_PRECONDITION_NOT_NULL(out_length);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+
+  int32_t const source_size = az_span_size(source);
+  _az_PRECONDITION_VALID_SPAN(destination, source_size, false);
 
+  int32_t const result_size = _az_span_url_encode_size(source);
   if (az_span_size(destination) < result_size)
   {
     *out_length = 0;
     return AZ_ERROR_INSUFFICIENT_SPAN_SIZE;
   }
 
-  uint8_t* const src_ptr = az_span_ptr(source);
+  uint8_t const* src_ptr = az_span_ptr(source);
+  uint8_t const* const src_end = src_ptr + source_size;
   uint8_t* dest_ptr = az_span_ptr(destination);
 
-  for (int32_t src_idx = 0; src_idx < source_size; ++src_idx)
+  while (src_ptr < src_end)
   {
-    uint8_t c = src_ptr[src_idx];
-    if (!_az_span_url_should_encode(c))
-    {
-      *dest_ptr = c;
-      dest_ptr += 1;
-    }
-    else
+    // Copy the run of characters that don't need encoding at once.
+    int32_t const run = _az_span_url_unreserved_run(src_ptr, (int32_t)(src_end - src_ptr));
+    memcpy(dest_ptr, src_ptr, (size_t)run);
+    src_ptr += run;
+    dest_ptr += run;
+
+    if (src_ptr < src_end)
     {
+      uint8_t const c = *src_ptr++;
       dest_ptr[0] = '%';
-      dest_ptr[1] = _az_number_to_upper_hex(c >> 4);
-      dest_ptr[2] = _az_number_to_upper_hex(c & 0x0F);
+      dest_ptr[1] = _az_number_to_upper_hex((uint8_t)(c >> 4));
+      dest_ptr[2] = _az_number_to_upper_hex((uint8_t)(c & 0x0F));
       dest_ptr += 3;
     }
   }
@@ -751,6 +1158,72 @@ AZ_NODISCARD az_result _az_span_url_encode(az_span destination, az_span source,
   return AZ_OK;
 }
 
+// Returns the value of hexadecimal digit `c` (in either case), or a value above 15 if it isn't one.
+AZ_NODISCARD AZ_INLINE uint8_t _az_span_hex_to_number(uint8_t c)
+{
+  if ((uint8_t)(c - '0') <= 9)
+  {
+    return (uint8_t)(c - '0');
+  }
+  uint8_t const lower = (uint8_t)(c | 0x20);
+  return (uint8_t)(lower - 'a') <= 5 ? (uint8_t)(lower - _az_HEX_LOWER_OFFSET) : UINT8_MAX;
+}
+
+AZ_NODISCARD az_result _az_span_url_decode(az_span destination, az_span source, int32_t* out_length)
+{
+  _az_PRECONDITION_NOT_NULL(out_length);
+  _az_PRECONDITION_VALID_SPAN(source, 0, true);
+  _az_PRECONDITION_VALID_SPAN(destination, 0, true);
+
+  uint8_t const* src_ptr = az_span_ptr(source);
+  uint8_t const* const src_end = src_ptr + az_span_size(source);
+  uint8_t* const dest_start = az_span_ptr(destination);
+  uint8_t* dest_ptr = dest_start;
+  uint8_t* const dest_end = dest_start + az_span_size(destination);
+
+  *out_length = 0;
+  while (src_ptr < src_end)
+  {
+    // Copy everything up to the next escape sequence at once. The destination is allowed to be
+    // the same buffer as the source, since decoding never writes ahead of what was read.
+    uint8_t const* const escape
+        = (uint8_t const*)memchr(src_ptr, '%', (size_t)(src_end - src_ptr));
+    size_t const run = (size_t)((escape == NULL ? src_end : escape) - src_ptr);
+    if ((size_t)(dest_end - dest_ptr) < run)
+    {
+      return AZ_ERROR_INSUFFICIENT_SPAN_SIZE;
+    }
+    memmove(dest_ptr, src_ptr, run);
+    src_ptr += run;
+    dest_ptr += run;
+
+    if (escape != NULL)
+    {
+      if (src_end - escape < 3)
+      {
+        return AZ_ERROR_EOF;
+      }
+
+      uint8_t const high = _az_span_hex_to_number(escape[1]);
+      uint8_t const low = _az_span_hex_to_number(escape[2]);
+      if (high > 0x0F || low > 0x0F)
+      {
+        return AZ_ERROR_PARSER_UNEXPECTED_CHAR;
+      }
+      if (dest_ptr == dest_end)
+      {
+        return AZ_ERROR_INSUFFICIENT_SPAN_SIZE;
+      }
+
+      *dest_ptr++ = (uint8_t)((high << 4) | low);
+      src_ptr += 3;
+    }
+  }
+
+  *out_length = (int32_t)(dest_ptr - dest_start);
+  return AZ_OK;
+}
+
 AZ_NODISCARD az_span _az_span_token(az_span source, az_span delimiter, az_span* out_remainder)
 {
   _az_PRECONDITION_VALID_SPAN(delimiter, 1, false);
@@ -776,3 +1249,112 @@ AZ_NODISCARD az_span _az_span_token(az_span source, az_span delimiter, az_span*
     return source;
   }
 }
+
+AZ_NODISCARD az_result az_span_arena_init(az_span_arena* out_arena, az_span buffer)
+{
+  _az_PRECONDITION_NOT_NULL(out_arena);
+  _az_PRECONDITION_VALID_SPAN(buffer, 0, true);
+
+  *out_arena = (az_span_arena){ ._internal = { .buffer = buffer, .used = 0 } };
+  return AZ_OK;
+}
+
+// Returns the number of padding bytes needed for the next allocation to be aligned.
+AZ_NODISCARD AZ_INLINE int32_t _az_span_arena_padding(az_span_arena const* arena)
+{
+  uintptr_t const next = (uintptr_t)(az_span_ptr(arena->_internal.buffer) + arena->_internal.used);
+  return (int32_t)((_az_SPAN_ARENA_ALIGNMENT - (next % _az_SPAN_ARENA_ALIGNMENT))
+                   % _az_SPAN_ARENA_ALIGNMENT);
+}
+
+AZ_NODISCARD int32_t az_span_arena_remaining(az_span_arena const* arena)
+{
+  _az_PRECONDITION_NOT_NULL(arena);
+
+  int32_t const remaining = az_span_size(arena->_internal.buffer) - arena->_internal.used
+      - _az_span_arena_padding(arena);
+  return remaining > 0 ? remaining : 0;
+}
+
+AZ_NODISCARD az_result az_span_arena_alloc(az_span_arena* arena, int32_t size, az_span* out_span)
+{
+  _az_PRECONDITION_NOT_NULL(arena);
+  _az_PRECONDITION(size >= 0);
+  _az_PRECONDITION_NOT_NULL(out_span);
+
+  int32_t const start = arena->_internal.used + _az_span_arena_padding(arena);
+  if (size > az_span_size(arena->_internal.buffer) - start)
+  {
+    return AZ_ERROR_INSUFFICIENT_SPAN_SIZE;
+  }
+
+  *out_span = az_span_slice(arena->_internal.buffer, start, start + size);
+  arena->_internal.used = start + size;
+  return AZ_OK;
+}
+
+void az_span_arena_reset(az_span_arena* arena, int32_t mark)
+{
+  _az_PRECONDITION_NOT_NULL(arena);
+  _az_PRECONDITION_RANGE(0, mark, arena->_internal.used);
+
+  arena->_internal.used = mark;
+}
+
+AZ_NODISCARD az_result az_span_list_init(az_span_list* out_list, az_span* spans, int32_t capacity)
+{
+  _az_PRECONDITION_NOT_NULL(out_list);
+  _az_PRECONDITION(capacity >= 0);
+  _az_PRECONDITION(capacity == 0 || spans != NULL);
+
+  *out_list = (az_span_list){
+    ._internal = { .spans = spans, .capacity = capacity, .count = 0, .size = 0 },
+  };
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_span_list_append(az_span_list* list, az_span span)
+{
+  _az_PRECONDITION_NOT_NULL(list);
+  _az_PRECONDITION_VALID_SPAN(span, 0, true);
+
+  if (az_span_size(span) == 0)
+  {
+    return AZ_OK;
+  }
+
+  if (list->_internal.count == list->_internal.capacity)
+  {
+    return AZ_ERROR_INSUFFICIENT_SPAN_SIZE;
+  }
+
+  list->_internal.spans[list->_internal.count] = span;
+  list->_internal.count++;
+  list->_internal.size += az_span_size(span);
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_span az_span_list_get(az_span_list const* list, int32_t index)
+{
+  _az_PRECONDITION_NOT_NULL(list);
+  _az_PRECONDITION_RANGE(0, index, list->_internal.count - 1);
+
+  return list->_internal.spans[index];
+}
+
+AZ_NODISCARD az_result
+az_span_list_flatten(az_span_list const* list, az_span destination, az_span* out_span)
+{
+  _az_PRECONDITION_NOT_NULL(list);
+  _az_PRECONDITION_NOT_NULL(out_span);
+
+  AZ_RETURN_IF_NOT_ENOUGH_SIZE(destination, list->_internal.size);
+
+  for (int32_t i = 0; i < list->_internal.count; i++)
+  {
+    destination = az_span_copy(destination, list->_internal.spans[i]);
+  }
+
+  *out_span = destination;
+  return AZ_OK;
+}
@@ -1,7 +1,9 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
+int test_az_base64();
 int test_az_context();
+int test_az_crypto();
 int test_az_credential_client_secret();
 int test_az_http();
 int test_az_json();
@@ -19,7 +19,9 @@ int main()
 
   // every test function returns the number of tests failed, 0 means success (there shouldn't be
   // negative numbers
+  result += test_az_base64();
   result += test_az_context();
+  result += test_az_crypto();
   result += test_az_credential_client_secret();
   result += test_az_http();
   result += test_az_json();
@@ -0,0 +1,206 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_test_definitions.h"
+#include <az_span.h>
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include <_az_cfg.h>
+
+#define TEST_BASE64_BUFFER_SIZE 300
+
+// Test vectors from RFC 4648, section 10.
+static az_span const test_decoded[] = {
+  AZ_SPAN_LITERAL_FROM_STR(""),     AZ_SPAN_LITERAL_FROM_STR("f"),
+  AZ_SPAN_LITERAL_FROM_STR("fo"),   AZ_SPAN_LITERAL_FROM_STR("foo"),
+  AZ_SPAN_LITERAL_FROM_STR("foob"), AZ_SPAN_LITERAL_FROM_STR("fooba"),
+  AZ_SPAN_LITERAL_FROM_STR("foobar"),
+};
+
+static az_span const test_encoded[] = {
+  AZ_SPAN_LITERAL_FROM_STR(""),         AZ_SPAN_LITERAL_FROM_STR("Zg=="),
+  AZ_SPAN_LITERAL_FROM_STR("Zm8="),     AZ_SPAN_LITERAL_FROM_STR("Zm9v"),
+  AZ_SPAN_LITERAL_FROM_STR("Zm9vYg=="), AZ_SPAN_LITERAL_FROM_STR("Zm9vYmE="),
+  AZ_SPAN_LITERAL_FROM_STR("Zm9vYmFy"),
+};
+
+static az_span const test_url_encoded[] = {
+  AZ_SPAN_LITERAL_FROM_STR(""),       AZ_SPAN_LITERAL_FROM_STR("Zg"),
+  AZ_SPAN_LITERAL_FROM_STR("Zm8"),    AZ_SPAN_LITERAL_FROM_STR("Zm9v"),
+  AZ_SPAN_LITERAL_FROM_STR("Zm9vYg"), AZ_SPAN_LITERAL_FROM_STR("Zm9vYmE"),
+  AZ_SPAN_LITERAL_FROM_STR("Zm9vYmFy"),
+};
+
+static void test_az_span_base64_encode_rfc_vectors_succeed(void** state)
+{
+  (void)state;
+  uint8_t buf[TEST_BASE64_BUFFER_SIZE];
+  az_span const buffer = AZ_SPAN_FROM_BUFFER(buf);
+  az_span remainder;
+
+  for (size_t i = 0; i < _az_COUNTOF(test_decoded); i++)
+  {
+    assert_int_equal(
+        az_span_base64_encode_size(az_span_size(test_decoded[i])), az_span_size(test_encoded[i]));
+    assert_return_code(az_span_base64_encode(buffer, test_decoded[i], &remainder), AZ_OK);
+    assert_true(az_span_is_content_equal(
+        az_span_slice(buffer, 0, az_span_size(buffer) - az_span_size(remainder)),
+        test_encoded[i]));
+
+    assert_int_equal(
+        az_span_base64_url_encode_size(az_span_size(test_decoded[i])),
+        az_span_size(test_url_encoded[i]));
+    assert_return_code(az_span_base64_url_encode(buffer, test_decoded[i], &remainder), AZ_OK);
+    assert_true(az_span_is_content_equal(
+        az_span_slice(buffer, 0, az_span_size(buffer) - az_span_size(remainder)),
+        test_url_encoded[i]));
+  }
+}
+
+static void test_az_span_base64_decode_rfc_vectors_succeed(void** state)
+{
+  (void)state;
+  uint8_t buf[TEST_BASE64_BUFFER_SIZE];
+  az_span const buffer = AZ_SPAN_FROM_BUFFER(buf);
+  az_span remainder;
+
+  for (size_t i = 0; i < _az_COUNTOF(test_decoded); i++)
+  {
+    assert_int_equal(az_span_base64_decode_size(test_encoded[i]), az_span_size(test_decoded[i]));
+    assert_return_code(az_span_base64_decode(buffer, test_encoded[i], &remainder), AZ_OK);
+    assert_true(az_span_is_content_equal(
+        az_span_slice(buffer, 0, az_span_size(buffer) - az_span_size(remainder)),
+        test_decoded[i]));
+
+    // base64url accepts both unpadded and padded input.
+    assert_int_equal(
+        az_span_base64_decode_size(test_url_encoded[i]), az_span_size(test_decoded[i]));
+    assert_return_code(az_span_base64_url_decode(buffer, test_url_encoded[i], &remainder), AZ_OK);
+    assert_true(az_span_is_content_equal(
+        az_span_slice(buffer, 0, az_span_size(buffer) - az_span_size(remainder)),
+        test_decoded[i]));
+    assert_return_code(az_span_base64_url_decode(buffer, test_encoded[i], &remainder), AZ_OK);
+    assert_true(az_span_is_content_equal(
+        az_span_slice(buffer, 0, az_span_size(buffer) - az_span_size(remainder)),
+        test_decoded[i]));
+  }
+}
+
+static void test_az_span_base64_round_trip_succeed(void** state)
+{
+  (void)state;
+  uint8_t source_buf[100];
+  uint8_t encoded_buf[TEST_BASE64_BUFFER_SIZE];
+  uint8_t decoded_buf[TEST_BASE64_BUFFER_SIZE];
+  az_span remainder;
+
+  for (size_t i = 0; i < sizeof(source_buf); i++)
+  {
+    // Covers all 6-bit values, including the ones that differ between the alphabets.
+    source_buf[i] = (uint8_t)(i * 167 + 13);
+  }
+
+  for (int32_t size = 0; size <= (int32_t)sizeof(source_buf); size++)
+  {
+    az_span const source = az_span_init(source_buf, size);
+
+    assert_return_code(
+        az_span_base64_encode(AZ_SPAN_FROM_BUFFER(encoded_buf), source, &remainder), AZ_OK);
+    az_span encoded = az_span_init(
+        encoded_buf, (int32_t)sizeof(encoded_buf) - az_span_size(remainder));
+    assert_int_equal(az_span_size(encoded), az_span_base64_encode_size(size));
+    assert_return_code(
+        az_span_base64_decode(AZ_SPAN_FROM_BUFFER(decoded_buf), encoded, &remainder), AZ_OK);
+    assert_int_equal((int32_t)sizeof(decoded_buf) - az_span_size(remainder), size);
+    assert_memory_equal(decoded_buf, source_buf, (size_t)size);
+
+    assert_return_code(
+        az_span_base64_url_encode(AZ_SPAN_FROM_BUFFER(encoded_buf), source, &remainder), AZ_OK);
+    encoded = az_span_init(encoded_buf, (int32_t)sizeof(encoded_buf) - az_span_size(remainder));
+    assert_int_equal(az_span_size(encoded), az_span_base64_url_encode_size(size));
+    assert_null(memchr(encoded_buf, '+', (size_t)az_span_size(encoded)));
+    assert_null(memchr(encoded_buf, '/', (size_t)az_span_size(encoded)));
+
+    // Decode in place.
+    assert_return_code(az_span_base64_url_decode(encoded, encoded, &remainder), AZ_OK);
+    assert_int_equal(az_span_size(encoded) - az_span_size(remainder), size);
+    assert_memory_equal(encoded_buf, source_buf, (size_t)size);
+  }
+}
+
+static void test_az_span_base64_decode_invalid_fails(void** state)
+{
+  (void)state;
+  uint8_t buf[TEST_BASE64_BUFFER_SIZE];
+  az_span const buffer = AZ_SPAN_FROM_BUFFER(buf);
+  az_span remainder;
+
+  az_span const invalid[] = {
+    AZ_SPAN_FROM_STR("Zg"), // missing padding
+    AZ_SPAN_FROM_STR("Zm9vY"), // 1 character left over
+    AZ_SPAN_FROM_STR("Z==="),
+    AZ_SPAN_FROM_STR("Zg=a"),
+    AZ_SPAN_FROM_STR("Zm9-"), // base64url character
+    AZ_SPAN_FROM_STR("Zm 9v"),
+    AZ_SPAN_FROM_STR("Zm9v\x80mFy"),
+  };
+  for (size_t i = 0; i < _az_COUNTOF(invalid); i++)
+  {
+    assert_true(
+        az_span_base64_decode(buffer, invalid[i], &remainder) == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+  }
+
+  assert_true(
+      az_span_base64_url_decode(buffer, AZ_SPAN_FROM_STR("Zm9v+A"), &remainder)
+      == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+  assert_true(
+      az_span_base64_url_decode(buffer, AZ_SPAN_FROM_STR("Zg="), &remainder)
+      == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+  assert_true(
+      az_span_base64_url_decode(buffer, AZ_SPAN_FROM_STR("Zm9vY"), &remainder)
+      == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+}
+
+static void test_az_span_base64_insufficient_size_fails(void** state)
+{
+  (void)state;
+  uint8_t buf[7];
+  az_span remainder;
+
+  assert_true(
+      az_span_base64_encode(AZ_SPAN_FROM_BUFFER(buf), AZ_SPAN_FROM_STR("fooba"), &remainder)
+      == AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+  assert_return_code(
+      az_span_base64_url_encode(AZ_SPAN_FROM_BUFFER(buf), AZ_SPAN_FROM_STR("fooba"), &remainder),
+      AZ_OK);
+  assert_int_equal(az_span_size(remainder), 0);
+
+  assert_true(
+      az_span_base64_decode(
+          az_span_init(buf, 5), AZ_SPAN_FROM_STR("Zm9vYmFy"), &remainder)
+      == AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+  assert_return_code(
+      az_span_base64_decode(az_span_init(buf, 6), AZ_SPAN_FROM_STR("Zm9vYmFy"), &remainder),
+      AZ_OK);
+  assert_int_equal(az_span_size(remainder), 0);
+}
+
+int test_az_base64()
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_az_span_base64_encode_rfc_vectors_succeed),
+    cmocka_unit_test(test_az_span_base64_decode_rfc_vectors_succeed),
+    cmocka_unit_test(test_az_span_base64_round_trip_succeed),
+    cmocka_unit_test(test_az_span_base64_decode_invalid_fails),
+    cmocka_unit_test(test_az_span_base64_insufficient_size_fails),
+  };
+  return cmocka_run_group_tests_name("az_core_base64", tests, NULL, NULL);
+}
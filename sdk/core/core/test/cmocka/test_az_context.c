@@ -41,10 +41,104 @@ static void az_context_test(void** state)
   assert_true(expiration == 0);
 }
 
+static void az_context_expiration_cache_test(void** state)
+{
+  (void)state;
+
+  az_context ctx1 = az_context_with_expiration(&az_context_app, 300);
+  az_context ctx2 = az_context_with_expiration(&ctx1, 200);
+  az_context ctx3 = az_context_with_value(&ctx2, "k", "v");
+  az_context ctx4 = az_context_with_expiration(&ctx3, 400);
+
+  assert_int_equal(az_context_get_expiration(&ctx1), 300);
+  assert_int_equal(az_context_get_expiration(&ctx4), 200);
+
+  // Canceling a node in the middle of the chain reaches the nodes created from it before.
+  az_context_cancel(&ctx2);
+  assert_int_equal(az_context_get_expiration(&ctx1), 300);
+  assert_int_equal(az_context_get_expiration(&ctx2), 0);
+  assert_int_equal(az_context_get_expiration(&ctx4), 0);
+
+  // And the nodes created from it after.
+  az_context ctx5 = az_context_with_expiration(&ctx4, 500);
+  assert_int_equal(az_context_get_expiration(&ctx5), 0);
+}
+
+static void az_context_cancel_unrelated_test(void** state)
+{
+  (void)state;
+
+  az_context client = az_context_with_expiration(&az_context_app, 1000);
+  az_context request = az_context_with_expiration(&client, 500);
+  az_context other_client = az_context_with_value(&az_context_app, "k", "v");
+  az_context other_request = az_context_with_expiration(&other_client, 200);
+
+  // Canceling a context of another tree leaves the expirations of this one as they were, both for
+  // the nodes created before and after it.
+  az_context_cancel(&other_request);
+  az_context later_request = az_context_with_expiration(&client, 700);
+  assert_int_equal(az_context_get_expiration(&other_request), 0);
+  assert_int_equal(az_context_get_expiration(&other_client), _az_CONTEXT_MAX_EXPIRATION);
+  assert_int_equal(az_context_get_expiration(&client), 1000);
+  assert_int_equal(az_context_get_expiration(&request), 500);
+  assert_int_equal(az_context_get_expiration(&later_request), 700);
+
+  // Canceling it again doesn't change anything either.
+  az_context_cancel(&other_request);
+  assert_int_equal(az_context_get_expiration(&other_request), 0);
+  assert_int_equal(az_context_get_expiration(&later_request), 700);
+
+  // While canceling their parent still reaches them all.
+  az_context_cancel(&client);
+  assert_int_equal(az_context_get_expiration(&request), 0);
+  assert_int_equal(az_context_get_expiration(&later_request), 0);
+  assert_int_equal(az_context_get_expiration(&other_client), _az_CONTEXT_MAX_EXPIRATION);
+}
+
+static void az_context_value_cache_test(void** state)
+{
+  (void)state;
+
+  char keys[_az_CONTEXT_VALUE_CACHE_SIZE + 2];
+  char values[_az_CONTEXT_VALUE_CACHE_SIZE + 2];
+
+  // More keys than a node caches, with a node overriding the value of the first key.
+  az_context contexts[_az_CONTEXT_VALUE_CACHE_SIZE + 3];
+  contexts[0] = az_context_with_value(&az_context_app, &keys[0], &values[0]);
+  for (int32_t i = 1; i < _az_CONTEXT_VALUE_CACHE_SIZE + 2; ++i)
+  {
+    contexts[i] = az_context_with_value(&contexts[i - 1], &keys[i], &values[i]);
+  }
+  az_context const* const last = &contexts[_az_CONTEXT_VALUE_CACHE_SIZE + 2];
+  contexts[_az_CONTEXT_VALUE_CACHE_SIZE + 2]
+      = az_context_with_value(&contexts[_az_CONTEXT_VALUE_CACHE_SIZE + 1], &keys[0], &values[1]);
+
+  void* value = NULL;
+  for (int32_t i = 1; i < _az_CONTEXT_VALUE_CACHE_SIZE + 2; ++i)
+  {
+    assert_return_code(az_context_get_value(last, &keys[i], &value), AZ_OK);
+    assert_ptr_equal(value, &values[i]);
+  }
+
+  assert_return_code(az_context_get_value(last, &keys[0], &value), AZ_OK);
+  assert_ptr_equal(value, &values[1]);
+  assert_return_code(az_context_get_value(&contexts[0], &keys[0], &value), AZ_OK);
+  assert_ptr_equal(value, &values[0]);
+
+  // A miss on a node that caches every key of its chain, and on one that doesn't.
+  assert_int_equal(az_context_get_value(&contexts[1], "", &value), AZ_ERROR_ITEM_NOT_FOUND);
+  assert_null(value);
+  assert_int_equal(az_context_get_value(last, "", &value), AZ_ERROR_ITEM_NOT_FOUND);
+  assert_null(value);
+}
+
 int test_az_context()
 {
   const struct CMUnitTest tests[] = {
     cmocka_unit_test(az_context_test),
+    cmocka_unit_test(az_context_expiration_cache_test),
+    cmocka_unit_test(az_context_cancel_unrelated_test),
+    cmocka_unit_test(az_context_value_cache_test),
   };
   return cmocka_run_group_tests_name("az_core_context", tests, NULL, NULL);
 }
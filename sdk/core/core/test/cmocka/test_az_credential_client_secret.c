@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
+#include "az_aad_private.h"
 #include "az_test_definitions.h"
 #include <az_credentials.h>
 #include <az_credentials_internal.h>
@@ -101,6 +102,30 @@ static void test_credential_client_secret(void** state)
   }
 }
 
+static void test_credential_client_secret_unaligned_buffer(void** state)
+{
+  (void)state;
+
+  // Make the buffer start right past an aligned address, so the first allocation needs the most
+  // padding.
+  uint64_t aligned_buf[(_az_AAD_BUF_SIZE + 1 + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+  az_span const buf = az_span_init((uint8_t*)aligned_buf + 1, _az_AAD_BUF_SIZE);
+
+  az_span_arena arena;
+  assert_return_code(az_span_arena_init(&arena, buf), AZ_OK);
+
+  // The same allocations as a token request, in the same order.
+  az_span url;
+  assert_return_code(az_span_arena_alloc(&arena, _az_AAD_REQUEST_URL_BUF_SIZE, &url), AZ_OK);
+  az_span body;
+  assert_return_code(az_span_arena_alloc(&arena, _az_AAD_REQUEST_BODY_BUF_SIZE, &body), AZ_OK);
+  az_span headers;
+  assert_return_code(
+      az_span_arena_alloc(&arena, _az_AAD_REQUEST_HEADER_BUF_SIZE, &headers), AZ_OK);
+  az_span response;
+  assert_return_code(az_span_arena_alloc(&arena, _az_AAD_RESPONSE_BUF_SIZE, &response), AZ_OK);
+}
+
 az_result send_request(_az_http_request* request, az_http_response* response);
 
 az_result send_request(_az_http_request* request, az_http_response* response)
@@ -255,6 +280,7 @@ int test_az_credential_client_secret()
 {
   const struct CMUnitTest tests[] = {
     cmocka_unit_test(test_credential_client_secret),
+    cmocka_unit_test(test_credential_client_secret_unaligned_buffer),
   };
   return cmocka_run_group_tests_name("az_core_credential_client_secret", tests, NULL, NULL);
 }
@@ -0,0 +1,208 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "az_test_definitions.h"
+#include <az_crypto_internal.h>
+#include <az_span.h>
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include <_az_cfg.h>
+
+// SHA-256 test vectors from FIPS 180-2 (appendix B), HMAC-SHA256 test vectors from RFC 4231.
+static uint8_t const sha256_empty[] = {
+  0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14,
+  0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+  0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c,
+  0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55,
+};
+
+static uint8_t const sha256_abc[] = {
+  0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+  0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+  0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+  0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+};
+
+static uint8_t const sha256_two_blocks[] = {
+  0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+  0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+  0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+  0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1,
+};
+
+static uint8_t const sha256_million_a[] = {
+  0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92,
+  0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+  0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e,
+  0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0,
+};
+
+static uint8_t const hmac_case_1[] = {
+  0xb0, 0x34, 0x4c, 0x61, 0xd8, 0xdb, 0x38, 0x53,
+  0x5c, 0xa8, 0xaf, 0xce, 0xaf, 0x0b, 0xf1, 0x2b,
+  0x88, 0x1d, 0xc2, 0x00, 0xc9, 0x83, 0x3d, 0xa7,
+  0x26, 0xe9, 0x37, 0x6c, 0x2e, 0x32, 0xcf, 0xf7,
+};
+
+static uint8_t const hmac_case_2[] = {
+  0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e,
+  0x6a, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7,
+  0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83,
+  0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43,
+};
+
+static uint8_t const hmac_case_3[] = {
+  0x77, 0x3e, 0xa9, 0x1e, 0x36, 0x80, 0x0e, 0x46,
+  0x85, 0x4d, 0xb8, 0xeb, 0xd0, 0x91, 0x81, 0xa7,
+  0x29, 0x59, 0x09, 0x8b, 0x3e, 0xf8, 0xc1, 0x22,
+  0xd9, 0x63, 0x55, 0x14, 0xce, 0xd5, 0x65, 0xfe,
+};
+
+static uint8_t const hmac_case_6[] = {
+  0x60, 0xe4, 0x31, 0x59, 0x1e, 0xe0, 0xb6, 0x7f,
+  0x0d, 0x8a, 0x26, 0xaa, 0xcb, 0xf5, 0xb7, 0x7f,
+  0x8e, 0x0b, 0xc6, 0x21, 0x37, 0x28, 0xc5, 0x14,
+  0x05, 0x46, 0x04, 0x0f, 0x0e, 0xe3, 0x7f, 0x54,
+};
+
+static void _test_sha256(az_span message, uint8_t const* expected)
+{
+  uint8_t hash_buf[_az_SHA256_HASH_SIZE];
+  az_span hash;
+  _az_sha256 sha256;
+
+  _az_sha256_init(&sha256);
+  _az_sha256_update(&sha256, message);
+  assert_return_code(_az_sha256_final(&sha256, AZ_SPAN_FROM_BUFFER(hash_buf), &hash), AZ_OK);
+  assert_int_equal(az_span_size(hash), _az_SHA256_HASH_SIZE);
+  assert_memory_equal(az_span_ptr(hash), expected, _az_SHA256_HASH_SIZE);
+}
+
+static void _test_hmac_sha256(az_span key_bytes, az_span message, uint8_t const* expected)
+{
+  uint8_t signature_buf[_az_SHA256_HASH_SIZE + 1];
+  az_span signature;
+  _az_hmac_sha256_key key;
+
+  _az_hmac_sha256_key_init(&key, key_bytes);
+
+  // The precomputed key can sign any number of messages.
+  for (int i = 0; i < 2; i++)
+  {
+    assert_return_code(
+        _az_hmac_sha256_sign(&key, message, AZ_SPAN_FROM_BUFFER(signature_buf), &signature),
+        AZ_OK);
+    assert_int_equal(az_span_size(signature), _az_SHA256_HASH_SIZE);
+    assert_memory_equal(az_span_ptr(signature), expected, _az_SHA256_HASH_SIZE);
+  }
+}
+
+static void test_az_sha256_succeeds(void** state)
+{
+  (void)state;
+  _test_sha256(AZ_SPAN_NULL, sha256_empty);
+  _test_sha256(AZ_SPAN_FROM_STR("abc"), sha256_abc);
+
+  // The padding does not fit in the block holding the end of this 56-byte message.
+  _test_sha256(
+      AZ_SPAN_FROM_STR("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+      sha256_two_blocks);
+}
+
+static void test_az_sha256_incremental_succeeds(void** state)
+{
+  (void)state;
+  uint8_t a_buf[200];
+  memset(a_buf, 'a', sizeof(a_buf));
+
+  uint8_t hash_buf[_az_SHA256_HASH_SIZE];
+  az_span hash;
+  _az_sha256 sha256;
+  _az_sha256_init(&sha256);
+
+  // Feed one million 'a' in chunks of varying sizes, so that every block boundary offset is hit.
+  int32_t remaining = 1000000;
+  for (int32_t i = 0; remaining > 0; i++)
+  {
+    int32_t const size = remaining < (i % 200) ? remaining : (i % 200);
+    _az_sha256_update(&sha256, az_span_init(a_buf, size));
+    remaining -= size;
+  }
+
+  assert_return_code(_az_sha256_final(&sha256, AZ_SPAN_FROM_BUFFER(hash_buf), &hash), AZ_OK);
+  assert_memory_equal(az_span_ptr(hash), sha256_million_a, _az_SHA256_HASH_SIZE);
+}
+
+static void test_az_hmac_sha256_succeeds(void** state)
+{
+  (void)state;
+  uint8_t key_buf[131];
+  uint8_t data_buf[50];
+
+  memset(key_buf, 0x0b, 20);
+  _test_hmac_sha256(az_span_init(key_buf, 20), AZ_SPAN_FROM_STR("Hi There"), hmac_case_1);
+
+  _test_hmac_sha256(
+      AZ_SPAN_FROM_STR("Jefe"), AZ_SPAN_FROM_STR("what do ya want for nothing?"), hmac_case_2);
+
+  memset(key_buf, 0xaa, sizeof(key_buf));
+  memset(data_buf, 0xdd, sizeof(data_buf));
+  _test_hmac_sha256(az_span_init(key_buf, 20), AZ_SPAN_FROM_BUFFER(data_buf), hmac_case_3);
+
+  // Keys longer than the block size are hashed first.
+  _test_hmac_sha256(
+      AZ_SPAN_FROM_BUFFER(key_buf),
+      AZ_SPAN_FROM_STR("Test Using Larger Than Block-Size Key - Hash Key First"),
+      hmac_case_6);
+}
+
+static void test_az_crypto_wipe_succeeds(void** state)
+{
+  (void)state;
+  uint8_t buffer[_az_SHA256_HASH_SIZE];
+  memset(buffer, 0xA5, sizeof(buffer));
+
+  _az_crypto_wipe(buffer, sizeof(buffer));
+
+  uint8_t const zeros[_az_SHA256_HASH_SIZE] = { 0 };
+  assert_memory_equal(buffer, zeros, sizeof(buffer));
+}
+
+static void test_az_crypto_insufficient_size_fails(void** state)
+{
+  (void)state;
+  uint8_t buf[_az_SHA256_HASH_SIZE - 1];
+  az_span out;
+
+  _az_sha256 sha256;
+  _az_sha256_init(&sha256);
+  assert_true(
+      _az_sha256_final(&sha256, AZ_SPAN_FROM_BUFFER(buf), &out)
+      == AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+
+  _az_hmac_sha256_key key;
+  _az_hmac_sha256_key_init(&key, AZ_SPAN_FROM_STR("Jefe"));
+  assert_true(
+      _az_hmac_sha256_sign(&key, AZ_SPAN_FROM_STR("abc"), AZ_SPAN_FROM_BUFFER(buf), &out)
+      == AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+}
+
+int test_az_crypto()
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_az_sha256_succeeds),
+    cmocka_unit_test(test_az_sha256_incremental_succeeds),
+    cmocka_unit_test(test_az_hmac_sha256_succeeds),
+    cmocka_unit_test(test_az_crypto_wipe_succeeds),
+    cmocka_unit_test(test_az_crypto_insufficient_size_fails),
+  };
+  return cmocka_run_group_tests_name("az_core_crypto", tests, NULL, NULL);
+}
@@ -210,6 +210,257 @@ static void test_http_request(void** state)
   }
 }
 
+static void test_http_request_body_list(void** state)
+{
+  (void)state;
+  uint8_t buf[100];
+  uint8_t header_buf[(2 * sizeof(az_pair))];
+  az_span url_span = AZ_SPAN_FROM_BUFFER(buf);
+  az_span_copy(url_span, hrb_url);
+  _az_http_request hrb;
+
+  TEST_EXPECT_SUCCESS(az_http_request_init(
+      &hrb,
+      &az_context_app,
+      az_http_method_post(),
+      url_span,
+      az_span_size(hrb_url),
+      AZ_SPAN_FROM_BUFFER(header_buf),
+      AZ_SPAN_FROM_STR("body")));
+  assert_int_equal(az_http_request_body_spans_count(&hrb), 1);
+  assert_int_equal(az_http_request_body_size(&hrb), 4);
+
+  az_span spans[3];
+  az_span_list body_list;
+  TEST_EXPECT_SUCCESS(az_span_list_init(&body_list, spans, _az_COUNTOF(spans)));
+  TEST_EXPECT_SUCCESS(az_span_list_append(&body_list, AZ_SPAN_FROM_STR("{\"value\":\"")));
+  TEST_EXPECT_SUCCESS(az_span_list_append(&body_list, AZ_SPAN_FROM_STR("secret")));
+  TEST_EXPECT_SUCCESS(az_span_list_append(&body_list, AZ_SPAN_FROM_STR("\"}")));
+  uint8_t body_buf[18];
+  az_span const body_buffer = AZ_SPAN_FROM_BUFFER(body_buf);
+  TEST_EXPECT_SUCCESS(az_http_request_set_body_list(
+      &hrb, &body_list, az_span_slice(body_buffer, 0, az_span_size(body_buffer) - 1)));
+
+  assert_int_equal(az_http_request_body_spans_count(&hrb), 3);
+  assert_int_equal(az_http_request_body_size(&hrb), 18);
+
+  az_span span;
+  assert_return_code(az_http_request_get_body_span(&hrb, 1, &span), AZ_OK);
+  assert_true(az_span_is_content_equal(span, AZ_SPAN_FROM_STR("secret")));
+  assert_int_equal(az_http_request_get_body_span(&hrb, 3, &span), AZ_ERROR_ARG);
+
+  // Transports that need the body in one piece get it copied to the buffer, if it fits.
+  az_span body;
+  assert_int_equal(az_http_request_get_body(&hrb, &body), AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+  TEST_EXPECT_SUCCESS(az_http_request_set_body_list(&hrb, &body_list, body_buffer));
+  assert_return_code(az_http_request_get_body(&hrb, &body), AZ_OK);
+  assert_true(az_span_is_content_equal(body, AZ_SPAN_FROM_STR("{\"value\":\"secret\"}")));
+}
+
+static void test_http_request_append_path_with_query(void** state)
+{
+  (void)state;
+  uint8_t buf[64];
+  uint8_t header_buf[(2 * sizeof(az_pair))];
+  az_span url = AZ_SPAN_FROM_STR("https://host/a");
+  az_span url_span = AZ_SPAN_FROM_BUFFER(buf);
+  az_span_copy(url_span, url);
+  _az_http_request hrb;
+
+  TEST_EXPECT_SUCCESS(az_http_request_init(
+      &hrb,
+      &az_context_app,
+      az_http_method_get(),
+      url_span,
+      az_span_size(url),
+      AZ_SPAN_FROM_BUFFER(header_buf),
+      AZ_SPAN_NULL));
+  TEST_EXPECT_SUCCESS(
+      az_http_request_set_query_parameter(&hrb, AZ_SPAN_FROM_STR("x"), AZ_SPAN_FROM_STR("1")));
+
+  assert_return_code(az_http_request_append_path(&hrb, AZ_SPAN_FROM_STR("b")), AZ_OK);
+
+  az_span result;
+  assert_return_code(az_http_request_get_url(&hrb, &result), AZ_OK);
+  assert_true(az_span_is_content_equal(result, AZ_SPAN_FROM_STR("https://host/a/b?x=1")));
+
+  uint8_t path[64] = { 0 };
+  assert_int_equal(
+      az_http_request_append_path(&hrb, AZ_SPAN_FROM_BUFFER(path)),
+      AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+}
+
+static void test_http_request_init_from_template(void** state)
+{
+  (void)state;
+  uint8_t template_url_buf[64];
+  uint8_t template_header_buf[(2 * sizeof(az_pair))];
+  _az_http_request_template request_template;
+
+  TEST_EXPECT_SUCCESS(_az_http_request_template_init(
+      &request_template,
+      AZ_SPAN_FROM_BUFFER(template_url_buf),
+      AZ_SPAN_FROM_STR("https://host"),
+      AZ_SPAN_FROM_BUFFER(template_header_buf)));
+
+  _az_http_policy_apiversion_options api_version = _az_http_policy_apiversion_options_default();
+  api_version._internal.option_location = _az_http_policy_apiversion_option_location_queryparameter;
+  api_version._internal.name = hrb_param_api_version_name;
+  api_version._internal.version = hrb_param_api_version_token;
+  TEST_EXPECT_SUCCESS(_az_http_request_template_add_apiversion(&request_template, &api_version));
+
+  _az_http_policy_telemetry_options telemetry = _az_http_policy_telemetry_options_default();
+  TEST_EXPECT_SUCCESS(_az_http_request_template_add_telemetry(&request_template, &telemetry));
+
+  uint8_t url_buf[64];
+  uint8_t header_buf[(3 * sizeof(az_pair))];
+  _az_http_request hrb;
+  TEST_EXPECT_SUCCESS(_az_http_request_init_from_template(
+      &hrb,
+      &az_context_app,
+      az_http_method_get(),
+      AZ_SPAN_FROM_BUFFER(url_buf),
+      AZ_SPAN_FROM_BUFFER(header_buf),
+      AZ_SPAN_NULL,
+      &request_template));
+
+  // Variable parts are added to the copy only
+  TEST_EXPECT_SUCCESS(az_http_request_append_path(&hrb, AZ_SPAN_FROM_STR("keys")));
+  TEST_EXPECT_SUCCESS(az_http_request_append_header(
+      &hrb, hrb_header_content_type_name, hrb_header_content_type_token));
+
+  az_span url;
+  TEST_EXPECT_SUCCESS(az_http_request_get_url(&hrb, &url));
+  assert_true(
+      az_span_is_content_equal(url, AZ_SPAN_FROM_STR("https://host/keys?api-version=7.0")));
+
+  assert_int_equal(az_http_request_headers_count(&hrb), 2);
+  az_pair header;
+  TEST_EXPECT_SUCCESS(az_http_request_get_header(&hrb, 0, &header));
+  assert_true(az_span_is_content_equal(header.key, AZ_SPAN_FROM_STR("User-Agent")));
+  assert_true(az_span_is_content_equal(header.value, telemetry.os));
+  TEST_EXPECT_SUCCESS(az_http_request_get_header(&hrb, 1, &header));
+  assert_true(az_span_is_content_equal(header.key, hrb_header_content_type_name));
+
+  // The template is left untouched
+  TEST_EXPECT_SUCCESS(_az_http_request_init_from_template(
+      &hrb,
+      &az_context_app,
+      az_http_method_get(),
+      AZ_SPAN_FROM_BUFFER(url_buf),
+      AZ_SPAN_FROM_BUFFER(header_buf),
+      AZ_SPAN_NULL,
+      &request_template));
+  TEST_EXPECT_SUCCESS(az_http_request_get_url(&hrb, &url));
+  assert_true(az_span_is_content_equal(url, AZ_SPAN_FROM_STR("https://host?api-version=7.0")));
+  assert_int_equal(az_http_request_headers_count(&hrb), 1);
+
+  uint8_t small_url_buf[8];
+  assert_int_equal(
+      _az_http_request_init_from_template(
+          &hrb,
+          &az_context_app,
+          az_http_method_get(),
+          AZ_SPAN_FROM_BUFFER(small_url_buf),
+          AZ_SPAN_FROM_BUFFER(header_buf),
+          AZ_SPAN_NULL,
+          &request_template),
+      AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+}
+
+static void test_http_request_header_by_name(void** state)
+{
+  (void)state;
+  uint8_t url_buf[100];
+  uint8_t header_buf[(20 * sizeof(az_pair))];
+  az_span url_span = AZ_SPAN_FROM_BUFFER(url_buf);
+  az_span_copy(url_span, hrb_url);
+  _az_http_request hrb;
+
+  TEST_EXPECT_SUCCESS(az_http_request_init(
+      &hrb,
+      &az_context_app,
+      az_http_method_get(),
+      url_span,
+      az_span_size(hrb_url),
+      AZ_SPAN_FROM_BUFFER(header_buf),
+      AZ_SPAN_NULL));
+
+  az_span value;
+  assert_int_equal(
+      az_http_request_get_header_by_name(&hrb, hrb_header_content_type_name, &value),
+      AZ_ERROR_ITEM_NOT_FOUND);
+
+  TEST_EXPECT_SUCCESS(az_http_request_append_header(
+      &hrb, hrb_header_content_type_name, hrb_header_content_type_token));
+  TEST_EXPECT_SUCCESS(az_http_request_set_header(
+      &hrb, hrb_header_authorization_name, hrb_header_authorization_token1));
+
+  // Names are looked up ignoring their casing
+  TEST_EXPECT_SUCCESS(
+      az_http_request_get_header_by_name(&hrb, AZ_SPAN_FROM_STR("content-TYPE"), &value));
+  assert_true(az_span_is_content_equal(value, hrb_header_content_type_token));
+
+  // Setting an existing header replaces its value
+  TEST_EXPECT_SUCCESS(az_http_request_set_header(
+      &hrb, AZ_SPAN_FROM_STR("AUTHORIZATION"), hrb_header_authorization_token2));
+  assert_int_equal(az_http_request_headers_count(&hrb), 2);
+  TEST_EXPECT_SUCCESS(
+      az_http_request_get_header_by_name(&hrb, hrb_header_authorization_name, &value));
+  assert_true(az_span_is_content_equal(value, hrb_header_authorization_token2));
+
+  // Fill the request past the indexed headers
+  az_span const names[] = {
+    AZ_SPAN_FROM_STR("h0"),  AZ_SPAN_FROM_STR("h1"),  AZ_SPAN_FROM_STR("h2"),
+    AZ_SPAN_FROM_STR("h3"),  AZ_SPAN_FROM_STR("h4"),  AZ_SPAN_FROM_STR("h5"),
+    AZ_SPAN_FROM_STR("h6"),  AZ_SPAN_FROM_STR("h7"),  AZ_SPAN_FROM_STR("h8"),
+    AZ_SPAN_FROM_STR("h9"),  AZ_SPAN_FROM_STR("h10"), AZ_SPAN_FROM_STR("h11"),
+    AZ_SPAN_FROM_STR("h12"), AZ_SPAN_FROM_STR("h13"), AZ_SPAN_FROM_STR("h14"),
+    AZ_SPAN_FROM_STR("h15"), AZ_SPAN_FROM_STR("h16"),
+  };
+  for (int32_t i = 0; i < (int32_t)_az_COUNTOF(names); ++i)
+  {
+    TEST_EXPECT_SUCCESS(az_http_request_append_header(&hrb, names[i], names[i]));
+  }
+  assert_int_equal(az_http_request_headers_count(&hrb), 19);
+
+  for (int32_t i = 0; i < (int32_t)_az_COUNTOF(names); ++i)
+  {
+    TEST_EXPECT_SUCCESS(az_http_request_get_header_by_name(&hrb, names[i], &value));
+    assert_true(az_span_is_content_equal(value, names[i]));
+  }
+
+  // Removing a header keeps the order of the others, and the index up to date
+  TEST_EXPECT_SUCCESS(az_http_request_remove_header(&hrb, hrb_header_content_type_name));
+  assert_int_equal(az_http_request_headers_count(&hrb), 18);
+  assert_int_equal(
+      az_http_request_get_header_by_name(&hrb, hrb_header_content_type_name, &value),
+      AZ_ERROR_ITEM_NOT_FOUND);
+  assert_int_equal(
+      az_http_request_remove_header(&hrb, hrb_header_content_type_name), AZ_ERROR_ITEM_NOT_FOUND);
+
+  az_pair header;
+  TEST_EXPECT_SUCCESS(az_http_request_get_header(&hrb, 0, &header));
+  assert_true(az_span_is_content_equal(header.key, hrb_header_authorization_name));
+  TEST_EXPECT_SUCCESS(az_http_request_get_header(&hrb, 17, &header));
+  assert_true(az_span_is_content_equal(header.key, AZ_SPAN_FROM_STR("h16")));
+
+  for (int32_t i = 0; i < (int32_t)_az_COUNTOF(names); ++i)
+  {
+    TEST_EXPECT_SUCCESS(az_http_request_get_header_by_name(&hrb, names[i], &value));
+    assert_true(az_span_is_content_equal(value, names[i]));
+  }
+
+  // Retry headers are removed from the index as well
+  hrb._internal.retry_headers_start_byte_offset = 2 * (int32_t)sizeof(az_pair);
+  TEST_EXPECT_SUCCESS(_az_http_request_remove_retry_headers(&hrb));
+  assert_int_equal(az_http_request_headers_count(&hrb), 2);
+  TEST_EXPECT_SUCCESS(az_http_request_get_header_by_name(&hrb, AZ_SPAN_FROM_STR("h0"), &value));
+  assert_int_equal(
+      az_http_request_get_header_by_name(&hrb, AZ_SPAN_FROM_STR("h1"), &value),
+      AZ_ERROR_ITEM_NOT_FOUND);
+}
+
 #define EXAMPLE_BODY \
   "{\r\n" \
   "  \"somejson\":45\r" \
@@ -325,6 +576,73 @@ static void test_http_response(void** state)
   }
 }
 
+static void test_http_response_indexed_when_written(void** state)
+{
+  (void)state;
+  uint8_t buffer[256] = { 0 };
+  az_http_response response;
+  TEST_EXPECT_SUCCESS(az_http_response_init(&response, AZ_SPAN_FROM_BUFFER(buffer)));
+
+  // Lines are split across writes, the way a transport may receive them
+  TEST_EXPECT_SUCCESS(az_http_response_write_span(&response, AZ_SPAN_FROM_STR("HTTP/1.1 503 Ser")));
+  TEST_EXPECT_SUCCESS(az_http_response_write_span(
+      &response, AZ_SPAN_FROM_STR("vice Unavailable\r\nContent-Type: text/plain\r")));
+  TEST_EXPECT_SUCCESS(az_http_response_write_span(
+      &response, AZ_SPAN_FROM_STR("\nRetry-After:\t 10 \r\n\r\nbody\r\nMore: data\r\n")));
+  assert_int_equal(response._internal.index.headers_count, 2);
+
+  az_span value;
+  TEST_EXPECT_SUCCESS(
+      az_http_response_get_header_by_name(&response, AZ_SPAN_FROM_STR("retry-after"), &value));
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("10")));
+  assert_int_equal(
+      az_http_response_get_header_by_name(&response, AZ_SPAN_FROM_STR("More"), &value),
+      AZ_ERROR_ITEM_NOT_FOUND);
+
+  az_http_response_status_line status_line = { 0 };
+  TEST_EXPECT_SUCCESS(az_http_response_get_status_line(&response, &status_line));
+  assert_int_equal(status_line.status_code, AZ_HTTP_STATUS_CODE_SERVICE_UNAVAILABLE);
+
+  az_pair header;
+  TEST_EXPECT_SUCCESS(az_http_response_get_next_header(&response, &header));
+  assert_true(az_span_is_content_equal(header.key, AZ_SPAN_FROM_STR("Content-Type")));
+  assert_true(az_span_is_content_equal(header.value, AZ_SPAN_FROM_STR("text/plain")));
+  TEST_EXPECT_SUCCESS(az_http_response_get_next_header(&response, &header));
+  assert_true(az_span_is_content_equal(header.key, AZ_SPAN_FROM_STR("Retry-After")));
+  assert_int_equal(az_http_response_get_next_header(&response, &header), AZ_ERROR_ITEM_NOT_FOUND);
+
+  az_span body;
+  TEST_EXPECT_SUCCESS(az_http_response_get_body(&response, &body));
+  assert_string_equal((char const*)az_span_ptr(body), "body\r\nMore: data\r\n");
+}
+
+static void test_http_response_header_by_name_not_indexed(void** state)
+{
+  (void)state;
+  az_http_response response;
+  TEST_EXPECT_SUCCESS(az_http_response_init(
+      &response,
+      AZ_SPAN_FROM_STR("HTTP/1.1 200 OK\r\n"
+                       "Content-Type: text/plain\r\n"
+                       "x-ms-request-id: 42\r\n"
+                       "\r\n"
+                       "body")));
+
+  // Responses that did not go through the transport are parsed instead
+  az_span value;
+  TEST_EXPECT_SUCCESS(
+      az_http_response_get_header_by_name(&response, AZ_SPAN_FROM_STR("X-MS-Request-Id"), &value));
+  assert_true(az_span_is_content_equal(value, AZ_SPAN_FROM_STR("42")));
+  assert_int_equal(
+      az_http_response_get_header_by_name(&response, AZ_SPAN_FROM_STR("Retry-After"), &value),
+      AZ_ERROR_ITEM_NOT_FOUND);
+
+  // The parser of the response is left as it is
+  az_pair header;
+  assert_int_equal(
+      az_http_response_get_next_header(&response, &header), AZ_ERROR_HTTP_INVALID_STATE);
+}
+
 #ifndef AZ_NO_PRECONDITION_CHECKING
 enable_precondition_check_tests()
 
@@ -370,7 +688,13 @@ int test_az_http()
     cmocka_unit_test(test_http_request_removing_left_white_spaces),
 #endif // AZ_NO_PRECONDITION_CHECKING
     cmocka_unit_test(test_http_request),
+    cmocka_unit_test(test_http_request_body_list),
+    cmocka_unit_test(test_http_request_append_path_with_query),
+    cmocka_unit_test(test_http_request_init_from_template),
+    cmocka_unit_test(test_http_request_header_by_name),
     cmocka_unit_test(test_http_response),
+    cmocka_unit_test(test_http_response_indexed_when_written),
+    cmocka_unit_test(test_http_response_header_by_name_not_indexed),
   };
   return cmocka_run_group_tests_name("az_core_http", tests, NULL, NULL);
 }
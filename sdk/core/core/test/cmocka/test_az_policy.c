@@ -7,6 +7,7 @@
 #include <az_http.h>
 #include <az_http_internal.h>
 #include <az_http_transport.h>
+#include <az_log.h>
 #include <az_span.h>
 
 #include <setjmp.h>
@@ -38,6 +39,13 @@ void test_az_http_pipeline_policy_credential(void** state);
 void test_az_http_pipeline_policy_retry(void** state);
 void test_az_http_pipeline_policy_retry_with_header(void** state);
 void test_az_http_pipeline_policy_retry_with_header_2(void** state);
+void test_az_http_pipeline_policy_retry_deadline(void** state);
+void test_az_http_pipeline_policy_retry_jitter(void** state);
+void test_az_http_pipeline_policy_retry_budget(void** state);
+void test_az_http_pipeline_policy_retry_last_response(void** state);
+void test_az_http_pipeline_policy_circuit_breaker(void** state);
+void test_az_http_pipeline_policy_rate_limiter(void** state);
+void test_az_http_pipeline_policy_concurrency_limiter(void** state);
 #endif // _az_MOCK_ENABLED
 
 static az_result test_policy_transport(
@@ -48,6 +56,7 @@ static az_result test_policy_transport(
 
 void test_az_http_pipeline_policy_apiversion(void** state);
 void test_az_http_pipeline_policy_telemetry(void** state);
+void test_az_http_pipeline_policy_compression(void** state);
 
 az_result test_policy_transport(
     _az_http_policy* p_policies,
@@ -139,6 +148,178 @@ void test_az_http_pipeline_policy_apiversion(void** state)
   assert_return_code(az_http_pipeline_policy_apiversion(policies, &api_version, &hrb, NULL), AZ_OK);
 }
 
+// Run-length encodes the body as (count, byte) pairs, which is enough to tell a compressed body
+// from the original one.
+static az_result test_compress_rle(
+    void* context,
+    _az_http_request const* p_request,
+    az_span destination,
+    az_span* out_compressed)
+{
+  (void)context;
+  uint8_t* const out = az_span_ptr(destination);
+  int32_t written = 0;
+  for (int32_t i = 0; i < az_http_request_body_spans_count(p_request); ++i)
+  {
+    az_span span = { 0 };
+    assert_return_code(az_http_request_get_body_span(p_request, i, &span), AZ_OK);
+    for (int32_t j = 0; j < az_span_size(span); ++j)
+    {
+      uint8_t const c = az_span_ptr(span)[j];
+      if (written > 0 && out[written - 1] == c && out[written - 2] < UINT8_MAX)
+      {
+        ++out[written - 2];
+        continue;
+      }
+      if (written + 2 > az_span_size(destination))
+      {
+        return AZ_ERROR_INSUFFICIENT_SPAN_SIZE;
+      }
+      out[written++] = 1;
+      out[written++] = c;
+    }
+  }
+  *out_compressed = az_span_init(out, written);
+  return AZ_OK;
+}
+
+typedef struct
+{
+  az_span body;
+  az_span content_encoding;
+} test_sent_request;
+
+static az_result test_policy_transport_capture(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response)
+{
+  (void)p_policies;
+  (void)p_response;
+  test_sent_request* const sent = (test_sent_request*)p_options;
+  assert_return_code(az_http_request_get_body(p_request, &sent->body), AZ_OK);
+  if (az_http_request_get_header_by_name(
+          p_request, AZ_SPAN_FROM_STR("content-encoding"), &sent->content_encoding)
+      != AZ_OK)
+  {
+    sent->content_encoding = AZ_SPAN_NULL;
+  }
+  return AZ_OK;
+}
+
+void test_az_http_pipeline_policy_compression(void** state)
+{
+  (void)state;
+
+  uint8_t buf[100];
+  uint8_t header_buf[(2 * sizeof(az_pair))];
+  az_span url_span = AZ_SPAN_FROM_BUFFER(buf);
+  az_span_copy(url_span, AZ_SPAN_FROM_STR("url"));
+
+  uint8_t scratch_buf[64];
+  az_span_arena scratch;
+  assert_return_code(az_span_arena_init(&scratch, AZ_SPAN_FROM_BUFFER(scratch_buf)), AZ_OK);
+
+  _az_http_policy_compression_options options;
+  assert_return_code(
+      _az_http_policy_compression_options_init(
+          &options, test_compress_rle, NULL, AZ_SPAN_FROM_STR("rle"), 8, &scratch),
+      AZ_OK);
+
+  test_sent_request sent = { 0 };
+  _az_http_policy policies[1] = {
+    { ._internal = { .process = test_policy_transport_capture, .p_options = &sent } },
+  };
+
+  // A compressible body made of two spans is sent compressed and restored afterwards.
+  {
+    az_span spans[2];
+    az_span_list body;
+    assert_return_code(az_span_list_init(&body, spans, 2), AZ_OK);
+    assert_return_code(az_span_list_append(&body, AZ_SPAN_FROM_STR("aaaaaaaa")), AZ_OK);
+    assert_return_code(az_span_list_append(&body, AZ_SPAN_FROM_STR("aaaabbbb")), AZ_OK);
+
+    _az_http_request request;
+    assert_return_code(
+        az_http_request_init(
+            &request,
+            &az_context_app,
+            az_http_method_post(),
+            url_span,
+            3,
+            AZ_SPAN_FROM_BUFFER(header_buf),
+            AZ_SPAN_NULL),
+        AZ_OK);
+    assert_return_code(az_http_request_set_body_list(&request, &body, AZ_SPAN_NULL), AZ_OK);
+
+    assert_return_code(
+        az_http_pipeline_policy_compression(policies, &options, &request, NULL), AZ_OK);
+
+    uint8_t expected[] = { 12, 'a', 4, 'b' };
+    assert_true(az_span_is_content_equal(sent.body, AZ_SPAN_FROM_BUFFER(expected)));
+    assert_true(az_span_is_content_equal(sent.content_encoding, AZ_SPAN_FROM_STR("rle")));
+
+    assert_int_equal(az_http_request_body_spans_count(&request), 2);
+    assert_int_equal(az_http_request_headers_count(&request), 0);
+    assert_int_equal(az_span_arena_mark(&scratch), 0);
+  }
+
+  // A body smaller than the threshold, or that does not get smaller, is sent as is.
+  az_span const bodies[2] = { AZ_SPAN_FROM_STR("aaaa"), AZ_SPAN_FROM_STR("abcdefgh") };
+  for (int32_t i = 0; i < 2; ++i)
+  {
+    _az_http_request request;
+    assert_return_code(
+        az_http_request_init(
+            &request,
+            &az_context_app,
+            az_http_method_post(),
+            url_span,
+            3,
+            AZ_SPAN_FROM_BUFFER(header_buf),
+            bodies[i]),
+        AZ_OK);
+
+    assert_return_code(
+        az_http_pipeline_policy_compression(policies, &options, &request, NULL), AZ_OK);
+
+    assert_true(az_span_is_content_equal(sent.body, bodies[i]));
+    assert_int_equal(az_span_size(sent.content_encoding), 0);
+    assert_int_equal(az_span_arena_mark(&scratch), 0);
+  }
+
+  // So is a body when the arena is too full to even align an allocation.
+  {
+    uint64_t full_buf[8];
+    az_span_arena full;
+    az_span const full_span = az_span_init((uint8_t*)full_buf, (int32_t)sizeof(full_buf) - 4);
+    assert_return_code(az_span_arena_init(&full, full_span), AZ_OK);
+    az_span used = { 0 };
+    assert_return_code(az_span_arena_alloc(&full, (int32_t)sizeof(full_buf) - 7, &used), AZ_OK);
+    options._internal.scratch = &full;
+
+    _az_http_request request;
+    assert_return_code(
+        az_http_request_init(
+            &request,
+            &az_context_app,
+            az_http_method_post(),
+            url_span,
+            3,
+            AZ_SPAN_FROM_BUFFER(header_buf),
+            AZ_SPAN_FROM_STR("aaaaaaaa")),
+        AZ_OK);
+
+    assert_return_code(
+        az_http_pipeline_policy_compression(policies, &options, &request, NULL), AZ_OK);
+
+    assert_true(az_span_is_content_equal(sent.body, AZ_SPAN_FROM_STR("aaaaaaaa")));
+    assert_int_equal(az_span_size(sent.content_encoding), 0);
+    assert_int_equal(az_span_arena_mark(&full), sizeof(full_buf) - 7);
+  }
+}
+
 #ifdef _az_MOCK_ENABLED
 
 const az_span retry_response = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 408 Request Timeout\r\n"
@@ -148,6 +329,10 @@ const az_span retry_response = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 408 Request Ti
                                                         "  \"body\":0,\r"
                                                         "}\n");
 
+const az_span success_response = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 200 OK\r\n"
+                                                          "Content-Length: 0\r\n"
+                                                          "\r\n");
+
 const az_span retry_response_with_header
     = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 408 Request Timeout\r\n"
                                "Content-Type: text/html; charset=UTF-8\r\n"
@@ -326,6 +511,766 @@ void test_az_http_pipeline_policy_retry_with_header_2(void** state)
       az_http_pipeline_policy_retry(policies, &retry_options, &hrb, &response), AZ_OK);
 }
 
+static az_result test_policy_transport_retry_response_counted(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response)
+{
+  (void)p_policies;
+  (void)p_request;
+  ++*(int*)p_options;
+  assert_return_code(az_http_response_init(p_response, retry_response_with_header), AZ_OK);
+  return AZ_OK;
+}
+
+void test_az_http_pipeline_policy_retry_deadline(void** state)
+{
+  (void)state;
+
+  uint8_t buf[100];
+  uint8_t header_buf[(2 * sizeof(az_pair))];
+  az_span url_span = AZ_SPAN_FROM_BUFFER(buf);
+  az_span_copy(url_span, AZ_SPAN_FROM_STR("url"));
+
+  az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
+
+  int attempts = 0;
+  _az_http_policy policies[1] = {
+    {
+      ._internal = {
+        .process = test_policy_transport_retry_response_counted,
+        .p_options = &attempts,
+      },
+    },
+  };
+
+  // The response asks to retry in 1600ms, past the deadline: the response is returned as is.
+  {
+    az_context context = az_context_with_expiration(&az_context_app, 1000);
+    _az_http_request request;
+    assert_return_code(
+        az_http_request_init(
+            &request,
+            &context,
+            az_http_method_get(),
+            url_span,
+            3,
+            AZ_SPAN_FROM_BUFFER(header_buf),
+            AZ_SPAN_NULL),
+        AZ_OK);
+
+    will_return(__wrap_az_platform_clock_msec, 0);
+
+    az_http_response response;
+    assert_return_code(
+        az_http_pipeline_policy_retry(policies, &retry_options, &request, &response), AZ_OK);
+    assert_int_equal(attempts, 1);
+
+    az_http_response_status_line status_line = { 0 };
+    assert_return_code(az_http_response_get_status_line(&response, &status_line), AZ_OK);
+    assert_int_equal(status_line.status_code, AZ_HTTP_STATUS_CODE_REQUEST_TIMEOUT);
+  }
+
+  // The deadline passed during the first attempt.
+  {
+    attempts = 0;
+    az_context context = az_context_with_expiration(&az_context_app, 1000);
+    _az_http_request request;
+    assert_return_code(
+        az_http_request_init(
+            &request,
+            &context,
+            az_http_method_get(),
+            url_span,
+            3,
+            AZ_SPAN_FROM_BUFFER(header_buf),
+            AZ_SPAN_NULL),
+        AZ_OK);
+
+    will_return(__wrap_az_platform_clock_msec, 1001);
+
+    az_http_response response;
+    assert_int_equal(
+        az_http_pipeline_policy_retry(policies, &retry_options, &request, &response),
+        AZ_ERROR_CANCELED);
+    assert_int_equal(attempts, 1);
+  }
+}
+
+typedef struct
+{
+  int attempts;
+  az_span response;
+} test_retry_transport;
+
+static az_result test_policy_transport_retry_scripted(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response)
+{
+  (void)p_policies;
+  (void)p_request;
+  test_retry_transport* const transport = (test_retry_transport*)p_options;
+  ++transport->attempts;
+  assert_return_code(az_http_response_init(p_response, transport->response), AZ_OK);
+  return AZ_OK;
+}
+
+static uint32_t test_retry_random() { return 1000; }
+
+static uint8_t test_retry_log_buf[100];
+static az_span test_retry_log = { 0 };
+
+static void test_retry_log_listener(az_log_classification classification, az_span message)
+{
+  if (classification == AZ_LOG_HTTP_RETRY
+      && az_span_find(message, AZ_SPAN_FROM_STR("will be made")) >= 0)
+  {
+    az_span const buffer = AZ_SPAN_FROM_BUFFER(test_retry_log_buf);
+    test_retry_log = az_span_slice(
+        buffer, 0, az_span_size(buffer) - az_span_size(az_span_copy(buffer, message)));
+  }
+}
+
+static az_result test_retry_send(
+    az_http_policy_retry_options* retry_options,
+    test_retry_transport* transport)
+{
+  uint8_t buf[100];
+  uint8_t header_buf[(2 * sizeof(az_pair))];
+  az_span url_span = AZ_SPAN_FROM_BUFFER(buf);
+  az_span_copy(url_span, AZ_SPAN_FROM_STR("url"));
+
+  _az_http_request request;
+  assert_return_code(
+      az_http_request_init(
+          &request,
+          &az_context_app,
+          az_http_method_get(),
+          url_span,
+          3,
+          AZ_SPAN_FROM_BUFFER(header_buf),
+          AZ_SPAN_NULL),
+      AZ_OK);
+
+  _az_http_policy policies[1] = {
+    {
+      ._internal = {
+        .process = test_policy_transport_retry_scripted,
+        .p_options = transport,
+      },
+    },
+  };
+
+  az_http_response response;
+  return az_http_pipeline_policy_retry(policies, retry_options, &request, &response);
+}
+
+void test_az_http_pipeline_policy_retry_jitter(void** state)
+{
+  (void)state;
+
+  _az_http_policy_retry_set_random_callback(test_retry_random);
+  az_log_set_callback(test_retry_log_listener);
+
+  az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
+  retry_options.max_retries = 1;
+  retry_options.retry_delay_msec = 100;
+  retry_options.max_retry_delay_msec = 10000;
+
+  // Full: 1000 % (1 + the exponential delay of the first retry, 400ms).
+  {
+    retry_options.jitter = AZ_HTTP_POLICY_RETRY_JITTER_FULL;
+    test_retry_transport transport = { .attempts = 0, .response = retry_response };
+    will_return(__wrap_az_platform_clock_msec, 0);
+    assert_return_code(test_retry_send(&retry_options, &transport), AZ_OK);
+    assert_int_equal(transport.attempts, 2);
+    assert_true(az_span_is_content_equal(
+        test_retry_log, AZ_SPAN_FROM_STR("HTTP Retry attempt #2 will be made in 198ms.")));
+  }
+
+  // Decorrelated: 100ms + 1000 % (1 + three times the previous delay of 100ms, minus 100ms).
+  {
+    retry_options.jitter = AZ_HTTP_POLICY_RETRY_JITTER_DECORRELATED;
+    test_retry_transport transport = { .attempts = 0, .response = retry_response };
+    will_return(__wrap_az_platform_clock_msec, 0);
+    assert_return_code(test_retry_send(&retry_options, &transport), AZ_OK);
+    assert_int_equal(transport.attempts, 2);
+    assert_true(az_span_is_content_equal(
+        test_retry_log, AZ_SPAN_FROM_STR("HTTP Retry attempt #2 will be made in 296ms.")));
+  }
+
+  // A retry-after header is followed as is.
+  {
+    test_retry_transport transport = { .attempts = 0, .response = retry_response_with_header };
+    will_return(__wrap_az_platform_clock_msec, 0);
+    assert_return_code(test_retry_send(&retry_options, &transport), AZ_OK);
+    assert_true(az_span_is_content_equal(
+        test_retry_log, AZ_SPAN_FROM_STR("HTTP Retry attempt #2 will be made in 1600ms.")));
+  }
+
+  az_log_set_callback(NULL);
+  _az_http_policy_retry_set_random_callback(NULL);
+}
+
+void test_az_http_pipeline_policy_retry_budget(void** state)
+{
+  (void)state;
+
+  az_http_policy_retry_budget budget;
+  assert_return_code(az_http_policy_retry_budget_init(&budget, 50, 1), AZ_OK);
+
+  az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
+  retry_options.budget = &budget;
+
+  // The budget starts with one retry.
+  test_retry_transport transport = { .attempts = 0, .response = retry_response };
+  retry_options.max_retries = 4;
+  will_return_count(__wrap_az_platform_clock_msec, 0, 2);
+  assert_return_code(test_retry_send(&retry_options, &transport), AZ_OK);
+  assert_int_equal(transport.attempts, 2);
+
+  // Each request that succeeds is worth half a retry.
+  transport = (test_retry_transport){ .attempts = 0, .response = success_response };
+  assert_return_code(test_retry_send(&retry_options, &transport), AZ_OK);
+  assert_return_code(test_retry_send(&retry_options, &transport), AZ_OK);
+  assert_int_equal(transport.attempts, 2);
+
+  transport = (test_retry_transport){ .attempts = 0, .response = retry_response };
+  will_return_count(__wrap_az_platform_clock_msec, 0, 2);
+  assert_return_code(test_retry_send(&retry_options, &transport), AZ_OK);
+  assert_int_equal(transport.attempts, 2);
+}
+
+void test_az_http_pipeline_policy_retry_last_response(void** state)
+{
+  (void)state;
+
+  az_http_policy_retry_options retry_options = _az_http_policy_retry_options_default();
+  retry_options.max_retries = 0;
+
+  // The last response is returned without being parsed, even when it can't be.
+  test_retry_transport transport
+      = { .attempts = 0, .response = AZ_SPAN_FROM_STR("HTTP/1.1 503\r\n\r\n") };
+  assert_return_code(test_retry_send(&retry_options, &transport), AZ_OK);
+  assert_int_equal(transport.attempts, 1);
+}
+
+static uint8_t test_circuit_log_buf[100];
+static az_span test_circuit_log = { 0 };
+
+static void test_circuit_log_listener(az_log_classification classification, az_span message)
+{
+  if (classification == AZ_LOG_HTTP_CIRCUIT_BREAKER)
+  {
+    az_span const buffer = AZ_SPAN_FROM_BUFFER(test_circuit_log_buf);
+    test_circuit_log = az_span_slice(
+        buffer, 0, az_span_size(buffer) - az_span_size(az_span_copy(buffer, message)));
+  }
+}
+
+static az_span const test_endpoint_url
+    = AZ_SPAN_LITERAL_FROM_STR("https://account.blob.core.windows.net/container?comp=list");
+
+// Sends a request to the given URL through the given policy, followed by the given transport.
+static az_result test_endpoint_send_through(
+    az_span url,
+    _az_http_policy_process_fn policy,
+    void* options,
+    az_context* context,
+    _az_http_policy_process_fn transport_process,
+    void* transport_options)
+{
+  uint8_t buf[100];
+  uint8_t header_buf[(2 * sizeof(az_pair))];
+  az_span url_span = AZ_SPAN_FROM_BUFFER(buf);
+  az_span_copy(url_span, url);
+
+  _az_http_request request;
+  assert_return_code(
+      az_http_request_init(
+          &request,
+          context,
+          az_http_method_get(),
+          url_span,
+          az_span_size(url),
+          AZ_SPAN_FROM_BUFFER(header_buf),
+          AZ_SPAN_NULL),
+      AZ_OK);
+
+  _az_http_policy policies[1] = {
+    {
+      ._internal = {
+        .process = transport_process,
+        .p_options = transport_options,
+      },
+    },
+  };
+
+  az_http_response response;
+  return policy(policies, options, &request, &response);
+}
+
+// Sends a request to the given URL through the given policy.
+static az_result test_endpoint_send_to(
+    az_span url,
+    _az_http_policy_process_fn policy,
+    void* options,
+    az_context* context,
+    test_retry_transport* transport)
+{
+  return test_endpoint_send_through(
+      url, policy, options, context, test_policy_transport_retry_scripted, transport);
+}
+
+// Sends a request to a fixed endpoint through the given policy.
+static az_result test_endpoint_send(
+    _az_http_policy_process_fn policy,
+    void* options,
+    az_context* context,
+    test_retry_transport* transport)
+{
+  return test_endpoint_send_to(test_endpoint_url, policy, options, context, transport);
+}
+
+// Counts the attempts, and fails them as if their caller gave up.
+static az_result test_policy_transport_canceled(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response)
+{
+  (void)p_policies;
+  (void)p_request;
+  (void)p_response;
+  ++*(int*)p_options;
+  return AZ_ERROR_CANCELED;
+}
+
+static az_result test_circuit_send(
+    _az_http_policy_circuit_breaker_options* options,
+    test_retry_transport* transport)
+{
+  return test_endpoint_send(
+      az_http_pipeline_policy_circuit_breaker, options, &az_context_app, transport);
+}
+
+void test_az_http_pipeline_policy_circuit_breaker(void** state)
+{
+  (void)state;
+
+  az_log_set_callback(test_circuit_log_listener);
+
+  _az_http_policy_circuit_breaker_options options;
+  assert_return_code(
+      _az_http_policy_circuit_breaker_options_init(&options, NULL, 4, 3, 50, 1000), AZ_OK);
+
+  test_retry_transport failing = { .attempts = 0, .response = retry_response };
+  test_retry_transport healthy = { .attempts = 0, .response = success_response };
+
+  // 2 failures out of 3 requests open the circuit.
+  assert_return_code(test_circuit_send(&options, &failing), AZ_OK);
+  assert_return_code(test_circuit_send(&options, &healthy), AZ_OK);
+  will_return(__wrap_az_platform_clock_msec, 0);
+  assert_return_code(test_circuit_send(&options, &failing), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_circuit_log,
+      AZ_SPAN_FROM_STR("HTTP circuit for account.blob.core.windows.net opened.")));
+
+  // While open, requests fail without being sent.
+  will_return(__wrap_az_platform_clock_msec, 999);
+  assert_int_equal(test_circuit_send(&options, &healthy), AZ_ERROR_HTTP_CIRCUIT_OPEN);
+  assert_int_equal(healthy.attempts, 1);
+
+  // A failed probe opens it again.
+  will_return_count(__wrap_az_platform_clock_msec, 1000, 2);
+  assert_return_code(test_circuit_send(&options, &failing), AZ_OK);
+  assert_int_equal(failing.attempts, 3);
+  assert_true(az_span_is_content_equal(
+      test_circuit_log,
+      AZ_SPAN_FROM_STR("HTTP circuit for account.blob.core.windows.net opened again.")));
+
+  will_return(__wrap_az_platform_clock_msec, 1500);
+  assert_int_equal(test_circuit_send(&options, &failing), AZ_ERROR_HTTP_CIRCUIT_OPEN);
+
+  // A probe its caller gave up on says nothing about the endpoint: the next request probes again.
+  int canceled_attempts = 0;
+  will_return(__wrap_az_platform_clock_msec, 2000);
+  assert_int_equal(
+      test_endpoint_send_through(
+          test_endpoint_url,
+          az_http_pipeline_policy_circuit_breaker,
+          &options,
+          &az_context_app,
+          test_policy_transport_canceled,
+          &canceled_attempts),
+      AZ_ERROR_CANCELED);
+  assert_int_equal(canceled_attempts, 1);
+  assert_true(az_span_is_content_equal(
+      test_circuit_log,
+      AZ_SPAN_FROM_STR("HTTP circuit for account.blob.core.windows.net is half-open.")));
+
+  // A successful one closes it, and the failures before are forgotten.
+  assert_return_code(test_circuit_send(&options, &healthy), AZ_OK);
+  assert_int_equal(healthy.attempts, 2);
+  assert_true(az_span_is_content_equal(
+      test_circuit_log,
+      AZ_SPAN_FROM_STR("HTTP circuit for account.blob.core.windows.net closed.")));
+
+  assert_return_code(test_circuit_send(&options, &failing), AZ_OK);
+  assert_return_code(test_circuit_send(&options, &failing), AZ_OK);
+  assert_int_equal(failing.attempts, 5);
+
+  // An open circuit keeps its slot while more endpoints than there are slots come and go: the last
+  // one hashes to its slot once the others are taken.
+  will_return(__wrap_az_platform_clock_msec, 3000);
+  assert_return_code(test_circuit_send(&options, &failing), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_circuit_log,
+      AZ_SPAN_FROM_STR("HTTP circuit for account.blob.core.windows.net opened.")));
+
+  az_span const other_urls[] = {
+    AZ_SPAN_FROM_STR("https://c.example.com/"), AZ_SPAN_FROM_STR("https://b.example.com/"),
+    AZ_SPAN_FROM_STR("https://e.example.com/"), AZ_SPAN_FROM_STR("https://d.example.com/"),
+  };
+  for (size_t i = 0; i < _az_COUNTOF(other_urls); ++i)
+  {
+    assert_return_code(
+        test_endpoint_send_to(
+            other_urls[i], az_http_pipeline_policy_circuit_breaker, &options, NULL, &healthy),
+        AZ_OK);
+  }
+  assert_int_equal(healthy.attempts, 6);
+
+  will_return(__wrap_az_platform_clock_msec, 3000);
+  assert_int_equal(test_circuit_send(&options, &healthy), AZ_ERROR_HTTP_CIRCUIT_OPEN);
+
+  az_log_set_callback(NULL);
+}
+
+static uint8_t test_rate_limiter_log_buf[100];
+static az_span test_rate_limiter_log = { 0 };
+
+static void test_rate_limiter_log_listener(az_log_classification classification, az_span message)
+{
+  if (classification == AZ_LOG_HTTP_RATE_LIMITER
+      && az_span_find(message, AZ_SPAN_FROM_STR(" held ")) < 0)
+  {
+    az_span const buffer = AZ_SPAN_FROM_BUFFER(test_rate_limiter_log_buf);
+    test_rate_limiter_log = az_span_slice(
+        buffer, 0, az_span_size(buffer) - az_span_size(az_span_copy(buffer, message)));
+  }
+}
+
+static _az_http_policy_rate_limiter_options* test_rate_limiter_options = NULL;
+
+static az_span const test_rate_limiter_other_urls[] = {
+  AZ_SPAN_LITERAL_FROM_STR("https://c.example.com/"),
+  AZ_SPAN_LITERAL_FROM_STR("https://b.example.com/"),
+  AZ_SPAN_LITERAL_FROM_STR("https://e.example.com/"),
+  AZ_SPAN_LITERAL_FROM_STR("https://d.example.com/"),
+};
+
+// Sends requests to other endpoints while the first one is out, which take every slot.
+static az_result test_policy_transport_rate_limiter_nested(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response)
+{
+  test_retry_transport nested = { .attempts = 0, .response = success_response };
+  for (size_t i = 0; i < _az_COUNTOF(test_rate_limiter_other_urls); ++i)
+  {
+    assert_return_code(
+        test_endpoint_send_to(
+            test_rate_limiter_other_urls[i],
+            az_http_pipeline_policy_rate_limiter,
+            test_rate_limiter_options,
+            NULL,
+            &nested),
+        AZ_OK);
+  }
+  assert_int_equal(nested.attempts, _az_COUNTOF(test_rate_limiter_other_urls));
+
+  return test_policy_transport_retry_scripted(p_policies, p_options, p_request, p_response);
+}
+
+static az_result test_rate_limiter_send(
+    _az_http_policy_rate_limiter_options* options,
+    az_context* context,
+    test_retry_transport* transport)
+{
+  test_rate_limiter_log = AZ_SPAN_NULL;
+  return test_endpoint_send(az_http_pipeline_policy_rate_limiter, options, context, transport);
+}
+
+void test_az_http_pipeline_policy_rate_limiter(void** state)
+{
+  (void)state;
+
+  az_log_set_callback(test_rate_limiter_log_listener);
+
+  // A request every 100ms, 2 at once.
+  _az_http_policy_rate_limiter_options options;
+  assert_return_code(_az_http_policy_rate_limiter_options_init(&options, NULL, 10, 2), AZ_OK);
+
+  test_retry_transport healthy = { .attempts = 0, .response = success_response };
+  test_retry_transport throttled = {
+    .attempts = 0,
+    .response = AZ_SPAN_LITERAL_FROM_STR("HTTP/1.1 429 Too Many Requests\r\n"
+                                         "retry-after-ms: 500\r\n"
+                                         "\r\n"),
+  };
+
+  // The burst goes out right away, and the next request waits for a token.
+  will_return_count(__wrap_az_platform_clock_msec, 0, 3);
+  assert_return_code(test_rate_limiter_send(&options, &az_context_app, &healthy), AZ_OK);
+  assert_return_code(test_rate_limiter_send(&options, &az_context_app, &healthy), AZ_OK);
+  assert_true(az_span_is_content_equal(test_rate_limiter_log, AZ_SPAN_NULL));
+  assert_return_code(test_rate_limiter_send(&options, &az_context_app, &healthy), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_rate_limiter_log,
+      AZ_SPAN_FROM_STR("HTTP rate limiter for account.blob.core.windows.net holds a request for "
+                       "100ms.")));
+  assert_int_equal(healthy.attempts, 3);
+
+  // A throttled request holds back every other one until the endpoint is back.
+  will_return_count(__wrap_az_platform_clock_msec, 1000, 2);
+  assert_return_code(test_rate_limiter_send(&options, &az_context_app, &throttled), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_rate_limiter_log,
+      AZ_SPAN_FROM_STR("HTTP rate limiter for account.blob.core.windows.net paused for 500ms.")));
+
+  will_return(__wrap_az_platform_clock_msec, 1000);
+  assert_return_code(test_rate_limiter_send(&options, &az_context_app, &healthy), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_rate_limiter_log,
+      AZ_SPAN_FROM_STR("HTTP rate limiter for account.blob.core.windows.net holds a request for "
+                       "500ms.")));
+
+  // Then requests resume at the configured rate, without a burst.
+  will_return(__wrap_az_platform_clock_msec, 1500);
+  assert_return_code(test_rate_limiter_send(&options, &az_context_app, &healthy), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_rate_limiter_log,
+      AZ_SPAN_FROM_STR("HTTP rate limiter for account.blob.core.windows.net holds a request for "
+                       "100ms.")));
+  assert_int_equal(healthy.attempts, 5);
+
+  // A request that would only be sent after its deadline isn't sent at all.
+  az_context context = az_context_with_expiration(&az_context_app, 1550);
+  will_return(__wrap_az_platform_clock_msec, 1500);
+  assert_int_equal(test_rate_limiter_send(&options, &context, &healthy), AZ_ERROR_CANCELED);
+  assert_int_equal(healthy.attempts, 5);
+
+  // A paused endpoint keeps its slot while more endpoints than there are slots come and go: the
+  // last one hashes to the paused endpoint's slot once the others are taken.
+  assert_return_code(_az_http_policy_rate_limiter_options_init(&options, NULL, 10, 2), AZ_OK);
+  will_return_count(__wrap_az_platform_clock_msec, 0, 2);
+  assert_return_code(test_rate_limiter_send(&options, &az_context_app, &throttled), AZ_OK);
+
+  will_return_count(__wrap_az_platform_clock_msec, 0, _az_COUNTOF(test_rate_limiter_other_urls));
+  for (size_t i = 0; i < _az_COUNTOF(test_rate_limiter_other_urls); ++i)
+  {
+    assert_return_code(
+        test_endpoint_send_to(
+            test_rate_limiter_other_urls[i],
+            az_http_pipeline_policy_rate_limiter,
+            &options,
+            NULL,
+            &healthy),
+        AZ_OK);
+  }
+  assert_int_equal(healthy.attempts, 9);
+
+  will_return(__wrap_az_platform_clock_msec, 0);
+  assert_return_code(test_rate_limiter_send(&options, &az_context_app, &healthy), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_rate_limiter_log,
+      AZ_SPAN_FROM_STR("HTTP rate limiter for account.blob.core.windows.net holds a request for "
+                       "500ms.")));
+
+  // The endpoint gives its slot away while its request is out, once its bucket is full again. The
+  // pause it then asks for is still its own: it takes a slot back rather than pausing the endpoint
+  // that took its slot (the last one, which hashes to it).
+  assert_return_code(_az_http_policy_rate_limiter_options_init(&options, NULL, 10, 2), AZ_OK);
+  test_rate_limiter_options = &options;
+  will_return(__wrap_az_platform_clock_msec, 0); // Request sent
+  will_return_count(__wrap_az_platform_clock_msec, 200, _az_COUNTOF(test_rate_limiter_other_urls));
+  will_return(__wrap_az_platform_clock_msec, 300); // Request throttled
+  assert_return_code(
+      test_endpoint_send_through(
+          test_endpoint_url,
+          az_http_pipeline_policy_rate_limiter,
+          &options,
+          &az_context_app,
+          test_policy_transport_rate_limiter_nested,
+          &throttled),
+      AZ_OK);
+  assert_int_equal(throttled.attempts, 3);
+
+  will_return(__wrap_az_platform_clock_msec, 300);
+  assert_return_code(test_rate_limiter_send(&options, &az_context_app, &healthy), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_rate_limiter_log,
+      AZ_SPAN_FROM_STR("HTTP rate limiter for account.blob.core.windows.net holds a request for "
+                       "500ms.")));
+
+  will_return(__wrap_az_platform_clock_msec, 300);
+  test_rate_limiter_log = AZ_SPAN_NULL;
+  assert_return_code(
+      test_endpoint_send_to(
+          test_rate_limiter_other_urls[3],
+          az_http_pipeline_policy_rate_limiter,
+          &options,
+          NULL,
+          &healthy),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(test_rate_limiter_log, AZ_SPAN_NULL));
+  assert_int_equal(healthy.attempts, 12);
+
+  test_rate_limiter_options = NULL;
+  az_log_set_callback(NULL);
+}
+
+static uint8_t test_concurrency_log_buf[100];
+static az_span test_concurrency_log = { 0 };
+
+static void test_concurrency_log_listener(az_log_classification classification, az_span message)
+{
+  if (classification == AZ_LOG_HTTP_CONCURRENCY_LIMITER)
+  {
+    az_span const buffer = AZ_SPAN_FROM_BUFFER(test_concurrency_log_buf);
+    test_concurrency_log = az_span_slice(
+        buffer, 0, az_span_size(buffer) - az_span_size(az_span_copy(buffer, message)));
+  }
+}
+
+static az_result test_concurrency_send(
+    _az_http_policy_concurrency_limiter_options* options,
+    az_context* context,
+    test_retry_transport* transport)
+{
+  test_concurrency_log = AZ_SPAN_NULL;
+  return test_endpoint_send(
+      az_http_pipeline_policy_concurrency_limiter, options, context, transport);
+}
+
+static _az_http_policy_concurrency_limiter_options* test_concurrency_options = NULL;
+
+// Sends another request through the limiter while the first one is in flight.
+static az_result test_policy_transport_concurrency_nested(
+    _az_http_policy* p_policies,
+    void* p_options,
+    _az_http_request* p_request,
+    az_http_response* p_response)
+{
+  (void)p_policies;
+  (void)p_request;
+
+  test_retry_transport nested = { .attempts = 0, .response = success_response };
+  az_context context = az_context_with_expiration(&az_context_app, 100);
+  assert_int_equal(
+      test_concurrency_send(test_concurrency_options, &context, &nested), AZ_ERROR_CANCELED);
+  assert_int_equal(nested.attempts, 0);
+
+  return test_policy_transport_retry_scripted(p_policies, p_options, p_request, p_response);
+}
+
+void test_az_http_pipeline_policy_concurrency_limiter(void** state)
+{
+  (void)state;
+
+  az_log_set_callback(test_concurrency_log_listener);
+
+  _az_http_policy_concurrency_limiter_options options;
+  assert_return_code(
+      _az_http_policy_concurrency_limiter_options_init(&options, NULL, 2, 1, 3, 200), AZ_OK);
+
+  test_retry_transport healthy = { .attempts = 0, .response = success_response };
+  test_retry_transport throttled = { .attempts = 0, .response = retry_response };
+
+  // The limit grows once as many requests as the limit completed in time.
+  will_return(__wrap_az_platform_clock_msec, 0);
+  will_return(__wrap_az_platform_clock_msec, 100);
+  assert_return_code(test_concurrency_send(&options, &az_context_app, &healthy), AZ_OK);
+  assert_true(az_span_is_content_equal(test_concurrency_log, AZ_SPAN_NULL));
+  will_return(__wrap_az_platform_clock_msec, 0);
+  will_return(__wrap_az_platform_clock_msec, 100);
+  assert_return_code(test_concurrency_send(&options, &az_context_app, &healthy), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_concurrency_log,
+      AZ_SPAN_FROM_STR("HTTP concurrency limit for account.blob.core.windows.net is now 3.")));
+
+  // It shrinks by one when a response is slower than the tolerance.
+  will_return(__wrap_az_platform_clock_msec, 0);
+  will_return(__wrap_az_platform_clock_msec, 300);
+  assert_return_code(test_concurrency_send(&options, &az_context_app, &healthy), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_concurrency_log,
+      AZ_SPAN_FROM_STR("HTTP concurrency limit for account.blob.core.windows.net is now 2.")));
+
+  // And by half when the endpoint pushes back, down to the minimum.
+  will_return_count(__wrap_az_platform_clock_msec, 0, 4);
+  assert_return_code(test_concurrency_send(&options, &az_context_app, &throttled), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_concurrency_log,
+      AZ_SPAN_FROM_STR("HTTP concurrency limit for account.blob.core.windows.net is now 1.")));
+  assert_return_code(test_concurrency_send(&options, &az_context_app, &throttled), AZ_OK);
+  assert_true(az_span_is_content_equal(test_concurrency_log, AZ_SPAN_NULL));
+  assert_int_equal(throttled.attempts, 2);
+
+  // A request over the limit waits until its context expires.
+  test_concurrency_options = &options;
+  will_return(__wrap_az_platform_clock_msec, 0); // Outer request sent
+  will_return(__wrap_az_platform_clock_msec, 50); // Nested request waits
+  will_return(__wrap_az_platform_clock_msec, 101); // Nested request gives up
+  will_return(__wrap_az_platform_clock_msec, 100); // Outer request completes
+  assert_return_code(
+      test_endpoint_send_through(
+          test_endpoint_url,
+          az_http_pipeline_policy_concurrency_limiter,
+          &options,
+          &az_context_app,
+          test_policy_transport_concurrency_nested,
+          &healthy),
+      AZ_OK);
+  assert_int_equal(healthy.attempts, 4);
+
+  // The request that gave up doesn't hold up the next one.
+  will_return(__wrap_az_platform_clock_msec, 0);
+  will_return(__wrap_az_platform_clock_msec, 100);
+  assert_return_code(test_concurrency_send(&options, &az_context_app, &healthy), AZ_OK);
+  assert_int_equal(healthy.attempts, 5);
+
+  // The baseline creeps up towards an endpoint that got slower for good, until its responses are
+  // in time again.
+  will_return(__wrap_az_platform_clock_msec, 0);
+  will_return(__wrap_az_platform_clock_msec, 300);
+  assert_return_code(test_concurrency_send(&options, &az_context_app, &healthy), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_concurrency_log,
+      AZ_SPAN_FROM_STR("HTTP concurrency limit for account.blob.core.windows.net is now 1.")));
+  for (int32_t i = 0; i < 8; ++i)
+  {
+    will_return(__wrap_az_platform_clock_msec, 0);
+    will_return(__wrap_az_platform_clock_msec, 300);
+    assert_return_code(test_concurrency_send(&options, &az_context_app, &healthy), AZ_OK);
+    assert_true(az_span_is_content_equal(test_concurrency_log, AZ_SPAN_NULL));
+  }
+  will_return(__wrap_az_platform_clock_msec, 0);
+  will_return(__wrap_az_platform_clock_msec, 300);
+  assert_return_code(test_concurrency_send(&options, &az_context_app, &healthy), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_concurrency_log,
+      AZ_SPAN_FROM_STR("HTTP concurrency limit for account.blob.core.windows.net is now 2.")));
+
+  test_concurrency_options = NULL;
+  az_log_set_callback(NULL);
+}
+
 #endif // _az_MOCK_ENABLED
 
 int test_az_policy()
@@ -335,9 +1280,17 @@ int test_az_policy()
     cmocka_unit_test(test_az_http_pipeline_policy_retry),
     cmocka_unit_test(test_az_http_pipeline_policy_retry_with_header),
     cmocka_unit_test(test_az_http_pipeline_policy_retry_with_header_2),
+    cmocka_unit_test(test_az_http_pipeline_policy_retry_deadline),
+    cmocka_unit_test(test_az_http_pipeline_policy_retry_jitter),
+    cmocka_unit_test(test_az_http_pipeline_policy_retry_budget),
+    cmocka_unit_test(test_az_http_pipeline_policy_retry_last_response),
+    cmocka_unit_test(test_az_http_pipeline_policy_circuit_breaker),
+    cmocka_unit_test(test_az_http_pipeline_policy_rate_limiter),
+    cmocka_unit_test(test_az_http_pipeline_policy_concurrency_limiter),
 #endif // _az_MOCK_ENABLED
     cmocka_unit_test(test_az_http_pipeline_policy_apiversion),
     cmocka_unit_test(test_az_http_pipeline_policy_telemetry),
+    cmocka_unit_test(test_az_http_pipeline_policy_compression),
   };
   return cmocka_run_group_tests_name("az_core_policy", tests, NULL, NULL);
 }
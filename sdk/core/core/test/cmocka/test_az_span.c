@@ -9,9 +9,11 @@
 
 #include <az_span.h>
 
+#include <inttypes.h>
 #include <limits.h>
 #include <setjmp.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #include <cmocka.h>
 
@@ -90,6 +92,78 @@ static void az_span_to_lower_test(void** state)
   assert_false(az_span_is_content_equal_ignoring_case(a, d));
 }
 
+static void az_span_is_content_equal_ignoring_case_long_test(void** state)
+{
+  (void)state;
+
+  // Every pair of byte values, at every position of a span compared 8 bytes at a time, must give
+  // the same result as comparing it one byte at a time.
+  for (int32_t position = 0; position < 17; position += 4)
+  {
+    for (int32_t i = 0; i <= UINT8_MAX; ++i)
+    {
+      for (int32_t j = 0; j <= UINT8_MAX; ++j)
+      {
+        uint8_t buffer1[] = "Content-Type: X-";
+        uint8_t buffer2[] = "content-type: x-";
+        buffer1[position] = (uint8_t)i;
+        buffer2[position] = (uint8_t)j;
+
+        bool const expected = i == j || (i >= 'A' && i <= 'Z' && j == i + 32)
+            || (i >= 'a' && i <= 'z' && j == i - 32);
+        assert_true(
+            az_span_is_content_equal_ignoring_case(
+                AZ_SPAN_FROM_BUFFER(buffer1), AZ_SPAN_FROM_BUFFER(buffer2))
+            == expected);
+      }
+    }
+  }
+
+  assert_true(az_span_is_content_equal_ignoring_case(
+      AZ_SPAN_FROM_STR("X-MS-RETRY-AFTER-MS"), AZ_SPAN_FROM_STR("x-ms-retry-after-ms")));
+  assert_false(az_span_is_content_equal_ignoring_case(
+      AZ_SPAN_FROM_STR("X-MS-RETRY-AFTER-MS"), AZ_SPAN_FROM_STR("x-ms-retry-after-mz")));
+  assert_false(az_span_is_content_equal_ignoring_case(
+      AZ_SPAN_FROM_STR("x-ms-retry@after-ms"), AZ_SPAN_FROM_STR("x-ms-retry`after-ms")));
+}
+
+static void az_span_name_matcher_test(void** state)
+{
+  (void)state;
+
+  az_span const names[] = {
+    AZ_SPAN_FROM_STR("retry-after-ms"),
+    AZ_SPAN_FROM_STR("x-ms-retry-after-ms"),
+    AZ_SPAN_FROM_STR("Retry-After"),
+    AZ_SPAN_FROM_STR("ETag"),
+  };
+  _az_span_name_matcher matcher;
+  assert_return_code(_az_span_name_matcher_init(&matcher, names, 4), AZ_OK);
+
+  assert_int_equal(_az_span_name_matcher_find(&matcher, AZ_SPAN_FROM_STR("Retry-After-Ms")), 0);
+  assert_int_equal(
+      _az_span_name_matcher_find(&matcher, AZ_SPAN_FROM_STR("X-MS-Retry-After-MS")), 1);
+  assert_int_equal(_az_span_name_matcher_find(&matcher, AZ_SPAN_FROM_STR("retry-after")), 2);
+  assert_int_equal(_az_span_name_matcher_find(&matcher, AZ_SPAN_FROM_STR("etag")), 3);
+
+  // Same size and first 8 bytes, but different afterwards.
+  assert_int_equal(_az_span_name_matcher_find(&matcher, AZ_SPAN_FROM_STR("retry-after-ns")), -1);
+  assert_int_equal(_az_span_name_matcher_find(&matcher, AZ_SPAN_FROM_STR("etag ")), -1);
+  assert_int_equal(_az_span_name_matcher_find(&matcher, AZ_SPAN_FROM_STR("eta")), -1);
+  assert_int_equal(_az_span_name_matcher_find(&matcher, AZ_SPAN_NULL), -1);
+
+  // Statically initialized matchers spell out the same prefixes.
+  assert_true(
+      matcher._internal.prefixes[1]
+      == _az_SPAN_NAME_MATCHER_PREFIX('x', '-', 'm', 's', '-', 'r', 'e', 't'));
+  assert_true(
+      matcher._internal.prefixes[3]
+      == _az_SPAN_NAME_MATCHER_PREFIX('e', 't', 'a', 'g', 0, 0, 0, 0));
+
+  assert_return_code(_az_span_name_matcher_init(&matcher, names, 0), AZ_OK);
+  assert_int_equal(_az_span_name_matcher_find(&matcher, AZ_SPAN_FROM_STR("etag")), -1);
+}
+
 static void az_span_atou64_return_errors(void** state)
 {
   (void)state;
@@ -110,6 +184,72 @@ static void az_span_atou32_test(void** state)
   assert_int_equal(value, 1024);
 }
 
+static void az_span_atou64_boundaries_test(void** state)
+{
+  (void)state;
+  uint64_t value = 0;
+
+  assert_return_code(az_span_atou64(AZ_SPAN_FROM_STR("0"), &value), AZ_OK);
+  assert_true(value == 0);
+  assert_return_code(az_span_atou64(AZ_SPAN_FROM_STR("12345678"), &value), AZ_OK);
+  assert_true(value == 12345678);
+  assert_return_code(az_span_atou64(AZ_SPAN_FROM_STR("1234567890123"), &value), AZ_OK);
+  assert_true(value == 1234567890123ULL);
+  assert_return_code(az_span_atou64(AZ_SPAN_FROM_STR("18446744073709551615"), &value), AZ_OK);
+  assert_true(value == UINT64_MAX);
+  assert_return_code(
+      az_span_atou64(AZ_SPAN_FROM_STR("0000000000000000000018446744073709551615"), &value), AZ_OK);
+  assert_true(value == UINT64_MAX);
+
+  assert_true(
+      az_span_atou64(AZ_SPAN_FROM_STR("18446744073709551616"), &value)
+      == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+  assert_true(
+      az_span_atou64(AZ_SPAN_FROM_STR("18446744083709551615"), &value)
+      == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+  assert_true(
+      az_span_atou64(AZ_SPAN_FROM_STR("184467440737095516150"), &value)
+      == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+
+  // A non-digit is detected at every position, both within 8-digit chunks and in the tail.
+  uint8_t buffer[] = "1234567890123456789";
+  az_span const number = az_span_init(buffer, (int32_t)sizeof(buffer) - 1);
+  uint8_t const invalid[] = { '/', ':', ' ', 'a', 0, 0xB0 };
+  for (int32_t i = 0; i < az_span_size(number); i++)
+  {
+    uint8_t const original = buffer[i];
+    for (size_t j = 0; j < sizeof(invalid); j++)
+    {
+      buffer[i] = invalid[j];
+      assert_true(az_span_atou64(number, &value) == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+    }
+    buffer[i] = original;
+  }
+  assert_return_code(az_span_atou64(number, &value), AZ_OK);
+  assert_true(value == 1234567890123456789ULL);
+}
+
+static void az_span_atou32_boundaries_test(void** state)
+{
+  (void)state;
+  uint32_t value = 0;
+
+  assert_return_code(az_span_atou32(AZ_SPAN_FROM_STR("4294967295"), &value), AZ_OK);
+  assert_true(value == UINT32_MAX);
+  assert_return_code(az_span_atou32(AZ_SPAN_FROM_STR("00000000000000004294967295"), &value), AZ_OK);
+  assert_true(value == UINT32_MAX);
+  assert_return_code(az_span_atou32(AZ_SPAN_FROM_STR("99999999"), &value), AZ_OK);
+  assert_true(value == 99999999);
+
+  assert_true(
+      az_span_atou32(AZ_SPAN_FROM_STR("4294967296"), &value) == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+  assert_true(
+      az_span_atou32(AZ_SPAN_FROM_STR("10000000000"), &value) == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+  assert_true(
+      az_span_atou32(AZ_SPAN_FROM_STR("1234567x9"), &value) == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+  assert_true(az_span_atou32(AZ_SPAN_FROM_STR("-1"), &value) == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+}
+
 static void az_span_to_str_test(void** state)
 {
   (void)state;
@@ -261,6 +401,110 @@ static void az_span_find_overlapping_checks_success(void** state)
   assert_int_equal(az_span_find(source, az_span_slice(span, 2, 4)), 1);
 }
 
+static void az_span_find_long_target_success(void** state)
+{
+  (void)state;
+
+  az_span span = AZ_SPAN_FROM_STR(
+      "$iothub/twin/PATCH/properties/desired/?$version=2&$iothub/twin/PATCH/properties/reported/"
+      "?$rid=1");
+  assert_int_equal(
+      az_span_find(span, AZ_SPAN_FROM_STR("$iothub/twin/PATCH/properties/reported/")), 50);
+  assert_int_equal(
+      az_span_find(span, AZ_SPAN_FROM_STR("$iothub/twin/PATCH/properties/reported/?$rid=2")), -1);
+
+  // Periodic target, with a partial match on every position before the actual one.
+  az_span periodic = AZ_SPAN_FROM_STR("abababababababababababababababababababababababababababx");
+  assert_int_equal(
+      az_span_find(periodic, AZ_SPAN_FROM_STR("ababababababababababababababababababx")), 18);
+  assert_int_equal(
+      az_span_find(periodic, AZ_SPAN_FROM_STR("abababababababababababababababababaa")), -1);
+}
+
+static int32_t _naive_find(az_span source, az_span target)
+{
+  for (int32_t i = 0; i <= az_span_size(source) - az_span_size(target); i++)
+  {
+    if (memcmp(az_span_ptr(source) + i, az_span_ptr(target), (size_t)az_span_size(target)) == 0)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static uint32_t _find_test_random(uint32_t* seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 8;
+}
+
+// Fills buffer with a pattern repeating every `period` bytes, then changes a few random bytes.
+static void _find_test_fill(
+    uint8_t* buffer,
+    int32_t size,
+    uint32_t alphabet_size,
+    uint32_t period,
+    int32_t mutations,
+    uint32_t* seed)
+{
+  for (int32_t i = 0; i < size; i++)
+  {
+    buffer[i] = (uint32_t)i < period ? (uint8_t)('a' + _find_test_random(seed) % alphabet_size)
+                                     : buffer[(uint32_t)i - period];
+  }
+  for (int32_t i = 0; i < mutations && size > 0; i++)
+  {
+    buffer[_find_test_random(seed) % (uint32_t)size]
+        = (uint8_t)('a' + _find_test_random(seed) % alphabet_size);
+  }
+}
+
+static void az_span_find_matches_naive_search_success(void** state)
+{
+  (void)state;
+
+  uint8_t source_buffer[300];
+  uint8_t target_buffer[80];
+  uint32_t seed = 12345;
+
+  for (int32_t iteration = 0; iteration < 6000; iteration++)
+  {
+    // Small alphabets and periodic contents produce lots of partial matches, which exercise the
+    // shifts of the two-way algorithm.
+    uint32_t const alphabet_size = 2 + (uint32_t)iteration % 3;
+    bool const periodic = iteration % 2 == 0;
+    uint32_t const period = periodic ? 1 + _find_test_random(&seed) % 6 : UINT32_MAX;
+    int32_t const source_size = (int32_t)(_find_test_random(&seed) % sizeof(source_buffer));
+    int32_t const target_size = 1 + (int32_t)(_find_test_random(&seed) % sizeof(target_buffer));
+
+    uint32_t const pattern_seed = seed;
+    _find_test_fill(source_buffer, source_size, alphabet_size, period, source_size / 40, &seed);
+    if (periodic)
+    {
+      // Same repeating pattern as the source, so that most positions are near-matches.
+      seed = pattern_seed;
+    }
+    _find_test_fill(
+        target_buffer, target_size, alphabet_size, period, (int32_t)(seed >> 30) % 2, &seed);
+
+    az_span const source = az_span_init(source_buffer, source_size);
+    az_span const target = az_span_init(target_buffer, target_size);
+    assert_int_equal(az_span_find(source, target), _naive_find(source, target));
+
+    // Also look for a slice of the source, which is always found.
+    if (target_size <= source_size)
+    {
+      int32_t const start
+          = (int32_t)(_find_test_random(&seed) % (uint32_t)(source_size - target_size + 1));
+      az_span const slice = az_span_slice(source, start, start + target_size);
+      int32_t const index = az_span_find(source, slice);
+      assert_int_equal(index, _naive_find(source, slice));
+      assert_true(index <= start);
+    }
+  }
+}
+
 static void test_az_span_replace(void** state)
 {
   (void)state;
@@ -752,6 +996,80 @@ static void az_span_u32toa_overflow_fails(void** state)
   assert_true(az_span_u32toa(buffer, v, &out_span) == AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
 }
 
+static void _verify_u64toa(uint64_t value)
+{
+  char expected[21];
+  int const expected_size = snprintf(expected, sizeof(expected), "%" PRIu64, value);
+
+  uint8_t raw_buffer[21];
+  az_span out_span;
+  assert_true(az_succeeded(az_span_u64toa(AZ_SPAN_FROM_BUFFER(raw_buffer), value, &out_span)));
+  assert_int_equal(az_span_size(out_span), (int32_t)sizeof(raw_buffer) - expected_size);
+  assert_memory_equal(raw_buffer, expected, (size_t)expected_size);
+  assert_int_equal(_az_span_u64toa_size(value), expected_size);
+
+  // Exactly enough room succeeds, one byte less fails.
+  assert_true(az_succeeded(
+      az_span_u64toa(az_span_init(raw_buffer, expected_size), value, &out_span)));
+  assert_int_equal(az_span_size(out_span), 0);
+  assert_true(
+      az_span_u64toa(az_span_init(raw_buffer, expected_size - 1), value, &out_span)
+      == AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+
+  if (value <= UINT32_MAX)
+  {
+    assert_true(az_succeeded(
+        az_span_u32toa(AZ_SPAN_FROM_BUFFER(raw_buffer), (uint32_t)value, &out_span)));
+    assert_int_equal(az_span_size(out_span), (int32_t)sizeof(raw_buffer) - expected_size);
+    assert_memory_equal(raw_buffer, expected, (size_t)expected_size);
+    assert_int_equal(_az_span_u32toa_size((uint32_t)value), expected_size);
+  }
+}
+
+static void az_span_u64toa_matches_printf_succeeds(void** state)
+{
+  (void)state;
+
+  uint64_t power = 1;
+  for (int32_t i = 0; i < 20; i++)
+  {
+    _verify_u64toa(power - 1);
+    _verify_u64toa(power);
+    _verify_u64toa(power + 1);
+    power *= 10;
+  }
+  _verify_u64toa(UINT32_MAX);
+  _verify_u64toa((uint64_t)UINT32_MAX + 1);
+  _verify_u64toa(UINT64_MAX);
+
+  uint64_t value = 88172645463325252ULL;
+  for (int32_t i = 0; i < 1000; i++)
+  {
+    // xorshift64
+    value ^= value << 13;
+    value ^= value >> 7;
+    value ^= value << 17;
+    _verify_u64toa(value >> (i % 64));
+  }
+}
+
+static void az_span_itoa_min_values_succeeds(void** state)
+{
+  (void)state;
+  uint8_t raw_buffer[25];
+  az_span const buffer = AZ_SPAN_FROM_BUFFER(raw_buffer);
+  az_span out_span;
+
+  assert_true(az_succeeded(az_span_i64toa(buffer, INT64_MIN, &out_span)));
+  assert_true(az_span_is_content_equal(
+      az_span_slice(buffer, 0, _az_span_diff(out_span, buffer)),
+      AZ_SPAN_FROM_STR("-9223372036854775808")));
+
+  assert_true(az_succeeded(az_span_i32toa(buffer, INT32_MIN, &out_span)));
+  assert_true(az_span_is_content_equal(
+      az_span_slice(buffer, 0, _az_span_diff(out_span, buffer)), AZ_SPAN_FROM_STR("-2147483648")));
+}
+
 static void az_span_copy_empty(void** state)
 {
   (void)state;
@@ -918,6 +1236,157 @@ static void test_az_span_token_success(void** state)
   assert_true(az_span_is_content_equal(token, AZ_SPAN_NULL));
 }
 
+static void az_span_arena_alloc_succeeds(void** state)
+{
+  (void)state;
+  uint8_t buf[64];
+  az_span_arena arena;
+  assert_return_code(az_span_arena_init(&arena, AZ_SPAN_FROM_BUFFER(buf)), AZ_OK);
+
+  // Start from an odd address, so that the alignment of the next allocation is exercised.
+  az_span first;
+  assert_return_code(az_span_arena_alloc(&arena, 3, &first), AZ_OK);
+  assert_int_equal(az_span_size(first), 3);
+
+  az_span second;
+  assert_return_code(az_span_arena_alloc(&arena, 16, &second), AZ_OK);
+  assert_int_equal(az_span_size(second), 16);
+  assert_int_equal((uintptr_t)az_span_ptr(second) % 8, 0);
+  assert_true(az_span_ptr(second) >= az_span_ptr(first) + 3);
+
+  int32_t const remaining = az_span_arena_remaining(&arena);
+  assert_true(remaining > 0);
+  assert_true(remaining <= 64 - 19);
+
+  az_span rest;
+  assert_true(
+      az_span_arena_alloc(&arena, remaining + 1, &rest) == AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+  assert_return_code(az_span_arena_alloc(&arena, remaining, &rest), AZ_OK);
+  assert_int_equal(az_span_arena_remaining(&arena), 0);
+  assert_true(az_span_arena_alloc(&arena, 1, &rest) == AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+}
+
+static void az_span_arena_mark_reset_succeeds(void** state)
+{
+  (void)state;
+  uint8_t buf[64];
+  az_span_arena arena;
+  assert_return_code(az_span_arena_init(&arena, AZ_SPAN_FROM_BUFFER(buf)), AZ_OK);
+  assert_int_equal(az_span_arena_mark(&arena), 0);
+
+  az_span first;
+  assert_return_code(az_span_arena_alloc(&arena, 8, &first), AZ_OK);
+  int32_t const mark = az_span_arena_mark(&arena);
+
+  az_span second;
+  assert_return_code(az_span_arena_alloc(&arena, 40, &second), AZ_OK);
+  az_span third;
+  assert_true(az_span_arena_alloc(&arena, 40, &third) == AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+
+  // Releasing the second allocation makes its bytes available again.
+  az_span_arena_reset(&arena, mark);
+  assert_int_equal(az_span_arena_mark(&arena), mark);
+  assert_return_code(az_span_arena_alloc(&arena, 40, &third), AZ_OK);
+  assert_ptr_equal(az_span_ptr(third), az_span_ptr(second));
+
+  az_span_arena_reset(&arena, 0);
+  assert_return_code(az_span_arena_alloc(&arena, 8, &third), AZ_OK);
+  assert_ptr_equal(az_span_ptr(third), az_span_ptr(first));
+}
+
+static void az_span_find_byte_succeeds(void** state)
+{
+  (void)state;
+  az_span const source = AZ_SPAN_FROM_STR("x-ms-request-id: 0123456789abcdef\r\n");
+
+  assert_int_equal(_az_span_find_byte(source, 'x'), 0);
+  assert_int_equal(_az_span_find_byte(source, ':'), 15);
+  assert_int_equal(_az_span_find_byte(source, '\r'), 33);
+  assert_int_equal(_az_span_find_byte(source, '\n'), 34);
+  assert_int_equal(_az_span_find_byte(source, '\0'), -1);
+  assert_int_equal(_az_span_find_byte(AZ_SPAN_NULL, ':'), -1);
+
+  // Every position, within and past the 8-byte words
+  uint8_t buffer[20];
+  for (int32_t i = 0; i < (int32_t)sizeof(buffer); ++i)
+  {
+    memset(buffer, 0x81, sizeof(buffer));
+    buffer[i] = ':';
+    assert_int_equal(_az_span_find_byte(AZ_SPAN_FROM_BUFFER(buffer), ':'), i);
+    assert_int_equal(_az_span_find_byte(AZ_SPAN_FROM_BUFFER(buffer), 0x80), -1);
+  }
+}
+
+static void az_span_find_byte_below_succeeds(void** state)
+{
+  (void)state;
+  az_span const source = AZ_SPAN_FROM_STR("text/plain; charset=utf-8\t \xC3\xA9\r\n");
+
+  assert_int_equal(_az_span_find_byte_below(source, ' '), 25);
+  assert_int_equal(_az_span_find_byte_below(source, '\t'), -1);
+  assert_int_equal(_az_span_find_byte_below(source, '\n'), 25);
+  assert_int_equal(_az_span_find_byte_below(AZ_SPAN_NULL, ' '), -1);
+
+  uint8_t buffer[20];
+  for (int32_t i = 0; i < (int32_t)sizeof(buffer); ++i)
+  {
+    // Bytes with their high bit set are not below the bound
+    memset(buffer, 0xA0, sizeof(buffer));
+    buffer[i] = 0x1F;
+    assert_int_equal(_az_span_find_byte_below(AZ_SPAN_FROM_BUFFER(buffer), ' '), i);
+  }
+}
+
+static void az_span_list_append_succeeds(void** state)
+{
+  (void)state;
+  az_span spans[3];
+  az_span_list list;
+  assert_return_code(az_span_list_init(&list, spans, _az_COUNTOF(spans)), AZ_OK);
+  assert_int_equal(az_span_list_count(&list), 0);
+  assert_int_equal(az_span_list_size(&list), 0);
+
+  assert_return_code(az_span_list_append(&list, AZ_SPAN_FROM_STR("abc")), AZ_OK);
+  assert_return_code(az_span_list_append(&list, AZ_SPAN_NULL), AZ_OK);
+  assert_return_code(az_span_list_append(&list, AZ_SPAN_FROM_STR("de")), AZ_OK);
+  assert_return_code(az_span_list_append(&list, AZ_SPAN_FROM_STR("f")), AZ_OK);
+  assert_int_equal(az_span_list_count(&list), 3);
+  assert_int_equal(az_span_list_size(&list), 6);
+
+  assert_int_equal(
+      az_span_list_append(&list, AZ_SPAN_FROM_STR("g")), AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+  assert_int_equal(az_span_list_count(&list), 3);
+  assert_int_equal(az_span_list_size(&list), 6);
+
+  assert_true(az_span_is_content_equal(az_span_list_get(&list, 0), AZ_SPAN_FROM_STR("abc")));
+  assert_true(az_span_is_content_equal(az_span_list_get(&list, 1), AZ_SPAN_FROM_STR("de")));
+  assert_true(az_span_is_content_equal(az_span_list_get(&list, 2), AZ_SPAN_FROM_STR("f")));
+}
+
+static void az_span_list_flatten_succeeds(void** state)
+{
+  (void)state;
+  az_span spans[3];
+  az_span_list list;
+  assert_return_code(az_span_list_init(&list, spans, _az_COUNTOF(spans)), AZ_OK);
+  assert_return_code(az_span_list_append(&list, AZ_SPAN_FROM_STR("{\"id\":")), AZ_OK);
+  assert_return_code(az_span_list_append(&list, AZ_SPAN_FROM_STR("42")), AZ_OK);
+  assert_return_code(az_span_list_append(&list, AZ_SPAN_FROM_STR("}")), AZ_OK);
+
+  uint8_t buffer[10];
+  az_span remainder;
+  assert_return_code(
+      az_span_list_flatten(&list, AZ_SPAN_FROM_BUFFER(buffer), &remainder), AZ_OK);
+  assert_int_equal(az_span_size(remainder), 1);
+  assert_true(az_span_is_content_equal(
+      az_span_slice(AZ_SPAN_FROM_BUFFER(buffer), 0, 9), AZ_SPAN_FROM_STR("{\"id\":42}")));
+
+  uint8_t small_buffer[7];
+  assert_int_equal(
+      az_span_list_flatten(&list, AZ_SPAN_FROM_BUFFER(small_buffer), &remainder),
+      AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+}
+
 int test_az_span()
 {
   const struct CMUnitTest tests[] = {
@@ -925,6 +1394,8 @@ int test_az_span()
     cmocka_unit_test(test_az_span_getters),
     cmocka_unit_test(az_single_char_ascii_lower_test),
     cmocka_unit_test(az_span_to_lower_test),
+    cmocka_unit_test(az_span_is_content_equal_ignoring_case_long_test),
+    cmocka_unit_test(az_span_name_matcher_test),
     cmocka_unit_test(az_span_to_str_test),
     cmocka_unit_test(az_span_find_beginning_success),
     cmocka_unit_test(az_span_find_middle_success),
@@ -939,9 +1410,13 @@ int test_az_span()
     cmocka_unit_test(az_span_find_embedded_NULLs_success),
     cmocka_unit_test(az_span_find_capacity_checks_success),
     cmocka_unit_test(az_span_find_overlapping_checks_success),
+    cmocka_unit_test(az_span_find_long_target_success),
+    cmocka_unit_test(az_span_find_matches_naive_search_success),
     cmocka_unit_test(test_az_span_replace),
     cmocka_unit_test(az_span_atou64_return_errors),
     cmocka_unit_test(az_span_atou32_test),
+    cmocka_unit_test(az_span_atou64_boundaries_test),
+    cmocka_unit_test(az_span_atou32_boundaries_test),
     cmocka_unit_test(az_span_i64toa_negative_number_test),
     cmocka_unit_test(az_span_i64toa_test),
     cmocka_unit_test(az_span_test_macro_only_allows_byte_buffers),
@@ -956,6 +1431,8 @@ int test_az_span()
     cmocka_unit_test(az_span_u32toa_zero_succeeds),
     cmocka_unit_test(az_span_u32toa_max_uint_succeeds),
     cmocka_unit_test(az_span_u32toa_overflow_fails),
+    cmocka_unit_test(az_span_u64toa_matches_printf_succeeds),
+    cmocka_unit_test(az_span_itoa_min_values_succeeds),
     cmocka_unit_test(az_span_copy_empty),
     cmocka_unit_test(az_span_trim),
     cmocka_unit_test(az_span_trim_left),
@@ -972,6 +1449,12 @@ int test_az_span()
     cmocka_unit_test(az_span_trim_two_calls),
     cmocka_unit_test(az_span_trim_two_calls_inverse),
     cmocka_unit_test(az_span_trim_repeat_calls),
+    cmocka_unit_test(az_span_arena_alloc_succeeds),
+    cmocka_unit_test(az_span_arena_mark_reset_succeeds),
+    cmocka_unit_test(az_span_find_byte_succeeds),
+    cmocka_unit_test(az_span_find_byte_below_succeeds),
+    cmocka_unit_test(az_span_list_append_succeeds),
+    cmocka_unit_test(az_span_list_flatten_succeeds),
   };
   return cmocka_run_group_tests_name("az_core_span", tests, NULL, NULL);
 }
@@ -63,10 +63,98 @@ static void test_url_encode(void** state)
   assert_true(az_span_is_content_equal(az_span_slice(buffer, 0, url_length), url_encoded));
 }
 
+static void test_url_encode_size(void** state)
+{
+  (void)state;
+
+  assert_int_equal(_az_span_url_encode_size(AZ_SPAN_NULL), 0);
+  assert_int_equal(_az_span_url_encode_size(AZ_SPAN_FROM_STR("abc-_.~XYZ019")), 13);
+  assert_int_equal(_az_span_url_encode_size(AZ_SPAN_FROM_STR("a b/c")), 9);
+  assert_int_equal(
+      _az_span_url_encode_size(AZ_SPAN_FROM_BUFFER(url_decoded_buf)), az_span_size(url_encoded));
+}
+
+static void test_url_encode_insufficient_size_fails(void** state)
+{
+  (void)state;
+  uint8_t buf[8] = { 0 };
+  int32_t url_length = -1;
+
+  assert_true(
+      _az_span_url_encode(AZ_SPAN_FROM_BUFFER(buf), AZ_SPAN_FROM_STR("a/b/c"), &url_length)
+      == AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+  assert_int_equal(url_length, 0);
+
+  assert_true(az_succeeded(
+      _az_span_url_encode(AZ_SPAN_FROM_BUFFER(buf), AZ_SPAN_FROM_STR("a/b/"), &url_length)));
+  assert_int_equal(url_length, 8);
+  assert_memory_equal(buf, "a%2Fb%2F", 8);
+}
+
+static void test_url_decode(void** state)
+{
+  (void)state;
+  uint8_t buf[256] = { 0 };
+  az_span const buffer = AZ_SPAN_FROM_BUFFER(buf);
+  int32_t length = 0;
+
+  assert_true(az_succeeded(
+      _az_span_url_decode(buffer, AZ_SPAN_FROM_STR("https%3A%2f%2Fvault.azure.net+x"), &length)));
+  assert_true(az_span_is_content_equal(
+      az_span_slice(buffer, 0, length), AZ_SPAN_FROM_STR("https://vault.azure.net+x")));
+
+  assert_true(az_succeeded(_az_span_url_decode(buffer, url_encoded, &length)));
+  assert_true(az_span_is_content_equal(
+      az_span_slice(buffer, 0, length), AZ_SPAN_FROM_BUFFER(url_decoded_buf)));
+
+  assert_true(az_succeeded(_az_span_url_decode(buffer, AZ_SPAN_NULL, &length)));
+  assert_int_equal(length, 0);
+}
+
+static void test_url_decode_in_place(void** state)
+{
+  (void)state;
+  uint8_t buf[] = "a%20b%2Cc%25";
+  az_span const buffer = az_span_init(buf, (int32_t)sizeof(buf) - 1);
+  int32_t length = 0;
+
+  assert_true(az_succeeded(_az_span_url_decode(buffer, buffer, &length)));
+  assert_true(
+      az_span_is_content_equal(az_span_slice(buffer, 0, length), AZ_SPAN_FROM_STR("a b,c%")));
+}
+
+static void test_url_decode_fails(void** state)
+{
+  (void)state;
+  uint8_t buf[16] = { 0 };
+  az_span const buffer = AZ_SPAN_FROM_BUFFER(buf);
+  int32_t length = 0;
+
+  assert_true(_az_span_url_decode(buffer, AZ_SPAN_FROM_STR("abc%2"), &length) == AZ_ERROR_EOF);
+  assert_true(_az_span_url_decode(buffer, AZ_SPAN_FROM_STR("abc%"), &length) == AZ_ERROR_EOF);
+  assert_true(
+      _az_span_url_decode(buffer, AZ_SPAN_FROM_STR("abc%2G"), &length)
+      == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+  assert_true(
+      _az_span_url_decode(buffer, AZ_SPAN_FROM_STR("%:0"), &length)
+      == AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+  assert_true(
+      _az_span_url_decode(az_span_slice(buffer, 0, 2), AZ_SPAN_FROM_STR("abc"), &length)
+      == AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+  assert_true(
+      _az_span_url_decode(az_span_slice(buffer, 0, 2), AZ_SPAN_FROM_STR("ab%20"), &length)
+      == AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+}
+
 int test_az_url_encode()
 {
   const struct CMUnitTest tests[] = {
     cmocka_unit_test(test_url_encode),
+    cmocka_unit_test(test_url_encode_size),
+    cmocka_unit_test(test_url_encode_insufficient_size_fails),
+    cmocka_unit_test(test_url_decode),
+    cmocka_unit_test(test_url_decode_in_place),
+    cmocka_unit_test(test_url_decode_fails),
   };
   return cmocka_run_group_tests_name("az_core_encode", tests, NULL, NULL);
 }
@@ -11,6 +11,7 @@
 
 #include <az_log_internal.h>
 #include <az_retry_internal.h>
+#include <az_span_internal.h>
 
 #include <_az_cfg.h>
 
@@ -48,20 +49,5 @@ AZ_NODISCARD int32_t az_iot_retry_calc_delay(
 
 AZ_NODISCARD int32_t _az_iot_u32toa_size(uint32_t number)
 {
-  if (number == 0)
-  {
-    return 1;
-  }
-  else
-  {
-    uint32_t div = 1000000000;
-    int32_t digit_count = 10;
-    while (number / div == 0)
-    {
-      div /= 10;
-      digit_count--;
-    }
-
-    return digit_count;
-  }
+  return _az_span_u32toa_size(number);
 }
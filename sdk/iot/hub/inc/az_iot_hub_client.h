@@ -194,6 +194,177 @@ AZ_NODISCARD az_result az_iot_hub_client_sas_get_password(
     size_t mqtt_password_size,
     size_t* out_mqtt_password_length);
 
+/**
+ *
+ * SAS Token Renewal APIs
+ *
+ *   Use the following APIs to keep the SAS tokens of many #az_iot_hub_client instances (such as
+ *   the devices behind a gateway) renewed. The HMAC-SHA256 key of each device is set up once with
+ *   the HMAC-SHA256 engine of the platform, and devices are kept in a timer wheel bucketed by
+ *   renewal time, so that each call to #az_iot_hub_client_sas_renewal_tick only visits the devices
+ *   that are due.
+ */
+
+enum
+{
+  _az_IOT_HUB_CLIENT_SAS_RENEWAL_SLOT_COUNT = 64,
+  _az_IOT_HUB_CLIENT_SAS_RENEWAL_HMAC_KEY_SIZE = 128, // Room for the platform HMAC-SHA256 key
+};
+
+/**
+ * @brief SAS token renewal options.
+ *
+ */
+typedef struct az_iot_hub_client_sas_renewal_options
+{
+  uint32_t token_duration_seconds; /**< The validity of each SAS token, in seconds. */
+  uint32_t renewal_margin_seconds; /**< How long before its expiration a token is renewed. Must be
+                                      less than half of `token_duration_seconds`. */
+} az_iot_hub_client_sas_renewal_options;
+
+/**
+ * @brief The state kept for one device by an #az_iot_hub_client_sas_renewal.
+ *
+ */
+typedef struct az_iot_hub_client_sas_renewal_device
+{
+  struct
+  {
+    az_iot_hub_client const* client;
+    az_span key_name;
+    // The platform key, with the HMAC-SHA256 pads already hashed. Its type is only known to the
+    // platform, so it is kept as aligned bytes.
+    uint64_t hmac_key[_az_IOT_HUB_CLIENT_SAS_RENEWAL_HMAC_KEY_SIZE / sizeof(uint64_t)];
+    uint32_t token_expiration_epoch_time;
+    int32_t password_length;
+    int32_t next;
+  } _internal;
+} az_iot_hub_client_sas_renewal_device;
+
+/**
+ * @brief Renews the SAS tokens of a set of devices.
+ *
+ */
+typedef struct az_iot_hub_client_sas_renewal
+{
+  struct
+  {
+    az_iot_hub_client_sas_renewal_device* devices;
+    int32_t device_capacity;
+    int32_t device_count;
+    az_span password_slab;
+    int32_t password_capacity;
+    uint32_t tick_seconds;
+    uint32_t processed_tick;
+    int32_t slots[_az_IOT_HUB_CLIENT_SAS_RENEWAL_SLOT_COUNT];
+    az_iot_hub_client_sas_renewal_options options;
+  } _internal;
+} az_iot_hub_client_sas_renewal;
+
+/**
+ * @brief Gets the default SAS token renewal options.
+ * @details Tokens are valid for one hour and are renewed five minutes before they expire.
+ *
+ * @return #az_iot_hub_client_sas_renewal_options.
+ */
+AZ_NODISCARD az_iot_hub_client_sas_renewal_options az_iot_hub_client_sas_renewal_options_default();
+
+/**
+ * @brief Initializes an #az_iot_hub_client_sas_renewal.
+ *
+ * @param[out] renewal The #az_iot_hub_client_sas_renewal to initialize.
+ * @param[in] devices An array of \p device_capacity #az_iot_hub_client_sas_renewal_device, which
+ *                    must remain valid for the lifetime of \p renewal.
+ * @param[in] device_capacity The number of elements of \p devices.
+ * @param[in] password_slab The #az_span holding the MQTT passwords. It is split into
+ *                          `device_capacity + 1` slots of equal size: one per device, and one
+ *                          where each new password is built before it replaces the current one.
+ * @param[in] options A reference to an #az_iot_hub_client_sas_renewal_options structure. If `NULL`
+ *                    is passed, the default options are used.
+ * @return #az_result.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_sas_renewal_init(
+    az_iot_hub_client_sas_renewal* renewal,
+    az_iot_hub_client_sas_renewal_device* devices,
+    int32_t device_capacity,
+    az_span password_slab,
+    az_iot_hub_client_sas_renewal_options const* options);
+
+/**
+ * @brief Adds a device and generates its first MQTT password.
+ * @details The first token of each device is given a slightly shorter lifetime, depending on its
+ *          index, so that devices added at the same time are not all renewed at the same time.
+ *
+ * @param[in] renewal The #az_iot_hub_client_sas_renewal to use for this call.
+ * @param[in] client The #az_iot_hub_client of the device. It must remain valid for the lifetime of
+ *                   \p renewal.
+ * @param[in] base64_device_key The Base64 encoded Shared Access Key of the device, of up to 128
+ *                              bytes once decoded. Only the HMAC-SHA256 key derived from it is kept
+ *                              by \p renewal, until #az_iot_hub_client_sas_renewal_deinit.
+ * @param[in] key_name The Shared Access Key Name (Policy Name). This is optional.
+ * @param[in] current_epoch_time The current time, in seconds, from 1/1/1970.
+ * @param[out] out_device_index __[nullable]__ The index of the device, to be passed to
+ *                              #az_iot_hub_client_sas_renewal_get_password. Can be `NULL`.
+ * @return #az_result.
+ *         #AZ_OK if successful.
+ *         #AZ_ERROR_INSUFFICIENT_SPAN_SIZE If there is no room for another device, or the password
+ *           slot is too small.
+ *         #AZ_ERROR_PARSER_UNEXPECTED_CHAR If \p base64_device_key is not valid Base64.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_sas_renewal_add_device(
+    az_iot_hub_client_sas_renewal* renewal,
+    az_iot_hub_client const* client,
+    az_span base64_device_key,
+    az_span key_name,
+    uint32_t current_epoch_time,
+    int32_t* out_device_index);
+
+/**
+ * @brief Renews the tokens of all the devices that are due.
+ * @details Call this periodically, for instance once every few seconds. The tokens renewed by a
+ *          call are the ones expiring within the renewal margin, rounded up to the wheel
+ *          granularity of `token_duration_seconds / 64`.
+ *
+ * @param[in] renewal The #az_iot_hub_client_sas_renewal to use for this call.
+ * @param[in] current_epoch_time The current time, in seconds, from 1/1/1970.
+ * @param[out] out_renewed_count __[nullable]__ The number of devices whose password was renewed.
+ *                               Can be `NULL`.
+ * @return #az_result.
+ *         #AZ_OK if successful.
+ *         An error if the password of a device could not be written. The other due devices are
+ *           still renewed, and the failed device is retried on the next call.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_sas_renewal_tick(
+    az_iot_hub_client_sas_renewal* renewal,
+    uint32_t current_epoch_time,
+    int32_t* out_renewed_count);
+
+/**
+ * @brief Gets the current MQTT password of a device.
+ *
+ * @param[in] renewal The #az_iot_hub_client_sas_renewal to use for this call.
+ * @param[in] device_index The index returned by #az_iot_hub_client_sas_renewal_add_device.
+ * @param[out] out_mqtt_password The password. It is followed by a null terminator in the password
+ *                               slab. A renewal that fails leaves the current password in place.
+ * @param[out] out_token_expiration_epoch_time __[nullable]__ The expiration time of the token, in
+ *                                             seconds, from 1/1/1970. Can be `NULL`.
+ * @return #az_result.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_sas_renewal_get_password(
+    az_iot_hub_client_sas_renewal const* renewal,
+    int32_t device_index,
+    az_span* out_mqtt_password,
+    uint32_t* out_token_expiration_epoch_time);
+
+/**
+ * @brief Releases the keys of all the devices and erases them, along with the passwords.
+ * @details Call this once \p renewal is no longer used. The devices and the password slab given to
+ *          #az_iot_hub_client_sas_renewal_init can then be reused.
+ *
+ * @param[in] renewal The #az_iot_hub_client_sas_renewal to deinitialize.
+ */
+void az_iot_hub_client_sas_renewal_deinit(az_iot_hub_client_sas_renewal* renewal);
+
 /**
  *
  * Properties APIs
@@ -575,6 +746,32 @@ AZ_NODISCARD az_result az_iot_hub_client_twin_patch_get_publish_topic(
     size_t mqtt_topic_size,
     size_t* out_mqtt_topic_length);
 
+/**
+ * @brief Builds the minimal Twin PATCH payload that moves the reported properties from
+ *        \p previous_reported to \p current_reported.
+ * @remark The payload is a JSON merge patch (RFC 7396): members that were added or changed are
+ *         included with their current value, nested objects only contain the members that changed
+ *         and members that were removed are set to `null`. Arrays are always sent as a whole. If
+ *         nothing changed, the payload is an empty object (`{}`).
+ *
+ * @param[in] client The #az_iot_hub_client to use for this call.
+ * @param[in] previous_reported __[nullable]__ An #az_span containing the JSON object last
+ *                              reported to the service. If empty, every member of
+ *                              \p current_reported is included in the payload.
+ * @param[in] current_reported An #az_span containing the JSON object to report.
+ * @param[in] patch An #az_span with sufficient capacity to hold the payload.
+ * @param[out] out_patch The portion of \p patch containing the payload.
+ * @return #az_result
+ *         - `AZ_ERROR_INSUFFICIENT_SPAN_SIZE` if \p patch is too small.
+ *         - `AZ_ERROR_PARSER_UNEXPECTED_CHAR` if either document is not a JSON object.
+ */
+AZ_NODISCARD az_result az_iot_hub_client_twin_patch_get_reported_diff(
+    az_iot_hub_client const* client,
+    az_span previous_reported,
+    az_span current_reported,
+    az_span patch,
+    az_span* out_patch);
+
 #include <_az_cfg_suffix.h>
 
 #endif //!_az_IOT_HUB_CLIENT_H
@@ -0,0 +1,367 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include <az_iot_hub_client.h>
+#include <az_precondition.h>
+#include <az_result.h>
+#include <az_span.h>
+
+#include <az_crypto_internal.h>
+#include <az_platform_internal.h>
+#include <az_precondition_internal.h>
+#include <az_span_internal.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <_az_cfg.h>
+
+enum
+{
+  _az_IOT_HUB_SAS_DEFAULT_TOKEN_DURATION_SECONDS = 60 * 60,
+  _az_IOT_HUB_SAS_DEFAULT_RENEWAL_MARGIN_SECONDS = 5 * 60,
+  _az_IOT_HUB_SAS_BASE64_SIGNATURE_SIZE = ((_az_SHA256_HASH_SIZE + 2) / 3) * 4,
+  // Every Base64 character may need to be percent-encoded.
+  _az_IOT_HUB_SAS_URL_ENCODED_SIGNATURE_SIZE = _az_IOT_HUB_SAS_BASE64_SIGNATURE_SIZE * 3,
+  _az_IOT_HUB_SAS_NO_DEVICE = -1,
+  _az_IOT_HUB_SAS_DEVICE_KEY_MAX_SIZE = 128,
+};
+
+// Fails to compile if the platform key doesn't fit in the room a device has for it.
+typedef char _az_iot_hub_client_sas_renewal_hmac_key_fits
+    [sizeof(az_platform_hmac_sha256_key) <= _az_IOT_HUB_CLIENT_SAS_RENEWAL_HMAC_KEY_SIZE ? 1 : -1];
+
+AZ_INLINE az_platform_hmac_sha256_key* _az_iot_hub_client_sas_renewal_hmac_key(
+    az_iot_hub_client_sas_renewal_device* device)
+{
+  return (az_platform_hmac_sha256_key*)(void*)device->_internal.hmac_key;
+}
+
+AZ_NODISCARD az_iot_hub_client_sas_renewal_options az_iot_hub_client_sas_renewal_options_default()
+{
+  return (az_iot_hub_client_sas_renewal_options){
+    .token_duration_seconds = _az_IOT_HUB_SAS_DEFAULT_TOKEN_DURATION_SECONDS,
+    .renewal_margin_seconds = _az_IOT_HUB_SAS_DEFAULT_RENEWAL_MARGIN_SECONDS,
+  };
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_sas_renewal_init(
+    az_iot_hub_client_sas_renewal* renewal,
+    az_iot_hub_client_sas_renewal_device* devices,
+    int32_t device_capacity,
+    az_span password_slab,
+    az_iot_hub_client_sas_renewal_options const* options)
+{
+  _az_PRECONDITION_NOT_NULL(renewal);
+  _az_PRECONDITION_NOT_NULL(devices);
+  _az_PRECONDITION(device_capacity > 0);
+  _az_PRECONDITION_VALID_SPAN(password_slab, device_capacity + 1, false);
+
+  *renewal = (az_iot_hub_client_sas_renewal){ 0 };
+  renewal->_internal.options
+      = options == NULL ? az_iot_hub_client_sas_renewal_options_default() : *options;
+
+  _az_PRECONDITION(renewal->_internal.options.token_duration_seconds > 0);
+  _az_PRECONDITION(
+      renewal->_internal.options.renewal_margin_seconds
+      < renewal->_internal.options.token_duration_seconds / 2);
+
+  renewal->_internal.devices = devices;
+  renewal->_internal.device_capacity = device_capacity;
+  renewal->_internal.password_slab = password_slab;
+  // The last slot is where new passwords are built.
+  renewal->_internal.password_capacity = az_span_size(password_slab) / (device_capacity + 1);
+
+  // The wheel spans one token lifetime, so a renewed token always lands less than one revolution
+  // ahead of the current tick.
+  renewal->_internal.tick_seconds = renewal->_internal.options.token_duration_seconds
+      / _az_IOT_HUB_CLIENT_SAS_RENEWAL_SLOT_COUNT;
+  if (renewal->_internal.tick_seconds == 0)
+  {
+    renewal->_internal.tick_seconds = 1;
+  }
+
+  for (int32_t i = 0; i < _az_IOT_HUB_CLIENT_SAS_RENEWAL_SLOT_COUNT; i++)
+  {
+    renewal->_internal.slots[i] = _az_IOT_HUB_SAS_NO_DEVICE;
+  }
+
+  return AZ_OK;
+}
+
+AZ_INLINE uint32_t _az_iot_hub_client_sas_renewal_due_tick(
+    az_iot_hub_client_sas_renewal const* renewal,
+    az_iot_hub_client_sas_renewal_device const* device)
+{
+  return (device->_internal.token_expiration_epoch_time
+          - renewal->_internal.options.renewal_margin_seconds)
+      / renewal->_internal.tick_seconds;
+}
+
+static void _az_iot_hub_client_sas_renewal_schedule(
+    az_iot_hub_client_sas_renewal* renewal,
+    int32_t device_index,
+    uint32_t due_tick)
+{
+  // A device due on a tick that was already processed goes in the next slot to be processed,
+  // rather than one revolution later.
+  if (due_tick <= renewal->_internal.processed_tick)
+  {
+    due_tick = renewal->_internal.processed_tick + 1;
+  }
+
+  int32_t* const slot
+      = &renewal->_internal.slots[due_tick % _az_IOT_HUB_CLIENT_SAS_RENEWAL_SLOT_COUNT];
+  renewal->_internal.devices[device_index]._internal.next = *slot;
+  *slot = device_index;
+}
+
+AZ_INLINE az_span _az_iot_hub_client_sas_renewal_password_slot(
+    az_iot_hub_client_sas_renewal const* renewal,
+    int32_t device_index)
+{
+  return az_span_slice(
+      renewal->_internal.password_slab,
+      device_index * renewal->_internal.password_capacity,
+      (device_index + 1) * renewal->_internal.password_capacity);
+}
+
+static az_result _az_iot_hub_client_sas_renewal_write_password(
+    az_iot_hub_client_sas_renewal* renewal,
+    int32_t device_index,
+    uint32_t token_expiration_epoch_time)
+{
+  az_iot_hub_client_sas_renewal_device* const device = &renewal->_internal.devices[device_index];
+
+  // The new password is built in the spare slot, so the current one stays valid until the new one
+  // is complete. The string to sign is a prefix of the password contents, so it goes there first.
+  az_span const scratch
+      = _az_iot_hub_client_sas_renewal_password_slot(renewal, renewal->_internal.device_capacity);
+  az_span string_to_sign;
+  AZ_RETURN_IF_FAILED(az_iot_hub_client_sas_get_signature(
+      device->_internal.client, token_expiration_epoch_time, scratch, &string_to_sign));
+
+  uint8_t hmac_buffer[_az_SHA256_HASH_SIZE];
+  az_span hmac;
+  AZ_RETURN_IF_FAILED(az_platform_hmac_sha256_sign(
+      _az_iot_hub_client_sas_renewal_hmac_key(device),
+      string_to_sign,
+      AZ_SPAN_FROM_BUFFER(hmac_buffer),
+      &hmac));
+
+  uint8_t base64_buffer[_az_IOT_HUB_SAS_BASE64_SIGNATURE_SIZE];
+  az_span remainder;
+  AZ_RETURN_IF_FAILED(az_span_base64_encode(AZ_SPAN_FROM_BUFFER(base64_buffer), hmac, &remainder));
+
+  uint8_t signature_buffer[_az_IOT_HUB_SAS_URL_ENCODED_SIGNATURE_SIZE];
+  int32_t signature_length;
+  AZ_RETURN_IF_FAILED(_az_span_url_encode(
+      AZ_SPAN_FROM_BUFFER(signature_buffer),
+      AZ_SPAN_FROM_BUFFER(base64_buffer),
+      &signature_length));
+
+  size_t password_length;
+  AZ_RETURN_IF_FAILED(az_iot_hub_client_sas_get_password(
+      device->_internal.client,
+      az_span_init(signature_buffer, signature_length),
+      token_expiration_epoch_time,
+      device->_internal.key_name,
+      (char*)az_span_ptr(scratch),
+      (size_t)az_span_size(scratch),
+      &password_length));
+
+  // Copy the null terminator as well.
+  az_span_copy(
+      _az_iot_hub_client_sas_renewal_password_slot(renewal, device_index),
+      az_span_slice(scratch, 0, (int32_t)password_length + 1));
+  device->_internal.password_length = (int32_t)password_length;
+  device->_internal.token_expiration_epoch_time = token_expiration_epoch_time;
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_sas_renewal_add_device(
+    az_iot_hub_client_sas_renewal* renewal,
+    az_iot_hub_client const* client,
+    az_span base64_device_key,
+    az_span key_name,
+    uint32_t current_epoch_time,
+    int32_t* out_device_index)
+{
+  _az_PRECONDITION_NOT_NULL(renewal);
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_VALID_SPAN(base64_device_key, 1, false);
+  _az_PRECONDITION(current_epoch_time > 0);
+
+  if (renewal->_internal.device_count == renewal->_internal.device_capacity)
+  {
+    return AZ_ERROR_INSUFFICIENT_SPAN_SIZE;
+  }
+
+  int32_t const device_index = renewal->_internal.device_count;
+  az_iot_hub_client_sas_renewal_device* const device = &renewal->_internal.devices[device_index];
+  *device = (az_iot_hub_client_sas_renewal_device){ 0 };
+  device->_internal.client = client;
+  device->_internal.key_name = key_name;
+
+  // Only the platform key is kept, so the decoded key is wiped as soon as it is set up.
+  uint8_t key_buffer[_az_IOT_HUB_SAS_DEVICE_KEY_MAX_SIZE];
+  az_span remainder;
+  az_result result
+      = az_span_base64_decode(AZ_SPAN_FROM_BUFFER(key_buffer), base64_device_key, &remainder);
+  if (az_succeeded(result))
+  {
+    result = az_platform_hmac_sha256_key_init(
+        _az_iot_hub_client_sas_renewal_hmac_key(device),
+        az_span_init(key_buffer, (int32_t)sizeof(key_buffer) - az_span_size(remainder)));
+  }
+  _az_crypto_wipe(key_buffer, sizeof(key_buffer));
+  AZ_RETURN_IF_FAILED(result);
+
+  if (renewal->_internal.device_count == 0)
+  {
+    renewal->_internal.processed_tick = current_epoch_time / renewal->_internal.tick_seconds;
+  }
+
+  // Spread the renewals of devices added together over the first half of the token lifetime.
+  uint32_t const stagger = (uint32_t)(device_index % _az_IOT_HUB_CLIENT_SAS_RENEWAL_SLOT_COUNT)
+      * renewal->_internal.tick_seconds / 2;
+  result = _az_iot_hub_client_sas_renewal_write_password(
+      renewal,
+      device_index,
+      current_epoch_time + renewal->_internal.options.token_duration_seconds - stagger);
+  if (az_failed(result))
+  {
+    // The device isn't added, so its key must not be left behind.
+    az_platform_hmac_sha256_key_destroy(_az_iot_hub_client_sas_renewal_hmac_key(device));
+    return result;
+  }
+
+  renewal->_internal.device_count++;
+  _az_iot_hub_client_sas_renewal_schedule(
+      renewal, device_index, _az_iot_hub_client_sas_renewal_due_tick(renewal, device));
+
+  if (out_device_index != NULL)
+  {
+    *out_device_index = device_index;
+  }
+
+  return AZ_OK;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_sas_renewal_tick(
+    az_iot_hub_client_sas_renewal* renewal,
+    uint32_t current_epoch_time,
+    int32_t* out_renewed_count)
+{
+  _az_PRECONDITION_NOT_NULL(renewal);
+  _az_PRECONDITION(current_epoch_time > 0);
+
+  az_result result = AZ_OK;
+  int32_t renewed_count = 0;
+  uint32_t const current_tick = current_epoch_time / renewal->_internal.tick_seconds;
+  uint32_t const new_token_expiration
+      = current_epoch_time + renewal->_internal.options.token_duration_seconds;
+
+  // Visiting more than one revolution of the wheel would only go through the same slots again.
+  uint32_t tick = renewal->_internal.processed_tick;
+  if (current_tick > tick && current_tick - tick > _az_IOT_HUB_CLIENT_SAS_RENEWAL_SLOT_COUNT)
+  {
+    tick = current_tick - _az_IOT_HUB_CLIENT_SAS_RENEWAL_SLOT_COUNT;
+  }
+
+  while (tick < current_tick && renewal->_internal.device_count > 0)
+  {
+    tick++;
+    int32_t* const slot
+        = &renewal->_internal.slots[tick % _az_IOT_HUB_CLIENT_SAS_RENEWAL_SLOT_COUNT];
+    int32_t device_index = *slot;
+    *slot = _az_IOT_HUB_SAS_NO_DEVICE;
+
+    while (device_index != _az_IOT_HUB_SAS_NO_DEVICE)
+    {
+      az_iot_hub_client_sas_renewal_device* const device
+          = &renewal->_internal.devices[device_index];
+      int32_t const next = device->_internal.next;
+      uint32_t due_tick = _az_iot_hub_client_sas_renewal_due_tick(renewal, device);
+
+      if (due_tick <= current_tick)
+      {
+        az_result const write_result = _az_iot_hub_client_sas_renewal_write_password(
+            renewal, device_index, new_token_expiration);
+        if (az_succeeded(write_result))
+        {
+          renewed_count++;
+          due_tick = _az_iot_hub_client_sas_renewal_due_tick(renewal, device);
+        }
+        else
+        {
+          // Retry on the next tick.
+          result = write_result;
+          due_tick = current_tick + 1;
+        }
+      }
+
+      // Devices that are not due yet are more than one revolution ahead, and stay in this slot.
+      renewal->_internal.processed_tick = tick;
+      _az_iot_hub_client_sas_renewal_schedule(renewal, device_index, due_tick);
+      device_index = next;
+    }
+  }
+
+  if (current_tick > renewal->_internal.processed_tick)
+  {
+    renewal->_internal.processed_tick = current_tick;
+  }
+
+  if (out_renewed_count != NULL)
+  {
+    *out_renewed_count = renewed_count;
+  }
+
+  return result;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_sas_renewal_get_password(
+    az_iot_hub_client_sas_renewal const* renewal,
+    int32_t device_index,
+    az_span* out_mqtt_password,
+    uint32_t* out_token_expiration_epoch_time)
+{
+  _az_PRECONDITION_NOT_NULL(renewal);
+  _az_PRECONDITION_RANGE(0, device_index, renewal->_internal.device_count - 1);
+  _az_PRECONDITION_NOT_NULL(out_mqtt_password);
+
+  az_iot_hub_client_sas_renewal_device const* const device
+      = &renewal->_internal.devices[device_index];
+
+  *out_mqtt_password = az_span_slice(
+      _az_iot_hub_client_sas_renewal_password_slot(renewal, device_index),
+      0,
+      device->_internal.password_length);
+
+  if (out_token_expiration_epoch_time != NULL)
+  {
+    *out_token_expiration_epoch_time = device->_internal.token_expiration_epoch_time;
+  }
+
+  return AZ_OK;
+}
+
+void az_iot_hub_client_sas_renewal_deinit(az_iot_hub_client_sas_renewal* renewal)
+{
+  _az_PRECONDITION_NOT_NULL(renewal);
+
+  for (int32_t i = 0; i < renewal->_internal.device_count; i++)
+  {
+    az_platform_hmac_sha256_key_destroy(
+        _az_iot_hub_client_sas_renewal_hmac_key(&renewal->_internal.devices[i]));
+  }
+
+  _az_crypto_wipe(
+      renewal->_internal.devices,
+      (size_t)renewal->_internal.device_capacity * sizeof(renewal->_internal.devices[0]));
+  _az_crypto_wipe(
+      az_span_ptr(renewal->_internal.password_slab),
+      (size_t)az_span_size(renewal->_internal.password_slab));
+  _az_crypto_wipe(renewal, sizeof(*renewal));
+}
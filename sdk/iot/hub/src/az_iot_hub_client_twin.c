@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include "az_iot_hub_client.h"
+#include <az_json.h>
 #include <az_precondition.h>
 #include <az_result.h>
 #include <az_span.h>
@@ -268,3 +269,207 @@ AZ_NODISCARD az_result az_iot_hub_client_twin_parse_received_topic(
 
   return result;
 }
+
+typedef struct
+{
+  az_span name;
+  az_json_token_kind kind;
+  az_span value;
+} _az_iot_hub_twin_member;
+
+AZ_NODISCARD AZ_INLINE bool _az_iot_hub_twin_is_separator(uint8_t c)
+{
+  return c == ':' || c == ',' || c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Reads the next member of the object being parsed, skipping over its children, and returns its
+// name along with the raw JSON text of its value as it appears in the document.
+AZ_NODISCARD static az_result _az_iot_hub_twin_next_member(
+    az_json_parser* json_parser,
+    _az_iot_hub_twin_member* out_member)
+{
+  az_json_token_member member;
+  AZ_RETURN_IF_FAILED(az_json_parser_parse_token_member(json_parser, &member));
+  AZ_RETURN_IF_FAILED(az_json_parser_skip_children(json_parser, member.token));
+
+  // The value starts after the name's closing quote and the ':' separator, and ends before the
+  // ',' separating it from the next member (if any). JSON values never start or end with either.
+  uint8_t* value_start = az_span_ptr(member.name) + az_span_size(member.name) + 1;
+  uint8_t* value_end = az_span_ptr(json_parser->_internal.reader);
+
+  while (value_start < value_end && _az_iot_hub_twin_is_separator(*value_start))
+  {
+    value_start++;
+  }
+  while (value_end > value_start && _az_iot_hub_twin_is_separator(value_end[-1]))
+  {
+    value_end--;
+  }
+
+  out_member->name = member.name;
+  out_member->kind = member.token.kind;
+  out_member->value = az_span_init(value_start, (int32_t)(value_end - value_start));
+  return AZ_OK;
+}
+
+// Looks up the member called `name` in an object. The search resumes from `cursor`, which is left
+// right after the member found: members usually keep their order across revisions of a document,
+// so walking both documents side by side finds each of them in a single forward pass. When that
+// fails, the search wraps around to `object_start` and stops once it is back at `cursor`.
+AZ_NODISCARD static az_result _az_iot_hub_twin_find_member(
+    az_json_parser* cursor,
+    az_json_parser const* object_start,
+    az_span name,
+    _az_iot_hub_twin_member* out_member)
+{
+  az_json_parser json_parser = *cursor;
+  for (int32_t pass = 0; pass < 2; pass++)
+  {
+    while (pass == 0
+               ? az_json_parser_done(&json_parser) != AZ_OK
+               : az_span_ptr(json_parser._internal.reader) != az_span_ptr(cursor->_internal.reader))
+    {
+      az_result const result = _az_iot_hub_twin_next_member(&json_parser, out_member);
+      if (result == AZ_ERROR_ITEM_NOT_FOUND)
+      {
+        break;
+      }
+      AZ_RETURN_IF_FAILED(result);
+
+      if (az_span_is_content_equal(out_member->name, name))
+      {
+        *cursor = json_parser;
+        return AZ_OK;
+      }
+    }
+    json_parser = *object_start;
+  }
+
+  return AZ_ERROR_ITEM_NOT_FOUND;
+}
+
+AZ_NODISCARD static az_result _az_iot_hub_twin_begin_object(
+    az_span json_object,
+    az_json_parser* out_json_parser)
+{
+  az_json_token token;
+  AZ_RETURN_IF_FAILED(az_json_parser_init(out_json_parser, json_object));
+  AZ_RETURN_IF_FAILED(az_json_parser_parse_token(out_json_parser, &token));
+  return token.kind == AZ_JSON_TOKEN_OBJECT_START ? AZ_OK : AZ_ERROR_PARSER_UNEXPECTED_CHAR;
+}
+
+// Appends the members of the JSON merge patch (RFC 7396) turning `previous` into `current`.
+AZ_NODISCARD static az_result _az_iot_hub_twin_append_diff(
+    az_json_builder* json_builder,
+    az_span previous,
+    az_span current)
+{
+  az_json_parser previous_start;
+  az_json_parser current_start;
+  AZ_RETURN_IF_FAILED(_az_iot_hub_twin_begin_object(previous, &previous_start));
+  AZ_RETURN_IF_FAILED(_az_iot_hub_twin_begin_object(current, &current_start));
+
+  _az_iot_hub_twin_member previous_member;
+  _az_iot_hub_twin_member current_member;
+  az_result result;
+
+  // Added or changed members.
+  az_json_parser current_parser = current_start;
+  az_json_parser previous_cursor = previous_start;
+  while ((result = _az_iot_hub_twin_next_member(&current_parser, &current_member)) == AZ_OK)
+  {
+    result = _az_iot_hub_twin_find_member(
+        &previous_cursor, &previous_start, current_member.name, &previous_member);
+    if (result != AZ_ERROR_ITEM_NOT_FOUND)
+    {
+      AZ_RETURN_IF_FAILED(result);
+
+      if (az_span_is_content_equal(previous_member.value, current_member.value))
+      {
+        continue;
+      }
+
+      if (previous_member.kind == AZ_JSON_TOKEN_OBJECT_START
+          && current_member.kind == AZ_JSON_TOKEN_OBJECT_START)
+      {
+        // Both are objects: only send the members of the nested object that changed, and nothing
+        // at all when they differ only by white space.
+        az_json_builder const checkpoint = *json_builder;
+        AZ_RETURN_IF_FAILED(az_json_builder_append_object(
+            json_builder, current_member.name, az_json_token_object_start()));
+        int32_t const nested_start = az_span_size(az_json_builder_span_get(json_builder));
+        AZ_RETURN_IF_FAILED(_az_iot_hub_twin_append_diff(
+            json_builder, previous_member.value, current_member.value));
+
+        if (az_span_size(az_json_builder_span_get(json_builder)) == nested_start)
+        {
+          *json_builder = checkpoint;
+        }
+        else
+        {
+          AZ_RETURN_IF_FAILED(
+              az_json_builder_append_token(json_builder, az_json_token_object_end()));
+        }
+        continue;
+      }
+    }
+
+    // Scalars and arrays are replaced as a whole.
+    AZ_RETURN_IF_FAILED(az_json_builder_append_object(
+        json_builder, current_member.name, az_json_token_object(current_member.value)));
+  }
+  if (result != AZ_ERROR_ITEM_NOT_FOUND)
+  {
+    return result;
+  }
+
+  // Removed members.
+  az_json_parser previous_parser = previous_start;
+  az_json_parser current_cursor = current_start;
+  while ((result = _az_iot_hub_twin_next_member(&previous_parser, &previous_member)) == AZ_OK)
+  {
+    result = _az_iot_hub_twin_find_member(
+        &current_cursor, &current_start, previous_member.name, &current_member);
+    if (result == AZ_ERROR_ITEM_NOT_FOUND)
+    {
+      AZ_RETURN_IF_FAILED(az_json_builder_append_object(
+          json_builder, previous_member.name, az_json_token_null()));
+    }
+    else
+    {
+      AZ_RETURN_IF_FAILED(result);
+    }
+  }
+
+  return result == AZ_ERROR_ITEM_NOT_FOUND ? AZ_OK : result;
+}
+
+AZ_NODISCARD az_result az_iot_hub_client_twin_patch_get_reported_diff(
+    az_iot_hub_client const* client,
+    az_span previous_reported,
+    az_span current_reported,
+    az_span patch,
+    az_span* out_patch)
+{
+  _az_PRECONDITION_NOT_NULL(client);
+  _az_PRECONDITION_VALID_SPAN(previous_reported, 0, true);
+  _az_PRECONDITION_VALID_SPAN(current_reported, 1, false);
+  _az_PRECONDITION_VALID_SPAN(patch, 1, false);
+  _az_PRECONDITION_NOT_NULL(out_patch);
+  (void)client;
+
+  if (az_span_size(previous_reported) == 0)
+  {
+    previous_reported = AZ_SPAN_FROM_STR("{}");
+  }
+
+  az_json_builder json_builder;
+  AZ_RETURN_IF_FAILED(az_json_builder_init(&json_builder, patch));
+  AZ_RETURN_IF_FAILED(az_json_builder_append_token(&json_builder, az_json_token_object_start()));
+  AZ_RETURN_IF_FAILED(
+      _az_iot_hub_twin_append_diff(&json_builder, previous_reported, current_reported));
+  AZ_RETURN_IF_FAILED(az_json_builder_append_token(&json_builder, az_json_token_object_end()));
+
+  *out_patch = az_json_builder_span_get(&json_builder);
+  return AZ_OK;
+}
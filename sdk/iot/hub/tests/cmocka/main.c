@@ -18,6 +18,7 @@ int main()
   result += test_iot_hub_c2d();
   result += test_iot_hub_client();
   result += test_iot_sas_token();
+  result += test_iot_sas_renewal();
   result += test_iot_hub_telemetry();
   result += test_az_iot_hub_client_twin();
   result += test_iot_hub_methods();
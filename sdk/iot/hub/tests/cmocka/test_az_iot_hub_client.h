@@ -3,6 +3,7 @@
 
 int test_iot_hub_c2d();
 int test_iot_sas_token();
+int test_iot_sas_renewal();
 int test_iot_hub_telemetry();
 int test_iot_hub_client();
 int test_az_iot_hub_client_twin();
@@ -0,0 +1,359 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: MIT
+
+#include "test_az_iot_hub_client.h"
+#include <az_iot_hub_client.h>
+#include <az_precondition.h>
+#include <az_span.h>
+
+#include <az_precondition_internal.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <az_test_precondition.h>
+#include <cmocka.h>
+
+#define TEST_DEVICE_COUNT 100
+#define TEST_PASSWORD_SLOT_SIZE 200
+#define TEST_DEVICE_ID_STR "my_device"
+#define TEST_MODULE_ID_STR "my_module"
+#define TEST_DEVICE_HOSTNAME_STR "myiothub.azure-devices.net"
+#define TEST_KEY_NAME "iothubowner"
+// Base64 of "0123456789abcdef0123456789abcdef".
+#define TEST_DEVICE_KEY "MDEyMzQ1Njc4OWFiY2RlZjAxMjM0NTY3ODlhYmNkZWY="
+
+static const az_span test_device_hostname = AZ_SPAN_LITERAL_FROM_STR(TEST_DEVICE_HOSTNAME_STR);
+static const az_span test_device_id = AZ_SPAN_LITERAL_FROM_STR(TEST_DEVICE_ID_STR);
+static const az_span test_device_key = AZ_SPAN_LITERAL_FROM_STR(TEST_DEVICE_KEY);
+static const uint32_t test_current_time_secs = 1578941692;
+
+static az_iot_hub_client_sas_renewal_device test_devices[TEST_DEVICE_COUNT];
+static uint8_t test_password_slab[TEST_DEVICE_COUNT * TEST_PASSWORD_SLOT_SIZE];
+
+#ifndef AZ_NO_PRECONDITION_CHECKING
+enable_precondition_check_tests()
+
+static void test_az_iot_hub_client_sas_renewal_init_NULL_devices_fails()
+{
+  az_iot_hub_client_sas_renewal renewal;
+  az_span const password_slab = AZ_SPAN_FROM_BUFFER(test_password_slab);
+
+  assert_precondition_checked(
+      az_iot_hub_client_sas_renewal_init(&renewal, NULL, TEST_DEVICE_COUNT, password_slab, NULL));
+}
+
+static void test_az_iot_hub_client_sas_renewal_init_invalid_margin_fails()
+{
+  az_iot_hub_client_sas_renewal renewal;
+  az_iot_hub_client_sas_renewal_options options = az_iot_hub_client_sas_renewal_options_default();
+  options.renewal_margin_seconds = options.token_duration_seconds / 2;
+  az_span const password_slab = AZ_SPAN_FROM_BUFFER(test_password_slab);
+
+  assert_precondition_checked(az_iot_hub_client_sas_renewal_init(
+      &renewal, test_devices, TEST_DEVICE_COUNT, password_slab, &options));
+}
+
+#endif // AZ_NO_PRECONDITION_CHECKING
+
+static void test_az_iot_hub_client_sas_renewal_add_device_succeeds()
+{
+  az_iot_hub_client client;
+  assert_return_code(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  az_iot_hub_client_sas_renewal renewal;
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_init(
+          &renewal,
+          test_devices,
+          TEST_DEVICE_COUNT,
+          AZ_SPAN_FROM_BUFFER(test_password_slab),
+          NULL),
+      AZ_OK);
+
+  int32_t device_index = -1;
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_add_device(
+          &renewal, &client, test_device_key, AZ_SPAN_NULL, test_current_time_secs, &device_index),
+      AZ_OK);
+  assert_int_equal(device_index, 0);
+
+  az_span password;
+  uint32_t expiration;
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_get_password(&renewal, device_index, &password, &expiration),
+      AZ_OK);
+  assert_int_equal(expiration, test_current_time_secs + 3600);
+  assert_true(az_span_is_content_equal(
+      password,
+      AZ_SPAN_FROM_STR("SharedAccessSignature sr=" TEST_DEVICE_HOSTNAME_STR
+                       "/devices/" TEST_DEVICE_ID_STR
+                       "&sig=9FY5kTk8XdwyTPSMiuywKRUlQp8xblHJgWsOXjl1KyI%3D&se=1578945292")));
+  assert_int_equal(az_span_ptr(password)[az_span_size(password)], '\0');
+}
+
+static void test_az_iot_hub_client_sas_renewal_add_device_module_with_keyname_succeeds()
+{
+  az_iot_hub_client_options options = az_iot_hub_client_options_default();
+  options.module_id = AZ_SPAN_FROM_STR(TEST_MODULE_ID_STR);
+  az_iot_hub_client client;
+  assert_return_code(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, &options), AZ_OK);
+
+  az_iot_hub_client_sas_renewal renewal;
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_init(
+          &renewal,
+          test_devices,
+          TEST_DEVICE_COUNT,
+          AZ_SPAN_FROM_BUFFER(test_password_slab),
+          NULL),
+      AZ_OK);
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_add_device(
+          &renewal,
+          &client,
+          test_device_key,
+          AZ_SPAN_FROM_STR(TEST_KEY_NAME),
+          test_current_time_secs,
+          NULL),
+      AZ_OK);
+
+  az_span password;
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_get_password(&renewal, 0, &password, NULL), AZ_OK);
+  assert_true(az_span_is_content_equal(
+      password,
+      AZ_SPAN_FROM_STR("SharedAccessSignature sr=" TEST_DEVICE_HOSTNAME_STR
+                       "/devices/" TEST_DEVICE_ID_STR "/modules/" TEST_MODULE_ID_STR
+                       "&sig=czLCTiGwh4XMJBy%2BFIMgc%2FVwnjB%2F%2FTFTjIkJ78d0UpU%3D"
+                       "&se=1578945292&skn=" TEST_KEY_NAME)));
+}
+
+static void test_az_iot_hub_client_sas_renewal_add_device_fails()
+{
+  az_iot_hub_client client;
+  assert_return_code(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  az_iot_hub_client_sas_renewal renewal;
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_init(
+          &renewal, test_devices, 1, az_span_init(test_password_slab, 50), NULL),
+      AZ_OK);
+
+  assert_int_equal(
+      az_iot_hub_client_sas_renewal_add_device(
+          &renewal, &client, AZ_SPAN_FROM_STR("MDEy*"), AZ_SPAN_NULL, test_current_time_secs, NULL),
+      AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+
+  // The password does not fit in 50 bytes.
+  assert_int_equal(
+      az_iot_hub_client_sas_renewal_add_device(
+          &renewal, &client, test_device_key, AZ_SPAN_NULL, test_current_time_secs, NULL),
+      AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_init(
+          &renewal, test_devices, 1, AZ_SPAN_FROM_BUFFER(test_password_slab), NULL),
+      AZ_OK);
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_add_device(
+          &renewal, &client, test_device_key, AZ_SPAN_NULL, test_current_time_secs, NULL),
+      AZ_OK);
+  assert_int_equal(
+      az_iot_hub_client_sas_renewal_add_device(
+          &renewal, &client, test_device_key, AZ_SPAN_NULL, test_current_time_secs, NULL),
+      AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+}
+
+static void test_az_iot_hub_client_sas_renewal_tick_failure_keeps_password_succeeds()
+{
+  az_iot_hub_client client;
+  assert_return_code(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  // One slot for the device, and one where its new passwords are built.
+  az_iot_hub_client_sas_renewal renewal;
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_init(
+          &renewal, test_devices, 1, az_span_init(test_password_slab, 2 * 150), NULL),
+      AZ_OK);
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_add_device(
+          &renewal, &client, test_device_key, AZ_SPAN_NULL, test_current_time_secs, NULL),
+      AZ_OK);
+
+  az_span password;
+  uint32_t expiration;
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_get_password(&renewal, 0, &password, &expiration), AZ_OK);
+  uint8_t password_copy[150];
+  az_span_copy(AZ_SPAN_FROM_BUFFER(password_copy), password);
+  az_span const expected_password = az_span_init(password_copy, az_span_size(password));
+
+  // The next password no longer fits in the slot.
+  assert_return_code(
+      az_iot_hub_client_init(
+          &client,
+          test_device_hostname,
+          AZ_SPAN_FROM_STR(TEST_DEVICE_ID_STR "_with_a_much_longer_name_than_before"),
+          NULL),
+      AZ_OK);
+  int32_t renewed_count = -1;
+  assert_int_equal(
+      az_iot_hub_client_sas_renewal_tick(&renewal, test_current_time_secs + 3400, &renewed_count),
+      AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+  assert_int_equal(renewed_count, 0);
+
+  uint32_t current_expiration;
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_get_password(&renewal, 0, &password, &current_expiration),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(password, expected_password));
+  assert_int_equal(az_span_ptr(password)[az_span_size(password)], '\0');
+  assert_int_equal(current_expiration, expiration);
+}
+
+static void test_az_iot_hub_client_sas_renewal_deinit_wipes_keys_succeeds()
+{
+  az_iot_hub_client client;
+  assert_return_code(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  az_iot_hub_client_sas_renewal renewal;
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_init(
+          &renewal, test_devices, 2, az_span_init(test_password_slab, 3 * 150), NULL),
+      AZ_OK);
+  for (int32_t i = 0; i < 2; i++)
+  {
+    assert_return_code(
+        az_iot_hub_client_sas_renewal_add_device(
+            &renewal, &client, test_device_key, AZ_SPAN_NULL, test_current_time_secs, NULL),
+        AZ_OK);
+  }
+
+  az_iot_hub_client_sas_renewal_deinit(&renewal);
+
+  uint8_t const* const devices = (uint8_t const*)test_devices;
+  for (size_t i = 0; i < 2 * sizeof(test_devices[0]); i++)
+  {
+    assert_int_equal(devices[i], 0);
+  }
+  for (size_t i = 0; i < 3 * 150; i++)
+  {
+    assert_int_equal(test_password_slab[i], 0);
+  }
+}
+
+static void _add_test_devices(az_iot_hub_client_sas_renewal* renewal, az_iot_hub_client* client)
+{
+  assert_return_code(
+      az_iot_hub_client_init(client, test_device_hostname, test_device_id, NULL), AZ_OK);
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_init(
+          renewal,
+          test_devices,
+          TEST_DEVICE_COUNT,
+          AZ_SPAN_FROM_BUFFER(test_password_slab),
+          NULL),
+      AZ_OK);
+
+  for (int32_t i = 0; i < TEST_DEVICE_COUNT; i++)
+  {
+    assert_return_code(
+        az_iot_hub_client_sas_renewal_add_device(
+            renewal, client, test_device_key, AZ_SPAN_NULL, test_current_time_secs, NULL),
+        AZ_OK);
+  }
+}
+
+static void test_az_iot_hub_client_sas_renewal_tick_renews_due_devices_succeeds()
+{
+  az_iot_hub_client client;
+  az_iot_hub_client_sas_renewal renewal;
+  _add_test_devices(&renewal, &client);
+
+  int32_t total_renewed_count = 0;
+  int32_t max_renewed_count = 0;
+
+  // Tick every 10 seconds for three hours.
+  for (uint32_t now = test_current_time_secs; now < test_current_time_secs + (3 * 3600);
+       now += 10)
+  {
+    int32_t renewed_count = -1;
+    assert_return_code(az_iot_hub_client_sas_renewal_tick(&renewal, now, &renewed_count), AZ_OK);
+    total_renewed_count += renewed_count;
+    max_renewed_count = renewed_count > max_renewed_count ? renewed_count : max_renewed_count;
+
+    for (int32_t i = 0; i < TEST_DEVICE_COUNT; i++)
+    {
+      az_span password;
+      uint32_t expiration;
+      assert_return_code(
+          az_iot_hub_client_sas_renewal_get_password(&renewal, i, &password, &expiration), AZ_OK);
+
+      // No token is left to expire within the renewal margin.
+      assert_true(expiration > now + 300);
+      assert_true(az_span_size(password) > 0);
+    }
+  }
+
+  // The renewals are spread over time rather than all happening at once.
+  assert_true(max_renewed_count < TEST_DEVICE_COUNT / 10);
+  assert_true(total_renewed_count >= 2 * TEST_DEVICE_COUNT);
+  assert_true(total_renewed_count <= 4 * TEST_DEVICE_COUNT);
+}
+
+static void test_az_iot_hub_client_sas_renewal_tick_after_long_pause_succeeds()
+{
+  az_iot_hub_client client;
+  az_iot_hub_client_sas_renewal renewal;
+  _add_test_devices(&renewal, &client);
+
+  uint32_t const now = test_current_time_secs + (5 * 3600);
+  int32_t renewed_count = -1;
+  assert_return_code(az_iot_hub_client_sas_renewal_tick(&renewal, now, &renewed_count), AZ_OK);
+  assert_int_equal(renewed_count, TEST_DEVICE_COUNT);
+
+  for (int32_t i = 0; i < TEST_DEVICE_COUNT; i++)
+  {
+    az_span password;
+    uint32_t expiration;
+    assert_return_code(
+        az_iot_hub_client_sas_renewal_get_password(&renewal, i, &password, &expiration), AZ_OK);
+    assert_int_equal(expiration, now + 3600);
+  }
+
+  // Nothing is due right after.
+  assert_return_code(
+      az_iot_hub_client_sas_renewal_tick(&renewal, now + 60, &renewed_count), AZ_OK);
+  assert_int_equal(renewed_count, 0);
+}
+
+int test_iot_sas_renewal()
+{
+#ifndef AZ_NO_PRECONDITION_CHECKING
+  setup_precondition_check_tests();
+#endif // AZ_NO_PRECONDITION_CHECKING
+
+  const struct CMUnitTest tests[] = {
+#ifndef AZ_NO_PRECONDITION_CHECKING
+    cmocka_unit_test(test_az_iot_hub_client_sas_renewal_init_NULL_devices_fails),
+    cmocka_unit_test(test_az_iot_hub_client_sas_renewal_init_invalid_margin_fails),
+#endif // AZ_NO_PRECONDITION_CHECKING
+    cmocka_unit_test(test_az_iot_hub_client_sas_renewal_add_device_succeeds),
+    cmocka_unit_test(test_az_iot_hub_client_sas_renewal_add_device_module_with_keyname_succeeds),
+    cmocka_unit_test(test_az_iot_hub_client_sas_renewal_add_device_fails),
+    cmocka_unit_test(test_az_iot_hub_client_sas_renewal_tick_renews_due_devices_succeeds),
+    cmocka_unit_test(test_az_iot_hub_client_sas_renewal_tick_after_long_pause_succeeds),
+    cmocka_unit_test(test_az_iot_hub_client_sas_renewal_tick_failure_keeps_password_succeeds),
+    cmocka_unit_test(test_az_iot_hub_client_sas_renewal_deinit_wipes_keys_succeeds),
+  };
+
+  return cmocka_run_group_tests_name("az_iot_hub_client_sas_renewal", tests, NULL, NULL);
+}
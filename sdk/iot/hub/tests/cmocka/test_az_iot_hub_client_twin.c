@@ -42,6 +42,15 @@ static const char test_correct_twin_path_subscribe_topic[]
 static const char test_correct_twin_patch_pub_topic[]
     = "$iothub/twin/PATCH/properties/reported/?$rid=id_one";
 
+static const az_span test_twin_reported_previous = AZ_SPAN_LITERAL_FROM_STR(
+    "{\"fw\":\"1.0\",\"temp\":21.5,\"tags\":[1,2],"
+    "\"net\":{\"ip\":\"10.0.0.2\",\"rssi\":-60},\"old\":true}");
+static const az_span test_twin_reported_current = AZ_SPAN_LITERAL_FROM_STR(
+    "{\"fw\":\"1.0\",\"temp\":22,\"tags\":[1,2,3],"
+    "\"net\":{\"ip\":\"10.0.0.2\",\"rssi\":-58},\"new\":null}");
+static const az_span test_twin_reported_patch = AZ_SPAN_LITERAL_FROM_STR(
+    "{\"temp\":22,\"tags\":[1,2,3],\"net\":{\"rssi\":-58},\"new\":null,\"old\":null}");
+
 #ifndef AZ_NO_PRECONDITION_CHECKING
 enable_precondition_check_tests()
 
@@ -252,6 +261,29 @@ static void test_az_iot_hub_client_twin_parse_received_topic_NULL_response_fails
       &client, test_twin_received_topic_desired_success, NULL));
 }
 
+static void test_az_iot_hub_client_twin_patch_get_reported_diff_NULL_client_fails()
+{
+  uint8_t test_buf[TEST_SPAN_BUFFER_SIZE];
+  az_span test_span = AZ_SPAN_FROM_BUFFER(test_buf);
+  az_span test_patch;
+
+  assert_precondition_checked(az_iot_hub_client_twin_patch_get_reported_diff(
+      NULL, test_twin_reported_previous, test_twin_reported_current, test_span, &test_patch));
+}
+
+static void test_az_iot_hub_client_twin_patch_get_reported_diff_NULL_out_patch_fails()
+{
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  uint8_t test_buf[TEST_SPAN_BUFFER_SIZE];
+  az_span test_span = AZ_SPAN_FROM_BUFFER(test_buf);
+
+  assert_precondition_checked(az_iot_hub_client_twin_patch_get_reported_diff(
+      &client, test_twin_reported_previous, test_twin_reported_current, test_span, NULL));
+}
+
 #endif // AZ_NO_PRECONDITION_CHECKING
 
 static void test_az_iot_hub_client_twin_response_get_subscribe_topic_filter_succeed()
@@ -383,6 +415,126 @@ static void test_az_iot_hub_client_twin_patch_get_publish_topic_small_buffer_fai
       AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
 }
 
+static void test_az_iot_hub_client_twin_patch_get_reported_diff_succeed()
+{
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  uint8_t test_buf[TEST_SPAN_BUFFER_SIZE];
+  az_span test_patch;
+
+  assert_int_equal(
+      az_iot_hub_client_twin_patch_get_reported_diff(
+          &client,
+          test_twin_reported_previous,
+          test_twin_reported_current,
+          AZ_SPAN_FROM_BUFFER(test_buf),
+          &test_patch),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(test_patch, test_twin_reported_patch));
+}
+
+static void test_az_iot_hub_client_twin_patch_get_reported_diff_unchanged_succeed()
+{
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  uint8_t test_buf[TEST_SPAN_BUFFER_SIZE];
+  az_span test_patch;
+
+  // Same members in a different order and with different white space.
+  assert_int_equal(
+      az_iot_hub_client_twin_patch_get_reported_diff(
+          &client,
+          AZ_SPAN_FROM_STR("{\"a\":1,\"b\":{\"c\":[true],\"d\":\"x\"}}"),
+          AZ_SPAN_FROM_STR(" { \"b\" : { \"d\" : \"x\" , \"c\":[true] } , \"a\" : 1 }\n"),
+          AZ_SPAN_FROM_BUFFER(test_buf),
+          &test_patch),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(test_patch, AZ_SPAN_FROM_STR("{}")));
+}
+
+static void test_az_iot_hub_client_twin_patch_get_reported_diff_no_previous_succeed()
+{
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  uint8_t test_buf[TEST_SPAN_BUFFER_SIZE];
+  az_span test_patch;
+
+  assert_int_equal(
+      az_iot_hub_client_twin_patch_get_reported_diff(
+          &client,
+          AZ_SPAN_NULL,
+          AZ_SPAN_FROM_STR("{\"a\": {\"b\": 1} }"),
+          AZ_SPAN_FROM_BUFFER(test_buf),
+          &test_patch),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(test_patch, AZ_SPAN_FROM_STR("{\"a\":{\"b\": 1}}")));
+}
+
+static void test_az_iot_hub_client_twin_patch_get_reported_diff_type_change_succeed()
+{
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  uint8_t test_buf[TEST_SPAN_BUFFER_SIZE];
+  az_span test_patch;
+
+  assert_int_equal(
+      az_iot_hub_client_twin_patch_get_reported_diff(
+          &client,
+          AZ_SPAN_FROM_STR("{\"a\":{\"b\":1},\"c\":{\"d\":{\"e\":1}}}"),
+          AZ_SPAN_FROM_STR("{\"a\":5,\"c\":{\"d\":{}}}"),
+          AZ_SPAN_FROM_BUFFER(test_buf),
+          &test_patch),
+      AZ_OK);
+  assert_true(az_span_is_content_equal(
+      test_patch, AZ_SPAN_FROM_STR("{\"a\":5,\"c\":{\"d\":{\"e\":null}}}")));
+}
+
+static void test_az_iot_hub_client_twin_patch_get_reported_diff_small_buffer_fails()
+{
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  uint8_t test_buf[20];
+  az_span test_patch;
+
+  assert_int_equal(
+      az_iot_hub_client_twin_patch_get_reported_diff(
+          &client,
+          test_twin_reported_previous,
+          test_twin_reported_current,
+          AZ_SPAN_FROM_BUFFER(test_buf),
+          &test_patch),
+      AZ_ERROR_INSUFFICIENT_SPAN_SIZE);
+}
+
+static void test_az_iot_hub_client_twin_patch_get_reported_diff_not_object_fails()
+{
+  az_iot_hub_client client;
+  assert_int_equal(
+      az_iot_hub_client_init(&client, test_device_hostname, test_device_id, NULL), AZ_OK);
+
+  uint8_t test_buf[TEST_SPAN_BUFFER_SIZE];
+  az_span test_patch;
+
+  assert_int_equal(
+      az_iot_hub_client_twin_patch_get_reported_diff(
+          &client,
+          test_twin_reported_previous,
+          AZ_SPAN_FROM_STR("[1,2]"),
+          AZ_SPAN_FROM_BUFFER(test_buf),
+          &test_patch),
+      AZ_ERROR_PARSER_UNEXPECTED_CHAR);
+}
+
 static void test_az_iot_hub_client_twin_parse_received_topic_desired_found_succeed()
 {
   az_iot_hub_client client;
@@ -538,6 +690,8 @@ int test_az_iot_hub_client_twin()
     cmocka_unit_test(test_az_iot_hub_client_twin_parse_received_topic_NULL_client_fails),
     cmocka_unit_test(test_az_iot_hub_client_twin_parse_received_topic_NULL_rec_topic_fails),
     cmocka_unit_test(test_az_iot_hub_client_twin_parse_received_topic_NULL_response_fails),
+    cmocka_unit_test(test_az_iot_hub_client_twin_patch_get_reported_diff_NULL_client_fails),
+    cmocka_unit_test(test_az_iot_hub_client_twin_patch_get_reported_diff_NULL_out_patch_fails),
 #endif // AZ_NO_PRECONDITION_CHECKING
     cmocka_unit_test(test_az_iot_hub_client_twin_response_get_subscribe_topic_filter_succeed),
     cmocka_unit_test(
@@ -549,6 +703,12 @@ int test_az_iot_hub_client_twin()
         test_az_iot_hub_client_twin_patch_get_subscribe_topic_filter_small_buffer_fails),
     cmocka_unit_test(test_az_iot_hub_client_twin_patch_get_publish_topic_succeed),
     cmocka_unit_test(test_az_iot_hub_client_twin_patch_get_publish_topic_small_buffer_fails),
+    cmocka_unit_test(test_az_iot_hub_client_twin_patch_get_reported_diff_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_twin_patch_get_reported_diff_unchanged_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_twin_patch_get_reported_diff_no_previous_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_twin_patch_get_reported_diff_type_change_succeed),
+    cmocka_unit_test(test_az_iot_hub_client_twin_patch_get_reported_diff_small_buffer_fails),
+    cmocka_unit_test(test_az_iot_hub_client_twin_patch_get_reported_diff_not_object_fails),
     cmocka_unit_test(test_az_iot_hub_client_twin_parse_received_topic_desired_found_succeed),
     cmocka_unit_test(test_az_iot_hub_client_twin_parse_received_topic_get_response_found_succeed),
     cmocka_unit_test(test_az_iot_hub_client_twin_parse_received_topic_reported_props_found_succeed),
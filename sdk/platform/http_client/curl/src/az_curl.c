@@ -1,11 +1,16 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
+#include <az_context.h>
 #include <az_http.h>
 #include <az_http_transport.h>
+#include <az_platform_internal.h>
 #include <az_span.h>
 
+#include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <curl/curl.h>
 
@@ -319,37 +324,14 @@ _az_http_client_curl_send_delete_request(CURL* p_curl, _az_http_request const* p
 }
 
 /**
- * handles POST request. It handles seting up a body for request
+ * @brief Position of the upload within the spans of the request body, passed to the read callback.
  */
-static AZ_NODISCARD az_result
-_az_http_client_curl_send_post_request(CURL* p_curl, _az_http_request const* p_request)
+typedef struct
 {
-  _az_PRECONDITION_NOT_NULL(p_curl);
-  _az_PRECONDITION_NOT_NULL(p_request);
-
-  // Method
-  az_span request_body = { 0 };
-  AZ_RETURN_IF_FAILED(az_http_request_get_body(p_request, &request_body));
-  az_span body = { 0 };
-  int32_t const required_length = az_span_size(request_body) + az_span_size(AZ_SPAN_FROM_STR("\0"));
-
-  AZ_RETURN_IF_FAILED(_az_span_malloc(required_length, &body));
-
-  char* b = (char*)az_span_ptr(body);
-  az_span_to_str(b, required_length, request_body);
-
-  az_result res_code
-      = _az_http_client_curl_code_to_result(curl_easy_setopt(p_curl, CURLOPT_POSTFIELDS, b));
-  if (az_succeeded(res_code))
-  {
-    res_code = _az_http_client_curl_code_to_result(curl_easy_perform(p_curl));
-  }
-
-  _az_span_free(&body);
-  AZ_RETURN_IF_FAILED(res_code);
-
-  return AZ_OK;
-}
+  _az_http_request const* request;
+  int32_t span_index;
+  int32_t span_offset;
+} _az_http_client_curl_upload_state;
 
 /**
  * @brief UPLOAD requests are done via callbacks.  The callback is passed in a buffer address which
@@ -357,49 +339,142 @@ _az_http_client_curl_send_post_request(CURL* p_curl, _az_http_request const* p_r
  * more data). The callback will return CURL_READFUNC_ABORT should an error occur.  This in turn
  * terminates the POST request.
  *
+ * The body spans are copied straight into the curl buffer, so a body made of several spans never
+ * needs to be assembled in memory first.
+ *
  * @param dst Destination address buffer
  * @param size Size of an item
  * @param nmemb Number of items to copy
  * @param userdata Source data to upload
- *                 Passed as the pointer to an az_span
+ *                 Passed as the pointer to an _az_http_client_curl_upload_state
  * @return int
  */
-static int32_t _az_http_client_curl_upload_read_callback(
+static size_t _az_http_client_curl_upload_read_callback(
     void* dst,
     size_t size,
     size_t nmemb,
     void* userdata)
 {
-
-  az_span* upload_content = (az_span*)userdata;
+  _az_http_client_curl_upload_state* upload_state = (_az_http_client_curl_upload_state*)userdata;
 
   // Calculate the size of the *dst buffer
-  int32_t dst_buffer_size = (int32_t)(nmemb * size);
+  int32_t const dst_buffer_size = (int32_t)(nmemb * size);
 
   // Terminate the upload if the destination buffer is too small
   if (dst_buffer_size < 1)
     return CURL_READFUNC_ABORT;
 
-  int32_t userdata_length = az_span_size(*upload_content);
+  // Fill as much of the destination buffer as possible, moving on to the next span of the body
+  // whenever the current one has been copied entirely. Returning 0 means the upload is complete.
+  int32_t copied = 0;
+  az_span span;
+  while (copied < dst_buffer_size
+         && az_succeeded(az_http_request_get_body_span(
+             upload_state->request, upload_state->span_index, &span)))
+  {
+    az_span const remaining = az_span_slice_to_end(span, upload_state->span_offset);
+    int32_t const remaining_size = az_span_size(remaining);
+    int32_t const size_of_copy = (remaining_size < dst_buffer_size - copied)
+        ? remaining_size
+        : dst_buffer_size - copied;
+
+    memcpy((uint8_t*)dst + copied, az_span_ptr(remaining), (size_t)size_of_copy);
+    copied += size_of_copy;
+
+    if (size_of_copy == remaining_size)
+    {
+      upload_state->span_index++;
+      upload_state->span_offset = 0;
+    }
+    else
+    {
+      upload_state->span_offset += size_of_copy;
+    }
+  }
+
+  return (size_t)copied;
+}
+
+/**
+ * @brief Moves the upload back to \p offset, which curl asks for when it has to send the body
+ * again, such as after a redirect or an authentication challenge.
+ *
+ * @param userdata The _az_http_client_curl_upload_state of the upload
+ * @param offset Position to move to, from the start of the body
+ * @param origin Only SEEK_SET is supported
+ * @return CURL_SEEKFUNC_OK, or CURL_SEEKFUNC_FAIL if \p offset is not within the body
+ */
+static int _az_http_client_curl_upload_seek_callback(void* userdata, curl_off_t offset, int origin)
+{
+  _az_http_client_curl_upload_state* upload_state = (_az_http_client_curl_upload_state*)userdata;
+
+  if (origin != SEEK_SET || offset < 0
+      || offset > (curl_off_t)az_http_request_body_size(upload_state->request))
+  {
+    return CURL_SEEKFUNC_FAIL;
+  }
 
-  // Return if nothing to copy
-  if (userdata_length < 1)
-    return CURLE_OK; // Success, all bytes copied
+  // Find the span holding the byte at offset.
+  int32_t span_index = 0;
+  int32_t span_offset = (int32_t)offset;
+  az_span span;
+  while (az_succeeded(az_http_request_get_body_span(upload_state->request, span_index, &span))
+         && span_offset >= az_span_size(span))
+  {
+    span_offset -= az_span_size(span);
+    span_index++;
+  }
 
-  // Calculate how many bytes can we copy from customer data (upload_content)
-  // Curl provides dst buffer with a max size of dest_buffer_size, if customer data size is less
-  // than the max, we can copy all customer data directly and have it uploaded at once.
-  // If not, we can only copy the max dst size from customer data and wait for another upload to
-  // copy a next chunk of data
-  int32_t size_of_copy = (userdata_length < dst_buffer_size) ? userdata_length : dst_buffer_size;
+  upload_state->span_index = span_index;
+  upload_state->span_offset = span_offset;
+  return CURL_SEEKFUNC_OK;
+}
+
+/**
+ * @brief Sets the read callback that streams the request body to curl, and the seek callback that
+ * rewinds it.
+ */
+static AZ_NODISCARD az_result _az_http_client_curl_setup_upload(
+    CURL* p_curl,
+    _az_http_client_curl_upload_state* upload_state)
+{
+  AZ_RETURN_IF_CURL_FAILED(
+      curl_easy_setopt(p_curl, CURLOPT_READFUNCTION, _az_http_client_curl_upload_read_callback));
 
-  memcpy(dst, az_span_ptr(*upload_content), (size_t)size_of_copy);
+  // Setup the request to pass body into the read callback
+  // The read callback receives the address of the upload state
+  AZ_RETURN_IF_CURL_FAILED(curl_easy_setopt(p_curl, CURLOPT_READDATA, upload_state));
 
-  // Update the userdata span. If we already copied all content, slice will set upload_content with
-  // 0 length
-  *upload_content = az_span_slice_to_end(*upload_content, size_of_copy);
+  AZ_RETURN_IF_CURL_FAILED(
+      curl_easy_setopt(p_curl, CURLOPT_SEEKFUNCTION, _az_http_client_curl_upload_seek_callback));
+  AZ_RETURN_IF_CURL_FAILED(curl_easy_setopt(p_curl, CURLOPT_SEEKDATA, upload_state));
 
-  return size_of_copy;
+  return AZ_OK;
+}
+
+/**
+ * handles POST request. It handles seting up a body for request
+ */
+static AZ_NODISCARD az_result
+_az_http_client_curl_send_post_request(CURL* p_curl, _az_http_request const* p_request)
+{
+  _az_PRECONDITION_NOT_NULL(p_curl);
+  _az_PRECONDITION_NOT_NULL(p_request);
+
+  _az_http_client_curl_upload_state upload_state = { .request = p_request };
+
+  AZ_RETURN_IF_CURL_FAILED(curl_easy_setopt(p_curl, CURLOPT_POST, 1L));
+  AZ_RETURN_IF_FAILED(_az_http_client_curl_setup_upload(p_curl, &upload_state));
+
+  // Set the size of the body, so that curl does not use chunked encoding
+  AZ_RETURN_IF_CURL_FAILED(curl_easy_setopt(
+      p_curl,
+      CURLOPT_POSTFIELDSIZE_LARGE,
+      (curl_off_t)az_http_request_body_size(p_request)));
+
+  AZ_RETURN_IF_CURL_FAILED(curl_easy_perform(p_curl));
+
+  return AZ_OK;
 }
 
 /**
@@ -412,20 +487,14 @@ _az_http_client_curl_send_upload_request(CURL* p_curl, _az_http_request const* p
   _az_PRECONDITION_NOT_NULL(p_curl);
   _az_PRECONDITION_NOT_NULL(p_request);
 
-  az_span body = { 0 };
-  AZ_RETURN_IF_FAILED(az_http_request_get_body(p_request, &body));
+  _az_http_client_curl_upload_state upload_state = { .request = p_request };
 
   AZ_RETURN_IF_CURL_FAILED(curl_easy_setopt(p_curl, CURLOPT_UPLOAD, 1L));
-  AZ_RETURN_IF_CURL_FAILED(
-      curl_easy_setopt(p_curl, CURLOPT_READFUNCTION, _az_http_client_curl_upload_read_callback));
-
-  // Setup the request to pass body into the read callback
-  // The read callback receives the address of body
-  AZ_RETURN_IF_CURL_FAILED(curl_easy_setopt(p_curl, CURLOPT_READDATA, &body));
+  AZ_RETURN_IF_FAILED(_az_http_client_curl_setup_upload(p_curl, &upload_state));
 
   // Set the size of the upload
-  AZ_RETURN_IF_CURL_FAILED(
-      curl_easy_setopt(p_curl, CURLOPT_INFILESIZE, (curl_off_t)az_span_size(body)));
+  AZ_RETURN_IF_CURL_FAILED(curl_easy_setopt(
+      p_curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)az_http_request_body_size(p_request)));
 
   // Do the curl work
   // curl_easy_perform does not return until the CURLOPT_READFUNCTION callbacks complete.
@@ -533,6 +602,97 @@ _az_http_client_curl_setup_response_redirect(CURL* p_curl, az_http_response* res
   return AZ_OK;
 }
 
+/**
+ * @brief Asks the server to compress the response body, which curl decodes (along with chunked
+ * transfer-encoding) before passing it to the write callback. The response buffer then only needs
+ * to hold the decoded body, while fewer bytes are transferred.
+ *
+ * @param p_curl curl specific structure used to send an http request
+ * @return az_result
+ */
+static AZ_NODISCARD az_result _az_http_client_curl_setup_response_decoding(CURL* p_curl)
+{
+  _az_PRECONDITION_NOT_NULL(p_curl);
+
+  // An empty string sends an Accept-Encoding header listing every encoding this build of curl can
+  // decode (gzip and deflate, when it is built with zlib), so a response never comes back in an
+  // encoding curl can't decode.
+  AZ_RETURN_IF_CURL_FAILED(curl_easy_setopt(p_curl, CURLOPT_ACCEPT_ENCODING, ""));
+
+  return AZ_OK;
+}
+
+/**
+ * @brief Called by curl while the request is being transferred (about once a second when no data
+ * moves) to check whether the context of the request was canceled.
+ *
+ * @return Non-zero to make curl abort the transfer with CURLE_ABORTED_BY_CALLBACK.
+ */
+static int _az_http_client_curl_progress_callback(
+    void* clientp,
+    curl_off_t dltotal,
+    curl_off_t dlnow,
+    curl_off_t ultotal,
+    curl_off_t ulnow)
+{
+  (void)dltotal;
+  (void)dlnow;
+  (void)ultotal;
+  (void)ulnow;
+
+  // This runs many times per transfer, and a cancellation noticed a tick late is fine.
+  az_context const* const context = (az_context const*)clientp;
+  return az_context_has_expired(context, az_platform_clock_coarse_msec()) ? 1 : 0;
+}
+
+/**
+ * @brief Bounds the transfer by the expiration of the context of the request, and polls the context
+ * during the transfer so canceling it aborts the request.
+ *
+ * @param p_curl curl specific structure used to send an http request
+ * @param p_request http builder with the context of the request
+ * @return AZ_ERROR_CANCELED if the context has already expired
+ */
+static AZ_NODISCARD az_result
+_az_http_client_curl_setup_deadline(CURL* p_curl, _az_http_request const* p_request)
+{
+  _az_PRECONDITION_NOT_NULL(p_curl);
+  _az_PRECONDITION_NOT_NULL(p_request);
+
+  az_context const* const context = p_request->_internal.context;
+  if (context == NULL)
+  {
+    return AZ_OK;
+  }
+
+  int64_t const expiration = az_context_get_expiration(context);
+  if (expiration != _az_CONTEXT_MAX_EXPIRATION)
+  {
+    int64_t const remaining_msec = expiration - az_platform_clock_msec();
+    if (remaining_msec <= 0)
+    {
+      return AZ_ERROR_CANCELED;
+    }
+
+    // The total timeout covers name resolution and connecting as well, so the connect timeout
+    // keeps curl's default.
+    long const timeout_msec = remaining_msec < LONG_MAX ? (long)remaining_msec : LONG_MAX;
+    AZ_RETURN_IF_CURL_FAILED(curl_easy_setopt(p_curl, CURLOPT_TIMEOUT_MS, timeout_msec));
+
+    // Without this, the resolver enforces the timeout with SIGALRM and siglongjmp, which is not
+    // safe in a multithreaded application.
+    AZ_RETURN_IF_CURL_FAILED(curl_easy_setopt(p_curl, CURLOPT_NOSIGNAL, 1L));
+  }
+
+  // A context without expiration can still be canceled while the transfer is in progress.
+  AZ_RETURN_IF_CURL_FAILED(curl_easy_setopt(
+      p_curl, CURLOPT_XFERINFOFUNCTION, _az_http_client_curl_progress_callback));
+  AZ_RETURN_IF_CURL_FAILED(curl_easy_setopt(p_curl, CURLOPT_XFERINFODATA, (void*)context));
+  AZ_RETURN_IF_CURL_FAILED(curl_easy_setopt(p_curl, CURLOPT_NOPROGRESS, 0L));
+
+  return AZ_OK;
+}
+
 /**
  * @brief use this method to group all the actions that we do with CURL so we can clean it after it
  * no matter is there is an error at any step.
@@ -553,6 +713,8 @@ static AZ_NODISCARD az_result _az_http_client_curl_send_request_impl_process(
 
   az_result result = AZ_ERROR_ARG;
 
+  AZ_RETURN_IF_FAILED(_az_http_client_curl_setup_deadline(p_curl, p_request));
+
   struct curl_slist* p_list = NULL;
   AZ_RETURN_IF_FAILED(_az_http_client_curl_setup_headers(p_curl, &p_list, p_request));
 
@@ -560,6 +722,8 @@ static AZ_NODISCARD az_result _az_http_client_curl_send_request_impl_process(
 
   AZ_RETURN_IF_FAILED(_az_http_client_curl_setup_response_redirect(p_curl, response));
 
+  AZ_RETURN_IF_FAILED(_az_http_client_curl_setup_response_decoding(p_curl));
+
   az_http_method method;
   AZ_RETURN_IF_FAILED(az_http_request_get_method(p_request, &method));
 
@@ -591,6 +755,16 @@ static AZ_NODISCARD az_result _az_http_client_curl_send_request_impl_process(
   // Clean custom headers previously appended
   curl_slist_free_all(p_list);
 
+  // A transfer cut short by CURLOPT_TIMEOUT_MS fails with CURLE_OPERATION_TIMEDOUT, which is also
+  // what a connect timeout gives, and one aborted by the progress callback fails with
+  // CURLE_ABORTED_BY_CALLBACK, which is also what an upload read error gives. Tell them apart with
+  // the context.
+  if (az_failed(result) && p_request->_internal.context != NULL
+      && az_context_has_expired(p_request->_internal.context, az_platform_clock_msec()))
+  {
+    return AZ_ERROR_CANCELED;
+  }
+
   return result;
 }
 
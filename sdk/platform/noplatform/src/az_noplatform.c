@@ -7,8 +7,21 @@
 
 AZ_NODISCARD int64_t az_platform_clock_msec() { return 0; }
 
+AZ_NODISCARD int64_t az_platform_clock_usec() { return 0; }
+
+AZ_NODISCARD int64_t az_platform_clock_coarse_msec() { return 0; }
+
 void az_platform_sleep_msec(int32_t milliseconds) { (void)milliseconds; }
 
+AZ_NODISCARD int32_t az_platform_wait_msec(az_context const* context, int32_t milliseconds)
+{
+  (void)context;
+  (void)milliseconds;
+  return 0;
+}
+
+void az_platform_wait_notify_all() {}
+
 void az_platform_mtx_destroy(az_platform_mtx* mtx) { *mtx = (az_platform_mtx){ 0 }; }
 
 AZ_NODISCARD az_result az_platform_mtx_init(az_platform_mtx* mtx)
@@ -4,6 +4,8 @@
 #ifndef _az_PLATFORM_IMPL_H
 #define _az_PLATFORM_IMPL_H
 
+#include <az_crypto_internal.h>
+
 #include <pthread.h>
 
 #include <_az_cfg_prefix.h>
@@ -16,6 +18,14 @@ struct az_platform_mtx
   } _internal;
 };
 
+struct az_platform_hmac_sha256_key
+{
+  struct
+  {
+    _az_hmac_sha256_key key;
+  } _internal;
+};
+
 #include <_az_cfg_suffix.h>
 
 #endif // _az_PLATFORM_IMPL_H
@@ -4,6 +4,8 @@
 #include <az_config_internal.h>
 #include <az_platform_internal.h>
 
+#include <pthread.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <time.h>
 
@@ -11,9 +13,41 @@
 
 #include <_az_cfg.h>
 
+// Linux provides a coarse variant of CLOCK_MONOTONIC that the vDSO answers from the last tick,
+// without reading the hardware counter.
+#ifdef CLOCK_MONOTONIC_COARSE
+#define _az_CLOCK_MONOTONIC_COARSE CLOCK_MONOTONIC_COARSE
+#else
+#define _az_CLOCK_MONOTONIC_COARSE CLOCK_MONOTONIC
+#endif
+
+static AZ_NODISCARD int64_t _az_timespec_to_msec(struct timespec const* ts)
+{
+  return (int64_t)ts->tv_sec * _az_TIME_MILLISECONDS_PER_SECOND
+      + ts->tv_nsec / _az_TIME_NANOSECONDS_PER_MILLISECOND;
+}
+
 AZ_NODISCARD int64_t az_platform_clock_msec()
 {
-  return (int64_t)((clock() / CLOCKS_PER_SEC) * _az_TIME_MILLISECONDS_PER_SECOND);
+  struct timespec now;
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return _az_timespec_to_msec(&now);
+}
+
+AZ_NODISCARD int64_t az_platform_clock_usec()
+{
+  struct timespec now;
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * _az_TIME_MILLISECONDS_PER_SECOND
+      * _az_TIME_MICROSECONDS_PER_MILLISECOND
+      + now.tv_nsec / _az_TIME_NANOSECONDS_PER_MICROSECOND;
+}
+
+AZ_NODISCARD int64_t az_platform_clock_coarse_msec()
+{
+  struct timespec now;
+  (void)clock_gettime(_az_CLOCK_MONOTONIC_COARSE, &now);
+  return _az_timespec_to_msec(&now);
 }
 
 void az_platform_sleep_msec(int32_t milliseconds)
@@ -21,6 +55,114 @@ void az_platform_sleep_msec(int32_t milliseconds)
   (void)usleep((useconds_t)milliseconds * _az_TIME_MICROSECONDS_PER_MILLISECOND);
 }
 
+// Every wait shares one condition variable: cancellations are rare, so waking all the waiters and
+// letting each check its own context costs less than tracking who waits on what.
+static pthread_mutex_t _az_wait_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _az_wait_cond;
+static pthread_once_t _az_wait_cond_once = PTHREAD_ONCE_INIT;
+
+static void _az_wait_cond_init()
+{
+  // Time the waits out against the monotonic clock, so changing the wall clock doesn't change them.
+  // macOS has no pthread_condattr_setclock, and waits for a duration instead.
+  pthread_condattr_t attr;
+  (void)pthread_condattr_init(&attr);
+#ifndef __APPLE__
+  (void)pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+#endif
+  (void)pthread_cond_init(&_az_wait_cond, &attr);
+  (void)pthread_condattr_destroy(&attr);
+}
+
+// Waits on the shared condition variable until it is signaled, or until `deadline` on the
+// monotonic clock. Returns non-zero once the deadline has passed.
+static int _az_wait_cond_timedwait(struct timespec const* deadline)
+{
+#ifdef __APPLE__
+  // pthread_cond_timedwait would read the deadline as wall-clock time, so wait for what is left of
+  // it on the monotonic clock.
+  struct timespec now;
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+
+  long const nsec_per_sec
+      = (long)_az_TIME_MILLISECONDS_PER_SECOND * _az_TIME_NANOSECONDS_PER_MILLISECOND;
+  struct timespec remaining = { .tv_sec = deadline->tv_sec - now.tv_sec,
+                                .tv_nsec = deadline->tv_nsec - now.tv_nsec };
+  if (remaining.tv_nsec < 0)
+  {
+    remaining.tv_sec -= 1;
+    remaining.tv_nsec += nsec_per_sec;
+  }
+  if (remaining.tv_sec < 0)
+  {
+    return 1;
+  }
+
+  return pthread_cond_timedwait_relative_np(&_az_wait_cond, &_az_wait_mutex, &remaining);
+#else
+  return pthread_cond_timedwait(&_az_wait_cond, &_az_wait_mutex, deadline);
+#endif
+}
+
+AZ_NODISCARD int32_t az_platform_wait_msec(az_context const* context, int32_t milliseconds)
+{
+  context = (context != NULL) ? context : &az_context_app;
+  int64_t const expiration = az_context_get_expiration(context);
+
+  // Don't wait past the expiration of the context either.
+  int64_t const remaining_msec = expiration - az_platform_clock_msec();
+  if (remaining_msec < milliseconds)
+  {
+    milliseconds = remaining_msec > 0 ? (int32_t)remaining_msec : 0;
+  }
+
+  (void)pthread_once(&_az_wait_cond_once, _az_wait_cond_init);
+
+  struct timespec start;
+  (void)clock_gettime(CLOCK_MONOTONIC, &start);
+
+  long const nsec_per_sec
+      = (long)_az_TIME_MILLISECONDS_PER_SECOND * _az_TIME_NANOSECONDS_PER_MILLISECOND;
+  struct timespec deadline = start;
+  deadline.tv_sec += milliseconds / _az_TIME_MILLISECONDS_PER_SECOND;
+  deadline.tv_nsec += (long)(milliseconds % _az_TIME_MILLISECONDS_PER_SECOND)
+      * _az_TIME_NANOSECONDS_PER_MILLISECOND;
+  if (deadline.tv_nsec >= nsec_per_sec)
+  {
+    deadline.tv_sec += 1;
+    deadline.tv_nsec -= nsec_per_sec;
+  }
+
+  // The context is checked with the mutex held, and az_context_cancel takes it to notify, so a
+  // cancellation can't slip in between the check and the wait.
+  (void)pthread_mutex_lock(&_az_wait_mutex);
+  // Canceling a context moves its expiration back to the beginning of time.
+  while (az_context_get_expiration(context) == expiration
+         && !az_context_has_expired(context, az_platform_clock_msec()))
+  {
+    if (_az_wait_cond_timedwait(&deadline) != 0)
+    {
+      break; // Timed out
+    }
+  }
+  (void)pthread_mutex_unlock(&_az_wait_mutex);
+
+  struct timespec end;
+  (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+  int64_t const waited_msec = _az_timespec_to_msec(&end) - _az_timespec_to_msec(&start);
+  return waited_msec < milliseconds ? (int32_t)waited_msec : milliseconds;
+}
+
+void az_platform_wait_notify_all()
+{
+  (void)pthread_once(&_az_wait_cond_once, _az_wait_cond_init);
+
+  (void)pthread_mutex_lock(&_az_wait_mutex);
+  (void)pthread_cond_broadcast(&_az_wait_cond);
+  (void)pthread_mutex_unlock(&_az_wait_mutex);
+}
+
 void az_platform_mtx_destroy(az_platform_mtx* mtx)
 {
   if (pthread_mutex_destroy(&mtx->_internal.mutex) == 0)
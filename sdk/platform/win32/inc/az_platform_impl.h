@@ -26,6 +26,8 @@
 #endif // NOMINMAX
 #endif // WIN32_LEAN_AND_MEAN
 
+#include <az_crypto_internal.h>
+
 #include <_az_cfg_prefix.h>
 
 struct az_platform_mtx
@@ -36,6 +38,14 @@ struct az_platform_mtx
   } _internal;
 };
 
+struct az_platform_hmac_sha256_key
+{
+  struct
+  {
+    _az_hmac_sha256_key key;
+  } _internal;
+};
+
 #include <_az_cfg_suffix.h>
 
 #endif // _az_PLATFORM_IMPL_H
@@ -1,14 +1,79 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: MIT
 
+#include <az_config_internal.h>
 #include <az_platform_internal.h>
 
 #include <_az_cfg.h>
 
 AZ_NODISCARD int64_t az_platform_clock_msec() { return GetTickCount64(); }
 
+AZ_NODISCARD int64_t az_platform_clock_usec()
+{
+  LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  (void)QueryPerformanceFrequency(&frequency);
+  (void)QueryPerformanceCounter(&counter);
+
+  // Split the conversion so the multiplication doesn't overflow after a long uptime.
+  int64_t const microseconds_per_second
+      = _az_TIME_MILLISECONDS_PER_SECOND * _az_TIME_MICROSECONDS_PER_MILLISECOND;
+  return (counter.QuadPart / frequency.QuadPart) * microseconds_per_second
+      + (counter.QuadPart % frequency.QuadPart) * microseconds_per_second / frequency.QuadPart;
+}
+
+// GetTickCount64 only advances on timer ticks already, which is what makes it cheap.
+AZ_NODISCARD int64_t az_platform_clock_coarse_msec() { return GetTickCount64(); }
+
 void az_platform_sleep_msec(int32_t milliseconds) { Sleep(milliseconds); }
 
+// Every wait shares one condition variable: cancellations are rare, so waking all the waiters and
+// letting each check its own context costs less than tracking who waits on what.
+static SRWLOCK _az_wait_lock = SRWLOCK_INIT;
+static CONDITION_VARIABLE _az_wait_cond = CONDITION_VARIABLE_INIT;
+
+AZ_NODISCARD int32_t az_platform_wait_msec(az_context const* context, int32_t milliseconds)
+{
+  context = (context != NULL) ? context : &az_context_app;
+  int64_t const expiration = az_context_get_expiration(context);
+
+  // Don't wait past the expiration of the context either.
+  int64_t const remaining_msec = expiration - az_platform_clock_msec();
+  if (remaining_msec < milliseconds)
+  {
+    milliseconds = remaining_msec > 0 ? (int32_t)remaining_msec : 0;
+  }
+
+  ULONGLONG const start = GetTickCount64();
+  ULONGLONG const deadline = start + (ULONGLONG)milliseconds;
+
+  // The context is checked with the lock held, and az_context_cancel takes it to notify, so a
+  // cancellation can't slip in between the check and the wait.
+  AcquireSRWLockExclusive(&_az_wait_lock);
+  // Canceling a context moves its expiration back to the beginning of time.
+  while (az_context_get_expiration(context) == expiration
+         && !az_context_has_expired(context, az_platform_clock_msec()))
+  {
+    ULONGLONG const now = GetTickCount64();
+    if (now >= deadline
+        || !SleepConditionVariableSRW(&_az_wait_cond, &_az_wait_lock, (DWORD)(deadline - now), 0))
+    {
+      break; // Timed out
+    }
+  }
+  ReleaseSRWLockExclusive(&_az_wait_lock);
+
+  ULONGLONG const waited_msec = GetTickCount64() - start;
+  return waited_msec < (ULONGLONG)milliseconds ? (int32_t)waited_msec : milliseconds;
+}
+
+void az_platform_wait_notify_all()
+{
+  AcquireSRWLockExclusive(&_az_wait_lock);
+  WakeAllConditionVariable(&_az_wait_cond);
+  ReleaseSRWLockExclusive(&_az_wait_lock);
+}
+
 void az_platform_mtx_destroy(az_platform_mtx* mtx)
 {
   DeleteCriticalSection(&mtx->_internal.cs);
@@ -88,24 +88,11 @@ AZ_NODISCARD az_result az_keyvault_keys_client_init(
 
   *self = (az_keyvault_keys_client) {
     ._internal = {
-      .uri = AZ_SPAN_FROM_BUFFER(self->_internal.url_buffer),
       .options = *options,
       .credential = cred,
       .pipeline = (_az_http_pipeline){
         ._internal = {
           .p_policies = {
-            {
-              ._internal = {
-                .process = az_http_pipeline_policy_apiversion,
-                .p_options= &self->_internal.options._internal.api_version,
-              },
-            },
-            {
-              ._internal = {
-                .process = az_http_pipeline_policy_telemetry,
-                .p_options = &self->_internal.options._internal._telemetry_options,
-              },
-            },
             {
               ._internal = {
                 .process = az_http_pipeline_policy_retry,
@@ -136,11 +123,18 @@ AZ_NODISCARD az_result az_keyvault_keys_client_init(
     }
   };
 
-  // Copy url to client buffer so customer can re-use buffer on his/her side
-  int32_t uri_size = az_span_size(uri);
-  AZ_RETURN_IF_NOT_ENOUGH_SIZE(self->_internal.uri, uri_size);
-  az_span_copy(self->_internal.uri, uri);
-  self->_internal.uri = az_span_slice(self->_internal.uri, 0, uri_size);
+  // Render url and static headers into client buffers so customer can re-use buffer on his/her
+  // side, and so that the api version and telemetry are not added by a policy on every call
+  _az_http_request_template* request_template = &self->_internal.request_template;
+  AZ_RETURN_IF_FAILED(_az_http_request_template_init(
+      request_template,
+      AZ_SPAN_FROM_BUFFER(self->_internal.url_buffer),
+      uri,
+      AZ_SPAN_FROM_BUFFER(self->_internal.headers_buffer)));
+  AZ_RETURN_IF_FAILED(_az_http_request_template_add_apiversion(
+      request_template, &self->_internal.options._internal.api_version));
+  AZ_RETURN_IF_FAILED(_az_http_request_template_add_telemetry(
+      request_template, &self->_internal.options._internal._telemetry_options));
 
   AZ_RETURN_IF_FAILED(
       _az_credential_set_scopes(cred, AZ_SPAN_FROM_STR("https://vault.azure.net/.default")));
@@ -240,10 +234,6 @@ AZ_NODISCARD az_result az_keyvault_keys_key_create(
   // Url buffer
   uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUF_SIZE];
   az_span request_url_span = AZ_SPAN_FROM_BUFFER(url_buffer);
-  // copy url from client
-  int32_t uri_size = az_span_size(client->_internal.uri);
-  AZ_RETURN_IF_NOT_ENOUGH_SIZE(request_url_span, uri_size);
-  az_span_copy(request_url_span, client->_internal.uri);
 
   // Headers buffer
   uint8_t headers_buffer[_az_KEYVAULT_HTTP_REQUEST_HEADER_BUF_SIZE];
@@ -258,14 +248,14 @@ AZ_NODISCARD az_result az_keyvault_keys_key_create(
 
   // create request
   _az_http_request hrb;
-  AZ_RETURN_IF_FAILED(az_http_request_init(
+  AZ_RETURN_IF_FAILED(_az_http_request_init_from_template(
       &hrb,
       context,
       az_http_method_post(),
       request_url_span,
-      uri_size,
       request_headers_span,
-      created_body));
+      created_body,
+      &client->_internal.request_template));
 
   // add path to request
   AZ_RETURN_IF_FAILED(az_http_request_append_path(&hrb, az_keyvault_client_constant_for_keys()));
@@ -307,21 +297,17 @@ AZ_NODISCARD az_result az_keyvault_keys_key_get(
   // Url buffer
   uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUF_SIZE];
   az_span request_url_span = AZ_SPAN_FROM_BUFFER(url_buffer);
-  // copy url from client
-  int32_t uri_size = az_span_size(client->_internal.uri);
-  AZ_RETURN_IF_NOT_ENOUGH_SIZE(request_url_span, uri_size);
-  az_span_copy(request_url_span, client->_internal.uri);
 
   // create request
   _az_http_request hrb;
-  AZ_RETURN_IF_FAILED(az_http_request_init(
+  AZ_RETURN_IF_FAILED(_az_http_request_init_from_template(
       &hrb,
       context,
       az_http_method_get(),
       request_url_span,
-      uri_size,
       request_headers_span,
-      AZ_SPAN_NULL));
+      AZ_SPAN_NULL,
+      &client->_internal.request_template));
 
   // Add path to request
   AZ_RETURN_IF_FAILED(az_http_request_append_path(&hrb, az_keyvault_client_constant_for_keys()));
@@ -349,10 +335,6 @@ AZ_NODISCARD az_result az_keyvault_keys_key_delete(
   // Url buffer
   uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUF_SIZE];
   az_span request_url_span = AZ_SPAN_FROM_BUFFER(url_buffer);
-  // copy url from client
-  int32_t uri_size = az_span_size(client->_internal.uri);
-  AZ_RETURN_IF_NOT_ENOUGH_SIZE(request_url_span, uri_size);
-  az_span_copy(request_url_span, client->_internal.uri);
 
   uint8_t headers_buffer[_az_KEYVAULT_HTTP_REQUEST_HEADER_BUF_SIZE];
   az_span request_headers_span = AZ_SPAN_FROM_BUFFER(headers_buffer);
@@ -360,14 +342,14 @@ AZ_NODISCARD az_result az_keyvault_keys_key_delete(
   // create request
   // TODO: define max URL size
   _az_http_request hrb;
-  AZ_RETURN_IF_FAILED(az_http_request_init(
+  AZ_RETURN_IF_FAILED(_az_http_request_init_from_template(
       &hrb,
       context,
       az_http_method_delete(),
       request_url_span,
-      uri_size,
       request_headers_span,
-      AZ_SPAN_NULL));
+      AZ_SPAN_NULL,
+      &client->_internal.request_template));
 
   // Add path to request
   AZ_RETURN_IF_FAILED(az_http_request_append_path(&hrb, az_keyvault_client_constant_for_keys()));
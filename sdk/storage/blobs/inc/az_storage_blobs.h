@@ -18,6 +18,12 @@
 
 static az_span const AZ_STORAGE_API_VERSION = AZ_SPAN_LITERAL_FROM_STR("2019-02-02");
 
+enum
+{
+  // x-ms-version and User-Agent
+  _az_STORAGE_BLOBS_TEMPLATE_HEADERS_BUF_SIZE = 2 * sizeof(az_pair),
+};
+
 typedef struct
 {
   az_http_policy_retry_options retry;
@@ -32,10 +38,11 @@ typedef struct
 {
   struct
   {
-    // buffer to copy customer url. Then it stays immutable
+    // buffers to render the customer url and the static headers once. Then they stay immutable
     uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUF_SIZE];
-    // this url will point to url_buffer
-    az_span uri;
+    uint8_t headers_buffer[_az_STORAGE_BLOBS_TEMPLATE_HEADERS_BUF_SIZE];
+    // this template points to url_buffer and headers_buffer
+    _az_http_request_template request_template;
     _az_http_pipeline pipeline;
     az_storage_blobs_blob_client_options options;
     _az_credential* credential;
@@ -66,24 +66,11 @@ AZ_NODISCARD az_result az_storage_blobs_blob_client_init(
 
   *client = (az_storage_blobs_blob_client) {
     ._internal = {
-      .uri = AZ_SPAN_FROM_BUFFER(client->_internal.url_buffer),
       .options = *options,
       .credential = cred,
       .pipeline = (_az_http_pipeline){
         ._internal = {
           .p_policies = {
-            {
-              ._internal = {
-                .process = az_http_pipeline_policy_apiversion,
-                .p_options= &client->_internal.options._internal.api_version,
-              },
-            },
-            {
-              ._internal = {
-                .process = az_http_pipeline_policy_telemetry,
-                .p_options = &client->_internal.options._internal._telemetry_options,
-              },
-            },
             {
               ._internal = {
                 .process = az_http_pipeline_policy_retry,
@@ -114,11 +101,18 @@ AZ_NODISCARD az_result az_storage_blobs_blob_client_init(
     }
   };
 
-  // Copy url to client buffer so customer can re-use buffer on his/her side
-  int32_t uri_size = az_span_size(uri);
-  AZ_RETURN_IF_NOT_ENOUGH_SIZE(client->_internal.uri, uri_size);
-  az_span_copy(client->_internal.uri, uri);
-  client->_internal.uri = az_span_slice(client->_internal.uri, 0, uri_size);
+  // Render url and static headers into client buffers so customer can re-use buffer on his/her
+  // side, and so that the api version and telemetry are not added by a policy on every call
+  _az_http_request_template* request_template = &client->_internal.request_template;
+  AZ_RETURN_IF_FAILED(_az_http_request_template_init(
+      request_template,
+      AZ_SPAN_FROM_BUFFER(client->_internal.url_buffer),
+      uri,
+      AZ_SPAN_FROM_BUFFER(client->_internal.headers_buffer)));
+  AZ_RETURN_IF_FAILED(_az_http_request_template_add_apiversion(
+      request_template, &client->_internal.options._internal.api_version));
+  AZ_RETURN_IF_FAILED(_az_http_request_template_add_telemetry(
+      request_template, &client->_internal.options._internal._telemetry_options));
 
   AZ_RETURN_IF_FAILED(
       _az_credential_set_scopes(cred, AZ_SPAN_FROM_STR("https://storage.azure.com/.default")));
@@ -149,24 +143,20 @@ AZ_NODISCARD az_result az_storage_blobs_blob_upload(
   // create request buffer TODO: define size for a blob upload
   uint8_t url_buffer[AZ_HTTP_REQUEST_URL_BUF_SIZE];
   az_span request_url_span = AZ_SPAN_FROM_BUFFER(url_buffer);
-  // copy url from client
-  int32_t uri_size = az_span_size(client->_internal.uri);
-  AZ_RETURN_IF_NOT_ENOUGH_SIZE(request_url_span, uri_size);
-  az_span_copy(request_url_span, client->_internal.uri);
 
   uint8_t headers_buffer[_az_STORAGE_HTTP_REQUEST_HEADER_BUF_SIZE];
   az_span request_headers_span = AZ_SPAN_FROM_BUFFER(headers_buffer);
 
   // create request
   _az_http_request hrb;
-  AZ_RETURN_IF_FAILED(az_http_request_init(
+  AZ_RETURN_IF_FAILED(_az_http_request_init_from_template(
       &hrb,
       context,
       az_http_method_put(),
       request_url_span,
-      uri_size,
       request_headers_span,
-      content));
+      content,
+      &client->_internal.request_template));
 
   // add blob type to request
   AZ_RETURN_IF_FAILED(az_http_request_append_header(